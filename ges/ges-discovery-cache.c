@@ -0,0 +1,242 @@
+/* GStreamer Editing Services
+ * Copyright (C) 2011 The GStreamer Editing Services authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Persistent cache of discovery results.
+ *
+ * The results of discovering a #GESTimelineFileSource uri (the stream types,
+ * the duration and whether it is a still image) are stored in a #GKeyFile
+ * located in the user cache directory. Each entry is keyed by the uri and
+ * is only considered valid if the size and modification time of the file
+ * still match the ones recorded when the entry was stored.
+ *
+ * Only local (file://) uris are cached, since we have no cheap way of
+ * validating remote resources. */
+
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#include "ges-internal.h"
+
+#define CACHE_GROUP_PREFIX "uri "
+#define CACHE_FILENAME "discovery-cache"
+
+G_LOCK_DEFINE_STATIC (cache_lock);
+static GKeyFile *cache = NULL;
+static gchar *cache_path = NULL;
+static gboolean cache_dirty = FALSE;
+
+/* Must be called with the cache_lock taken */
+static void
+ensure_cache (void)
+{
+  GError *error = NULL;
+
+  if (G_LIKELY (cache))
+    return;
+
+  cache = g_key_file_new ();
+  cache_path = g_build_filename (g_get_user_cache_dir (),
+      "gstreamer-editing-services", CACHE_FILENAME, NULL);
+
+  if (!g_key_file_load_from_file (cache, cache_path, G_KEY_FILE_NONE, &error)) {
+    GST_DEBUG ("Could not load discovery cache from %s: %s", cache_path,
+        error->message);
+    g_error_free (error);
+  }
+}
+
+static gboolean
+get_file_stats (const gchar * uri, guint64 * size, gint64 * mtime)
+{
+  gchar *filename;
+  struct stat st;
+  gboolean ret = FALSE;
+
+  if (!g_str_has_prefix (uri, "file://"))
+    return FALSE;
+
+  if (!(filename = g_filename_from_uri (uri, NULL, NULL)))
+    return FALSE;
+
+  if (g_stat (filename, &st) == 0) {
+    *size = (guint64) st.st_size;
+    *mtime = (gint64) st.st_mtime;
+    ret = TRUE;
+  }
+
+  g_free (filename);
+
+  return ret;
+}
+
+static guint64
+get_uint64 (const gchar * group, const gchar * key, gboolean * valid)
+{
+  gchar *str;
+  guint64 ret = 0;
+
+  if (!(str = g_key_file_get_value (cache, group, key, NULL))) {
+    *valid = FALSE;
+    return 0;
+  }
+
+  ret = g_ascii_strtoull (str, NULL, 10);
+  g_free (str);
+
+  return ret;
+}
+
+static void
+set_uint64 (const gchar * group, const gchar * key, guint64 value)
+{
+  gchar *str = g_strdup_printf ("%" G_GUINT64_FORMAT, value);
+
+  g_key_file_set_value (cache, group, key, str);
+  g_free (str);
+}
+
+/**
+ * ges_discovery_cache_lookup:
+ * @uri: the uri to look up
+ * @formats: (out): the #GESTrackType discovered for @uri
+ * @duration: (out): the discovered duration of @uri
+ * @is_image: (out): whether @uri is a still image
+ *
+ * Returns: TRUE if a valid entry was found for @uri, else FALSE.
+ */
+gboolean
+ges_discovery_cache_lookup (const gchar * uri, GESTrackType * formats,
+    guint64 * duration, gboolean * is_image)
+{
+  gchar *group;
+  guint64 size, csize;
+  gint64 mtime, cmtime;
+  gboolean valid = TRUE;
+
+  if (!get_file_stats (uri, &size, &mtime))
+    return FALSE;
+
+  group = g_strconcat (CACHE_GROUP_PREFIX, uri, NULL);
+
+  G_LOCK (cache_lock);
+  ensure_cache ();
+
+  if (!g_key_file_has_group (cache, group)) {
+    valid = FALSE;
+    goto done;
+  }
+
+  csize = get_uint64 (group, "size", &valid);
+  cmtime = (gint64) get_uint64 (group, "mtime", &valid);
+  *formats = (GESTrackType) get_uint64 (group, "formats", &valid);
+  *duration = get_uint64 (group, "duration", &valid);
+  *is_image = g_key_file_get_boolean (cache, group, "is-image", NULL);
+
+  if (valid && (csize != size || cmtime != mtime)) {
+    GST_DEBUG ("Stale discovery cache entry for %s", uri);
+    g_key_file_remove_group (cache, group, NULL);
+    cache_dirty = TRUE;
+    valid = FALSE;
+  }
+
+done:
+  G_UNLOCK (cache_lock);
+  g_free (group);
+
+  GST_LOG ("uri:%s, found:%d", uri, valid);
+
+  return valid;
+}
+
+/**
+ * ges_discovery_cache_store:
+ * @uri: the discovered uri
+ * @formats: the #GESTrackType discovered for @uri
+ * @duration: the discovered duration of @uri
+ * @is_image: whether @uri is a still image
+ *
+ * Records the discovery results for @uri. Entries are only written to disk
+ * on the next call to ges_discovery_cache_save().
+ */
+void
+ges_discovery_cache_store (const gchar * uri, GESTrackType formats,
+    guint64 duration, gboolean is_image)
+{
+  gchar *group;
+  guint64 size;
+  gint64 mtime;
+
+  if (!get_file_stats (uri, &size, &mtime))
+    return;
+
+  group = g_strconcat (CACHE_GROUP_PREFIX, uri, NULL);
+
+  G_LOCK (cache_lock);
+  ensure_cache ();
+
+  set_uint64 (group, "size", size);
+  set_uint64 (group, "mtime", (guint64) mtime);
+  set_uint64 (group, "formats", (guint64) formats);
+  set_uint64 (group, "duration", duration);
+  g_key_file_set_boolean (cache, group, "is-image", is_image);
+  cache_dirty = TRUE;
+
+  G_UNLOCK (cache_lock);
+  g_free (group);
+}
+
+/**
+ * ges_discovery_cache_save:
+ *
+ * Writes the discovery cache to disk if it was modified.
+ */
+void
+ges_discovery_cache_save (void)
+{
+  gchar *data, *dirname;
+  gsize length;
+  GError *error = NULL;
+
+  G_LOCK (cache_lock);
+
+  if (!cache || !cache_dirty)
+    goto done;
+
+  dirname = g_path_get_dirname (cache_path);
+  if (g_mkdir_with_parents (dirname, 0755) != 0) {
+    GST_WARNING ("Could not create discovery cache directory %s", dirname);
+    g_free (dirname);
+    goto done;
+  }
+  g_free (dirname);
+
+  data = g_key_file_to_data (cache, &length, NULL);
+  if (!g_file_set_contents (cache_path, data, length, &error)) {
+    GST_WARNING ("Could not save discovery cache to %s: %s", cache_path,
+        error->message);
+    g_error_free (error);
+  } else
+    cache_dirty = FALSE;
+  g_free (data);
+
+done:
+  G_UNLOCK (cache_lock);
+}
@@ -0,0 +1,216 @@
+/* GStreamer Editing Services
+ * Copyright (C) 2011 The GStreamer Editing Services authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Recycling pool of track object elements.
+ *
+ * The elements a #GESTrackObject creates in its 'create_element' vmethod are
+ * handed to the pool, in the NULL state, when the object releases its
+ * contents or leaves its track. The next object of the same type asking for
+ * an element with the same configuration key then gets that element back
+ * instead of building an identical one from scratch.
+ *
+ * Idle elements are kept in least recently used order and the oldest ones
+ * are dropped once there are more than the maximum size of the pool. */
+
+#include "ges-internal.h"
+#include "ges-utils.h"
+
+#define DEFAULT_MAX_SIZE 32
+
+typedef struct
+{
+  gchar *key;
+  GstElement *element;
+} PoolEntry;
+
+G_LOCK_DEFINE_STATIC (pool_lock);
+static GHashTable *pool = NULL; /* key => GQueue of PoolEntry, newest first */
+static GQueue lru = G_QUEUE_INIT;       /* PoolEntry, newest first */
+static guint max_size = DEFAULT_MAX_SIZE;
+static guint64 hits = 0, misses = 0;
+
+static gchar *
+make_key (GType type, const gchar * key)
+{
+  return g_strdup_printf ("%s:%s", g_type_name (type), key ? key : "");
+}
+
+static void
+free_entry (PoolEntry * entry)
+{
+  gst_object_unref (entry->element);
+  g_free (entry->key);
+  g_slice_free (PoolEntry, entry);
+}
+
+/* Must be called with the pool_lock taken */
+static void
+remove_from_key (PoolEntry * entry)
+{
+  GQueue *queue = g_hash_table_lookup (pool, entry->key);
+
+  g_queue_remove (queue, entry);
+  if (g_queue_is_empty (queue))
+    g_hash_table_remove (pool, entry->key);
+}
+
+/* Must be called with the pool_lock taken */
+static void
+trim (guint size)
+{
+  PoolEntry *entry;
+
+  while (lru.length > size) {
+    entry = g_queue_pop_tail (&lru);
+    GST_DEBUG ("Dropping %" GST_PTR_FORMAT " (%s)", entry->element,
+        entry->key);
+    remove_from_key (entry);
+    free_entry (entry);
+  }
+}
+
+/* Returns: (transfer full): an idle element of @type created for the
+ * configuration @key, or %NULL if there is none */
+GstElement *
+ges_element_pool_acquire (GType type, const gchar * key)
+{
+  GstElement *element = NULL;
+  PoolEntry *entry;
+  GQueue *queue;
+  gchar *fullkey = make_key (type, key);
+
+  G_LOCK (pool_lock);
+  if (pool && (queue = g_hash_table_lookup (pool, fullkey))) {
+    entry = g_queue_peek_head (queue);
+    remove_from_key (entry);
+    g_queue_remove (&lru, entry);
+
+    element = entry->element;
+    entry->element = NULL;
+    g_free (entry->key);
+    g_slice_free (PoolEntry, entry);
+    hits++;
+  } else {
+    misses++;
+  }
+  G_UNLOCK (pool_lock);
+
+  GST_DEBUG ("%s: %" GST_PTR_FORMAT, fullkey, element);
+  g_free (fullkey);
+
+  return element;
+}
+
+/* Hands the unparented @element (transfer full) to the pool, for the next
+ * object of @type with the configuration @key */
+void
+ges_element_pool_release (GType type, const gchar * key, GstElement * element)
+{
+  PoolEntry *entry;
+  GQueue *queue;
+
+  g_return_if_fail (GST_OBJECT_PARENT (element) == NULL);
+
+  gst_element_set_state (element, GST_STATE_NULL);
+
+  entry = g_slice_new (PoolEntry);
+  entry->key = make_key (type, key);
+  entry->element = element;
+
+  GST_DEBUG ("%s: %" GST_PTR_FORMAT, entry->key, element);
+
+  G_LOCK (pool_lock);
+  if (max_size == 0) {
+    G_UNLOCK (pool_lock);
+    free_entry (entry);
+    return;
+  }
+
+  if (G_UNLIKELY (pool == NULL))
+    pool = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) g_queue_free);
+
+  if (!(queue = g_hash_table_lookup (pool, entry->key))) {
+    queue = g_queue_new ();
+    g_hash_table_insert (pool, g_strdup (entry->key), queue);
+  }
+  g_queue_push_head (queue, entry);
+  g_queue_push_head (&lru, entry);
+
+  trim (max_size);
+  G_UNLOCK (pool_lock);
+}
+
+/**
+ * ges_element_pool_set_max_size:
+ * @size: the maximum number of idle elements to keep, 0 to disable recycling
+ *
+ * Sets how many elements released by track objects are kept around to be
+ * reused by other track objects of the same type and configuration. When
+ * there are more, the least recently released ones are destroyed.
+ */
+void
+ges_element_pool_set_max_size (guint size)
+{
+  GST_DEBUG ("size:%u", size);
+
+  G_LOCK (pool_lock);
+  max_size = size;
+  if (pool)
+    trim (max_size);
+  G_UNLOCK (pool_lock);
+}
+
+/**
+ * ges_element_pool_get_max_size:
+ *
+ * Get the maximum number of idle elements kept for recycling. See
+ * ges_element_pool_set_max_size().
+ *
+ * Returns: the maximum number of idle elements kept for recycling.
+ */
+guint
+ges_element_pool_get_max_size (void)
+{
+  return max_size;
+}
+
+/**
+ * ges_element_pool_get_stats:
+ * @n_hits: (out) (allow-none): the number of elements that were reused
+ * @n_misses: (out) (allow-none): the number of elements that had to be
+ * created because no matching one was available
+ * @n_idle: (out) (allow-none): the number of elements currently waiting to
+ * be reused
+ *
+ * Get statistics about the recycling of the elements of track objects.
+ */
+void
+ges_element_pool_get_stats (guint64 * n_hits, guint64 * n_misses,
+    guint * n_idle)
+{
+  G_LOCK (pool_lock);
+  if (n_hits)
+    *n_hits = hits;
+  if (n_misses)
+    *n_misses = misses;
+  if (n_idle)
+    *n_idle = lru.length;
+  G_UNLOCK (pool_lock);
+}
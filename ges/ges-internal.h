@@ -22,8 +22,99 @@
 #define __GES_INTERNAL_H__
 
 #include <gst/gst.h>
+#include "ges-enums.h"
+#include "ges-types.h"
 
 GST_DEBUG_CATEGORY_EXTERN (_ges_debug);
 #define GST_CAT_DEFAULT _ges_debug
 
+/* Persistent discovery cache (ges-discovery-cache.c) */
+gboolean ges_discovery_cache_lookup (const gchar * uri, GESTrackType * formats,
+    guint64 * duration, gboolean * is_image);
+void ges_discovery_cache_store (const gchar * uri, GESTrackType formats,
+    guint64 duration, gboolean is_image);
+void ges_discovery_cache_save (void);
+
+/* Interval tree indexing objects by time (ges-interval-tree.c) */
+typedef struct _GESIntervalTree GESIntervalTree;
+
+GESIntervalTree *ges_interval_tree_new (void);
+void ges_interval_tree_free (GESIntervalTree * tree);
+void ges_interval_tree_insert (GESIntervalTree * tree, gpointer data,
+    guint64 start, guint64 duration);
+gboolean ges_interval_tree_remove (GESIntervalTree * tree, gpointer data);
+void ges_interval_tree_update (GESIntervalTree * tree, gpointer data,
+    guint64 start, guint64 duration);
+GList *ges_interval_tree_query (GESIntervalTree * tree, guint64 start,
+    guint64 end);
+gboolean ges_interval_tree_lookup (GESIntervalTree * tree, gpointer data,
+    guint64 * start, guint64 * end);
+
+/* Recycling pool of track object elements (ges-element-pool.c) */
+GstElement *ges_element_pool_acquire (GType type, const gchar * key);
+void ges_element_pool_release (GType type, const gchar * key,
+    GstElement * element);
+
+/* Lets the elements of a track object class be recycled. @get_key returns
+ * (transfer full) the configuration an element is created for, @reuse is
+ * called with a recycled element before it gets used and with %NULL when
+ * the element is taken away from the object. */
+typedef gchar *(*GESRecycleKeyFunc) (GESTrackObject * object);
+typedef void (*GESRecycleFunc) (GESTrackObject * object, GstElement * element);
+
+void ges_track_object_class_set_recycle_funcs (GESTrackObjectClass * klass,
+    GESRecycleKeyFunc get_key, GESRecycleFunc reuse);
+
+/* Recycling of the bins built around a textoverlay, shared by the text
+ * overlays and the title sources (ges-track-text-overlay.c) */
+gchar *ges_text_overlay_recycle_key (const gchar * font_desc);
+GstElement *ges_text_overlay_reuse (GstElement * bin, const gchar * name,
+    const gchar * text, GESTextHAlign halign, GESTextVAlign valign);
+
+/* Applies all the timing properties of a track object at once
+ * (ges-track-object.c) */
+void ges_track_object_set_timing (GESTrackObject * object, guint64 start,
+    guint64 inpoint, guint64 duration, guint32 priority);
+
+/* Creates and releases the contents of the gnlobject of a track object
+ * (ges-track-object.c) */
+gboolean ges_track_object_materialize (GESTrackObject * object);
+void ges_track_object_release_contents (GESTrackObject * object);
+gboolean ges_track_object_contents_outdated (GESTrackObject * object);
+
+/* Whether an operation plays over a track object, as cached by its track:
+ * -1 if unknown, else TRUE or FALSE (ges-track-object.c) */
+gint ges_track_object_get_covered (GESTrackObject * object);
+void ges_track_object_set_covered (GESTrackObject * object, gint covered);
+
+/* Window of track objects having their contents (ges-track.c) */
+gboolean ges_track_is_in_window (GESTrack * track, GESTrackObject * object);
+void ges_track_object_moved (GESTrack * track, GESTrackObject * object);
+
+/* Converts the output of a source to the restriction caps of a track
+ * (ges-track.c) */
+GstElement *ges_track_create_restriction_filter (GESTrack * track);
+
+/* Caps a source should decode to, for compressed passthrough (ges-track.c) */
+GstCaps *ges_track_get_decoding_caps (GESTrack * track,
+    GESTrackObject * object);
+
+/* Proxies of the file sources, used when previewing (ges-proxy-cache.c) */
+gchar *ges_proxy_cache_request (const gchar * uri);
+void ges_proxy_cache_watch (GESTrack * track);
+void ges_proxy_cache_unwatch (GESTrack * track);
+void ges_track_proxy_ready (GESTrack * track, const gchar * uri);
+
+/* Persistent cache of thumbnails (ges-thumbnail-cache.c) */
+gchar *ges_thumbnail_cache_make_key (GESTimeline * timeline, guint64 position,
+    gboolean use_proxies, const gchar * format, const gchar * extra);
+gboolean ges_thumbnail_cache_lookup (const gchar * key, gchar ** data,
+    gsize * size);
+void ges_thumbnail_cache_store (const gchar * key, const gchar * data,
+    gsize size);
+
+/* Keeps the time index of @layer in sync when @object moves */
+void ges_timeline_layer_object_time_changed (GESTimelineLayer * layer,
+    GESTimelineObject * object);
+
 #endif /* __GES_INTERNAL_H__ */
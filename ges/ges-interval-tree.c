@@ -0,0 +1,271 @@
+/* GStreamer Editing Services
+ * Copyright (C) 2011 The GStreamer Editing Services authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Interval tree used to index the objects of a layer or a track by time.
+ *
+ * This is a treap ordered by (start, data) where each node additionally
+ * stores the highest end of its subtree. Inserting and removing an interval
+ * costs O(log n) on average, and looking up the k intervals overlapping a
+ * given range costs O(log n + k).
+ *
+ * Nodes are also stored in a hash table keyed by their data, so that an
+ * interval can be removed without knowing the start it was inserted with. */
+
+#include "ges-internal.h"
+
+typedef struct _GESIntervalNode GESIntervalNode;
+
+struct _GESIntervalNode
+{
+  gpointer data;
+  guint64 start, end;
+  guint64 max_end;              /* The highest end in this subtree */
+  guint32 prio;                 /* Random heap priority of the treap */
+
+  GESIntervalNode *left, *right;
+};
+
+struct _GESIntervalTree
+{
+  GESIntervalNode *root;
+  GHashTable *nodes;            /* data => GESIntervalNode */
+};
+
+static gint
+node_compare (GESIntervalNode * a, GESIntervalNode * b)
+{
+  if (a->start < b->start)
+    return -1;
+  if (a->start > b->start)
+    return 1;
+  if (a->data < b->data)
+    return -1;
+  if (a->data > b->data)
+    return 1;
+  return 0;
+}
+
+static void
+node_update (GESIntervalNode * node)
+{
+  node->max_end = node->end;
+  if (node->left && node->left->max_end > node->max_end)
+    node->max_end = node->left->max_end;
+  if (node->right && node->right->max_end > node->max_end)
+    node->max_end = node->right->max_end;
+}
+
+static GESIntervalNode *
+rotate_right (GESIntervalNode * node)
+{
+  GESIntervalNode *left = node->left;
+
+  node->left = left->right;
+  left->right = node;
+  node_update (node);
+  node_update (left);
+
+  return left;
+}
+
+static GESIntervalNode *
+rotate_left (GESIntervalNode * node)
+{
+  GESIntervalNode *right = node->right;
+
+  node->right = right->left;
+  right->left = node;
+  node_update (node);
+  node_update (right);
+
+  return right;
+}
+
+static GESIntervalNode *
+node_insert (GESIntervalNode * root, GESIntervalNode * node)
+{
+  if (root == NULL)
+    return node;
+
+  if (node_compare (node, root) < 0) {
+    root->left = node_insert (root->left, node);
+    if (root->left->prio > root->prio)
+      return rotate_right (root);
+  } else {
+    root->right = node_insert (root->right, node);
+    if (root->right->prio > root->prio)
+      return rotate_left (root);
+  }
+
+  node_update (root);
+  return root;
+}
+
+/* Merges two subtrees, all the nodes of @left being before those of @right */
+static GESIntervalNode *
+node_merge (GESIntervalNode * left, GESIntervalNode * right)
+{
+  if (left == NULL)
+    return right;
+  if (right == NULL)
+    return left;
+
+  if (left->prio > right->prio) {
+    left->right = node_merge (left->right, right);
+    node_update (left);
+    return left;
+  }
+
+  right->left = node_merge (left, right->left);
+  node_update (right);
+  return right;
+}
+
+static GESIntervalNode *
+node_remove (GESIntervalNode * root, GESIntervalNode * node)
+{
+  gint cmp;
+
+  if (root == NULL)
+    return NULL;
+
+  if (root == node)
+    return node_merge (root->left, root->right);
+
+  cmp = node_compare (node, root);
+  if (cmp < 0)
+    root->left = node_remove (root->left, node);
+  else
+    root->right = node_remove (root->right, node);
+
+  node_update (root);
+  return root;
+}
+
+/* Prepends to @ret, in reverse start order, the data of the nodes of the
+ * subtree that play at some point between @start and @end (included) */
+static GList *
+node_query (GESIntervalNode * node, guint64 start, guint64 end, GList * ret)
+{
+  /* Nothing in this subtree ends after @start */
+  if (node == NULL || node->max_end <= start)
+    return ret;
+
+  ret = node_query (node->left, start, end, ret);
+
+  /* This node and its right subtree only start after @end */
+  if (node->start > end)
+    return ret;
+
+  if (node->end > start)
+    ret = g_list_prepend (ret, node->data);
+
+  return node_query (node->right, start, end, ret);
+}
+
+GESIntervalTree *
+ges_interval_tree_new (void)
+{
+  GESIntervalTree *tree = g_slice_new0 (GESIntervalTree);
+
+  tree->nodes = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  return tree;
+}
+
+static void
+free_node (gpointer key, GESIntervalNode * node, gpointer user_data)
+{
+  g_slice_free (GESIntervalNode, node);
+}
+
+void
+ges_interval_tree_free (GESIntervalTree * tree)
+{
+  g_hash_table_foreach (tree->nodes, (GHFunc) free_node, NULL);
+  g_hash_table_destroy (tree->nodes);
+  g_slice_free (GESIntervalTree, tree);
+}
+
+void
+ges_interval_tree_insert (GESIntervalTree * tree, gpointer data,
+    guint64 start, guint64 duration)
+{
+  GESIntervalNode *node;
+
+  g_return_if_fail (g_hash_table_lookup (tree->nodes, data) == NULL);
+
+  node = g_slice_new0 (GESIntervalNode);
+  node->data = data;
+  node->start = start;
+  /* Clamp the end so we don't wrap around on huge durations */
+  node->end = (duration > G_MAXUINT64 - start) ? G_MAXUINT64 : start + duration;
+  node->max_end = node->end;
+  node->prio = g_random_int ();
+
+  tree->root = node_insert (tree->root, node);
+  g_hash_table_insert (tree->nodes, data, node);
+}
+
+gboolean
+ges_interval_tree_remove (GESIntervalTree * tree, gpointer data)
+{
+  GESIntervalNode *node;
+
+  node = g_hash_table_lookup (tree->nodes, data);
+  if (node == NULL)
+    return FALSE;
+
+  tree->root = node_remove (tree->root, node);
+  g_hash_table_remove (tree->nodes, data);
+  g_slice_free (GESIntervalNode, node);
+
+  return TRUE;
+}
+
+void
+ges_interval_tree_update (GESIntervalTree * tree, gpointer data,
+    guint64 start, guint64 duration)
+{
+  if (ges_interval_tree_remove (tree, data))
+    ges_interval_tree_insert (tree, data, start, duration);
+}
+
+GList *
+ges_interval_tree_query (GESIntervalTree * tree, guint64 start, guint64 end)
+{
+  return g_list_reverse (node_query (tree->root, start, end, NULL));
+}
+
+/* Gets the interval @data was inserted with, returns FALSE if it wasn't */
+gboolean
+ges_interval_tree_lookup (GESIntervalTree * tree, gpointer data,
+    guint64 * start, guint64 * end)
+{
+  GESIntervalNode *node;
+
+  node = g_hash_table_lookup (tree->nodes, data);
+  if (node == NULL)
+    return FALSE;
+
+  *start = node->start;
+  *end = node->end;
+
+  return TRUE;
+}
@@ -0,0 +1,617 @@
+/* GStreamer Editing Services
+ * Copyright (C) 2011 The GStreamer Editing Services authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Segment-parallel rendering.
+ *
+ * The timeline is split into time ranges at cut points, that is at the
+ * edges of its objects, never in the middle of a transition. Each range is
+ * rendered by its own GESTimelinePipeline working on a copy of the timeline
+ * (serialized with the default formatter), all of them running at the same
+ * time. The resulting files all start with a keyframe, and are joined into
+ * the final file by smart rendering a timeline made of them, which passes
+ * them through without re-encoding.
+ *
+ * That only works for formats whose streams carry no per-file setup data,
+ * like the codec headers of Theora or Vorbis, which the join couldn't pass
+ * through. Other profiles are rendered by a single pipeline. */
+
+#include <glib/gstdio.h>
+
+#include "ges-internal.h"
+#include "ges.h"
+
+/* Formats independently encoded parts of which can be concatenated */
+#define CONCATENABLE_CAPS \
+  "video/mpegts; video/mpeg, systemstream=(boolean)true; " \
+  "video/mpeg, mpegversion=(int)[1, 2], systemstream=(boolean)false; " \
+  "audio/mpeg; audio/x-ac3; image/jpeg; video/x-dv; " \
+  "audio/x-raw-int; audio/x-raw-float; video/x-raw-yuv; video/x-raw-rgb"
+
+typedef struct
+{
+  guint index;
+  GstClockTime start, stop;     /* stop is invalid until the range is known */
+  gchar *uri;
+  GESTimelinePipeline *pipeline;
+  gboolean prerolled;
+  gboolean seeked;
+  gboolean done;
+} Segment;
+
+static gchar *
+serialize_timeline (GESTimeline * timeline, gsize * length)
+{
+  GESFormatter *formatter = ges_default_formatter_new ();
+  gchar *data = NULL;
+
+  if (ges_formatter_save (formatter, timeline)) {
+    data = ges_formatter_get_data (formatter, length);
+    /* The formatter frees its data when disposed */
+    ges_formatter_clear_data (formatter);
+  }
+  g_object_unref (formatter);
+
+  return data;
+}
+
+static GESTimeline *
+deserialize_timeline (const gchar * data, gsize length)
+{
+  GESFormatter *formatter = ges_default_formatter_new ();
+  GESTimeline *timeline = ges_timeline_new ();
+
+  ges_formatter_set_data (formatter, g_memdup (data, length), length);
+  if (!ges_formatter_load (formatter, timeline)) {
+    g_object_unref (timeline);
+    timeline = NULL;
+  }
+  g_object_unref (formatter);
+
+  return timeline;
+}
+
+static gint
+compare_time (gconstpointer a, gconstpointer b, gpointer unused)
+{
+  guint64 ta = *(const guint64 *) a, tb = *(const guint64 *) b;
+
+  return ta < tb ? -1 : (ta > tb ? 1 : 0);
+}
+
+/* Returns the sorted edges of the objects of @timeline that aren't in the
+ * middle of a transition, and sets @duration to the end of the timeline */
+static GArray *
+get_cut_points (GESTimeline * timeline, GstClockTime * duration)
+{
+  GArray *points = g_array_new (FALSE, FALSE, sizeof (guint64));
+  GArray *transitions = g_array_new (FALSE, FALSE, sizeof (guint64));
+  GList *layers, *ltmp, *objects, *otmp;
+  guint i, j, n;
+
+  *duration = 0;
+
+  layers = ges_timeline_get_layers (timeline);
+  for (ltmp = layers; ltmp; ltmp = ltmp->next) {
+    objects = ges_timeline_layer_get_objects ((GESTimelineLayer *) ltmp->data);
+
+    for (otmp = objects; otmp; otmp = otmp->next) {
+      GESTimelineObject *object = (GESTimelineObject *) otmp->data;
+      guint64 start = GES_TIMELINE_OBJECT_START (object);
+      guint64 end = start + GES_TIMELINE_OBJECT_DURATION (object);
+
+      /* Transitions are stored as consecutive start, end pairs */
+      if (GES_IS_TIMELINE_TRANSITION (object)) {
+        g_array_append_val (transitions, start);
+        g_array_append_val (transitions, end);
+      } else {
+        g_array_append_val (points, start);
+        g_array_append_val (points, end);
+      }
+
+      if (end > *duration)
+        *duration = end;
+      g_object_unref (object);
+    }
+    g_list_free (objects);
+    g_object_unref (ltmp->data);
+  }
+  g_list_free (layers);
+
+  g_array_sort_with_data (points, compare_time, NULL);
+  /* Sorting pairs by their start keeps them together */
+  g_qsort_with_data (transitions->data, transitions->len / 2,
+      2 * sizeof (guint64), compare_time, NULL);
+
+  /* Drop the duplicates and the points inside a transition, walking both
+   * sorted arrays at once */
+  for (i = 0, j = 0, n = 0; i < points->len; i++) {
+    guint64 point = g_array_index (points, guint64, i);
+
+    if (point == 0 || point >= *duration ||
+        (n && g_array_index (points, guint64, n - 1) == point))
+      continue;
+
+    while (j < transitions->len &&
+        g_array_index (transitions, guint64, j + 1) <= point)
+      j += 2;
+
+    if (j < transitions->len && g_array_index (transitions, guint64, j) < point)
+      continue;
+
+    g_array_index (points, guint64, n++) = point;
+  }
+  g_array_set_size (points, n);
+  g_array_free (transitions, TRUE);
+
+  return points;
+}
+
+/* Picks up to @jobs - 1 cut points splitting @duration as evenly as
+ * possible */
+static GArray *
+get_split_points (GArray * points, GstClockTime duration, guint jobs)
+{
+  GArray *splits = g_array_new (FALSE, FALSE, sizeof (guint64));
+  guint k, lo, hi, mid, first = 0;
+
+  for (k = 1; k < jobs && first < points->len; k++) {
+    guint64 target = gst_util_uint64_scale (duration, k, jobs);
+    guint best;
+
+    /* First point at or after target */
+    lo = first;
+    hi = points->len;
+    while (lo < hi) {
+      mid = (lo + hi) / 2;
+      if (g_array_index (points, guint64, mid) < target)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+    best = lo;
+    if (best == points->len || (best > first &&
+            target - g_array_index (points, guint64, best - 1) <
+            g_array_index (points, guint64, best) - target))
+      best--;
+
+    g_array_append_val (splits, g_array_index (points, guint64, best));
+    first = best + 1;
+  }
+
+  return splits;
+}
+
+static gboolean
+format_is_concatenable (GstEncodingProfile * profile, GstCaps * concatenable)
+{
+  GstCaps *format = gst_encoding_profile_get_format (profile);
+  gboolean ret;
+
+  ret = format && gst_caps_is_subset (format, concatenable);
+  if (format)
+    gst_caps_unref (format);
+
+  return ret;
+}
+
+/* Whether the files rendered with @profile can be joined without
+ * re-encoding them */
+static gboolean
+can_concatenate (GstEncodingProfile * profile)
+{
+  GstCaps *concatenable = gst_caps_from_string (CONCATENABLE_CAPS);
+  const GList *tmp;
+  gboolean ret;
+
+  ret = format_is_concatenable (profile, concatenable);
+  if (ret && GST_IS_ENCODING_CONTAINER_PROFILE (profile))
+    for (tmp = gst_encoding_container_profile_get_profiles (
+            (GstEncodingContainerProfile *) profile); ret && tmp;
+        tmp = tmp->next)
+      ret = format_is_concatenable (tmp->data, concatenable);
+  gst_caps_unref (concatenable);
+
+  return ret;
+}
+
+/* Takes ownership of @timeline, even on failure */
+static GESTimelinePipeline *
+make_pipeline (GESTimeline * timeline, const gchar * uri,
+    GstEncodingProfile * profile, GESPipelineFlags mode)
+{
+  GESTimelinePipeline *pipeline = ges_timeline_pipeline_new_for_render ();
+
+  if (!ges_timeline_pipeline_add_timeline (pipeline, timeline)) {
+    gst_object_unref (timeline);
+    gst_object_unref (pipeline);
+    return NULL;
+  }
+
+  if (!ges_timeline_pipeline_set_render_settings (pipeline, (gchar *) uri,
+          profile) || !ges_timeline_pipeline_set_mode (pipeline, mode)) {
+    gst_object_unref (pipeline);
+    return NULL;
+  }
+
+  return pipeline;
+}
+
+static void
+free_segment (Segment * segment)
+{
+  if (segment->pipeline) {
+    gst_element_set_state (GST_ELEMENT (segment->pipeline), GST_STATE_NULL);
+    gst_object_unref (segment->pipeline);
+  }
+  g_free (segment->uri);
+  g_slice_free (Segment, segment);
+}
+
+/* Handles the pending messages of the pipeline of @segment, seeking it to
+ * its range once prerolled.
+ *
+ * Returns: FALSE if an error happened */
+static gboolean
+handle_messages (Segment * segment)
+{
+  GstBus *bus = gst_pipeline_get_bus (GST_PIPELINE (segment->pipeline));
+  GstMessage *message;
+  gboolean ret = TRUE;
+
+  while (ret && !segment->done && (message = gst_bus_pop (bus))) {
+    switch (GST_MESSAGE_TYPE (message)) {
+      case GST_MESSAGE_ERROR:{
+        GError *err = NULL;
+        gchar *debug = NULL;
+
+        gst_message_parse_error (message, &err, &debug);
+        GST_ERROR ("segment %u: %s (%s)", segment->index, err->message,
+            GST_STR_NULL (debug));
+        g_error_free (err);
+        g_free (debug);
+        ret = FALSE;
+        break;
+      }
+      case GST_MESSAGE_ASYNC_DONE:
+        segment->prerolled = TRUE;
+        break;
+      case GST_MESSAGE_EOS:
+        GST_DEBUG ("segment %u done", segment->index);
+        gst_element_set_state (GST_ELEMENT (segment->pipeline),
+            GST_STATE_NULL);
+        segment->done = TRUE;
+        break;
+      default:
+        break;
+    }
+    gst_message_unref (message);
+  }
+  gst_object_unref (bus);
+
+  if (ret && segment->prerolled && !segment->seeked &&
+      GST_CLOCK_TIME_IS_VALID (segment->stop)) {
+    GST_DEBUG ("segment %u: %" GST_TIME_FORMAT " - %" GST_TIME_FORMAT,
+        segment->index, GST_TIME_ARGS (segment->start),
+        GST_TIME_ARGS (segment->stop));
+
+    segment->seeked = TRUE;
+    if (!gst_element_seek (GST_ELEMENT (segment->pipeline), 1.0,
+            GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE,
+            GST_SEEK_TYPE_SET, segment->start, GST_SEEK_TYPE_SET,
+            segment->stop)) {
+      GST_ERROR ("segment %u: seeking failed", segment->index);
+      ret = FALSE;
+    } else if (gst_element_set_state (GST_ELEMENT (segment->pipeline),
+            GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+      ret = FALSE;
+  }
+
+  return ret;
+}
+
+static void
+report_progress (Segment * segment, guint n_segments,
+    GESRenderProgressFunc progress, gpointer user_data)
+{
+  GstFormat format = GST_FORMAT_TIME;
+  gint64 position = 0;
+
+  if (segment->done)
+    position = segment->stop;
+  else if (!segment->seeked ||
+      !gst_element_query_position (GST_ELEMENT (segment->pipeline), &format,
+          &position))
+    position = segment->start;
+
+  position = CLAMP ((guint64) position, segment->start, segment->stop);
+
+  progress (segment->index, n_segments, position - segment->start,
+      segment->stop - segment->start, user_data);
+}
+
+/* Runs the pipelines of @segments until they are all done. The discoverers
+ * of the timelines need the default main context, so it gets iterated
+ * too. */
+static gboolean
+run_segments (Segment ** segments, guint n_segments, guint total,
+    GESRenderProgressFunc progress, gpointer user_data)
+{
+  GstClockTime last_report = 0, now;
+  gboolean done = FALSE;
+  guint i;
+
+  for (i = 0; i < n_segments; i++)
+    if (gst_element_set_state (GST_ELEMENT (segments[i]->pipeline),
+            GST_STATE_PAUSED) == GST_STATE_CHANGE_FAILURE)
+      return FALSE;
+
+  while (!done) {
+    done = TRUE;
+    for (i = 0; i < n_segments; i++) {
+      if (!handle_messages (segments[i]))
+        return FALSE;
+      done &= segments[i]->done;
+    }
+
+    while (g_main_context_iteration (NULL, FALSE));
+
+    now = gst_util_get_timestamp ();
+    if (progress && (done || now - last_report >= 100 * GST_MSECOND)) {
+      for (i = 0; i < n_segments; i++)
+        report_progress (segments[i], total, progress, user_data);
+      last_report = now;
+    }
+
+    if (!done)
+      g_usleep (10000);
+  }
+
+  return TRUE;
+}
+
+static void
+remove_file (const gchar * uri)
+{
+  gchar *filename = g_filename_from_uri (uri, NULL, NULL);
+
+  if (filename) {
+    g_unlink (filename);
+    g_free (filename);
+  }
+}
+
+/* Smart renders the files of @segments one after the other to @uri */
+static gboolean
+join_segments (GESTimeline * original, Segment ** segments, guint n_segments,
+    const gchar * uri, GstEncodingProfile * profile,
+    GESRenderProgressFunc progress, gpointer user_data)
+{
+  GESTimeline *timeline = ges_timeline_new ();
+  GESTimelineLayer *layer;
+  GList *tracks, *tmp;
+  Segment join = { 0, }, *joins[1] = { &join };
+  gboolean ret;
+  guint i;
+
+  tracks = ges_timeline_get_tracks (original);
+  for (tmp = tracks; tmp; tmp = tmp->next) {
+    GESTrack *track = (GESTrack *) tmp->data;
+
+    ges_timeline_add_track (timeline, ges_track_new (track->type,
+            gst_caps_copy (ges_track_get_caps (track))));
+    g_object_unref (track);
+  }
+  g_list_free (tracks);
+
+  layer = (GESTimelineLayer *) ges_simple_timeline_layer_new ();
+  ges_timeline_add_layer (timeline, layer);
+
+  for (i = 0; i < n_segments; i++) {
+    GESTimelineFileSource *source =
+        ges_timeline_filesource_new (segments[i]->uri);
+
+    g_object_set (source, "duration", segments[i]->stop - segments[i]->start,
+        NULL);
+    ges_simple_timeline_layer_add_object ((GESSimpleTimelineLayer *) layer,
+        (GESTimelineObject *) source, -1);
+  }
+
+  join.index = n_segments;
+  join.start = 0;
+  join.stop = segments[n_segments - 1]->stop;
+  join.pipeline = make_pipeline (timeline, uri, profile,
+      TIMELINE_MODE_SMART_RENDER);
+  if (join.pipeline == NULL)
+    return FALSE;
+
+  ret = run_segments (joins, 1, n_segments, progress, user_data);
+
+  gst_element_set_state (GST_ELEMENT (join.pipeline), GST_STATE_NULL);
+  gst_object_unref (join.pipeline);
+
+  return ret;
+}
+
+/**
+ * ges_timeline_render_parallel:
+ * @timeline: the #GESTimeline to render
+ * @output_uri: the URI to render @timeline to
+ * @profile: the #GstEncodingProfile to use
+ * @jobs: the maximum number of segments rendered at the same time
+ * @progress: (allow-none) (scope call): function called regularly with the
+ * progress of each segment, or %NULL
+ * @user_data: data passed to @progress
+ *
+ * Renders @timeline to @output_uri, splitting it into up to @jobs segments
+ * rendered concurrently by as many pipelines, each of them using its own
+ * encoders. The timeline is only split at the edges of its objects, and
+ * never in the middle of a transition.
+ *
+ * The segments are first rendered to temporary files next to @output_uri,
+ * which are then joined without being re-encoded. While they are being
+ * joined, @progress gets called with a segment number equal to the number
+ * of segments.
+ *
+ * Joining only works with formats whose streams don't carry per-file setup
+ * headers, such as MPEG audio and video in MPEG program or transport
+ * streams, DV, Motion JPEG and raw streams. With any other @profile, for
+ * example Theora and Vorbis in Ogg, or with a @jobs of 1, or if @timeline
+ * has no cut point to split it at, @timeline is rendered by a single
+ * pipeline directly to @output_uri.
+ *
+ * @timeline is left untouched, and must not be playing. This function
+ * blocks until the rendering is done, iterating the default #GMainContext.
+ *
+ * Returns: %TRUE if @timeline was rendered, else %FALSE.
+ */
+gboolean
+ges_timeline_render_parallel (GESTimeline * timeline, const gchar * output_uri,
+    GstEncodingProfile * profile, guint jobs, GESRenderProgressFunc progress,
+    gpointer user_data)
+{
+  GESTimeline *copy;
+  GArray *points, *splits = NULL;
+  Segment **segments = NULL;
+  GstClockTime duration;
+  gchar *data;
+  gsize length;
+  guint i, n_segments = 0;
+  gboolean split, ret = FALSE;
+
+  g_return_val_if_fail (GES_IS_TIMELINE (timeline), FALSE);
+  g_return_val_if_fail (output_uri != NULL, FALSE);
+  g_return_val_if_fail (profile != NULL, FALSE);
+
+  GST_DEBUG ("timeline:%p, uri:%s, jobs:%u", timeline, output_uri, jobs);
+
+  split = jobs > 1 && can_concatenate (profile);
+  if (!split) {
+    GST_DEBUG ("Rendering in a single segment");
+    jobs = 1;
+  }
+
+  if (!(data = serialize_timeline (timeline, &length))) {
+    GST_ERROR ("Couldn't serialize the timeline");
+    return FALSE;
+  }
+
+  /* The first copy gets prerolled, so that the duration of its objects is
+   * known before splitting it */
+  if (!(copy = deserialize_timeline (data, length)))
+    goto done;
+
+  segments = g_new0 (Segment *, MAX (jobs, 1));
+  segments[0] = g_slice_new0 (Segment);
+  segments[0]->stop = GST_CLOCK_TIME_NONE;
+  segments[0]->uri = split ?
+      g_strdup_printf ("%s.part0", output_uri) : g_strdup (output_uri);
+  segments[0]->pipeline = make_pipeline (copy, segments[0]->uri, profile,
+      TIMELINE_MODE_RENDER);
+  n_segments = 1;
+  if (segments[0]->pipeline == NULL)
+    goto done;
+
+  if (gst_element_set_state (GST_ELEMENT (segments[0]->pipeline),
+          GST_STATE_PAUSED) == GST_STATE_CHANGE_FAILURE)
+    goto done;
+  while (!segments[0]->prerolled) {
+    if (!handle_messages (segments[0]))
+      goto done;
+    while (g_main_context_iteration (NULL, FALSE));
+    if (!segments[0]->prerolled)
+      g_usleep (10000);
+  }
+
+  points = get_cut_points (copy, &duration);
+  splits = get_split_points (points, duration, jobs);
+  g_array_free (points, TRUE);
+
+  segments[0]->stop = splits->len ? g_array_index (splits, guint64, 0) :
+      duration;
+
+  if (splits->len || split) {
+    g_free (data);
+    if (!(data = serialize_timeline (copy, &length)))
+      goto done;
+  }
+
+  if (split && !splits->len) {
+    /* Nothing to split at, render straight to the output instead */
+    GST_DEBUG ("No cut point, rendering in a single segment");
+    gst_element_set_state (GST_ELEMENT (segments[0]->pipeline),
+        GST_STATE_NULL);
+    remove_file (segments[0]->uri);
+    free_segment (segments[0]);
+    split = FALSE;
+
+    segments[0] = g_slice_new0 (Segment);
+    segments[0]->stop = duration;
+    segments[0]->uri = g_strdup (output_uri);
+    if (!(copy = deserialize_timeline (data, length)) ||
+        !(segments[0]->pipeline = make_pipeline (copy, output_uri, profile,
+                TIMELINE_MODE_RENDER)))
+      goto done;
+  }
+
+  for (i = 0; i < splits->len; i++) {
+    Segment *segment = g_slice_new0 (Segment);
+
+    segments[n_segments++] = segment;
+    segment->index = i + 1;
+    segment->start = g_array_index (splits, guint64, i);
+    segment->stop = i + 1 < splits->len ?
+        g_array_index (splits, guint64, i + 1) : duration;
+    segment->uri = g_strdup_printf ("%s.part%u", output_uri, i + 1);
+
+    if (!(copy = deserialize_timeline (data, length)) ||
+        !(segment->pipeline = make_pipeline (copy, segment->uri, profile,
+                TIMELINE_MODE_RENDER)))
+      goto done;
+  }
+
+  GST_DEBUG ("Rendering %" GST_TIME_FORMAT " in %u segments",
+      GST_TIME_ARGS (duration), n_segments);
+
+  if (!run_segments (segments, n_segments, n_segments, progress, user_data))
+    goto done;
+
+  if (split) {
+    for (i = 0; i < n_segments; i++) {
+      gst_object_unref (segments[i]->pipeline);
+      segments[i]->pipeline = NULL;
+    }
+    ret = join_segments (timeline, segments, n_segments, output_uri, profile,
+        progress, user_data);
+  } else
+    ret = TRUE;
+
+done:
+  for (i = 0; i < n_segments; i++) {
+    if (split)
+      remove_file (segments[i]->uri);
+    free_segment (segments[i]);
+  }
+  g_free (segments);
+  if (splits)
+    g_array_free (splits, TRUE);
+  g_free (data);
+
+  return ret;
+}
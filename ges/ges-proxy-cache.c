@@ -0,0 +1,438 @@
+/* GStreamer Editing Services
+ * Copyright (C) 2011 The GStreamer Editing Services authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Cache of proxy files used instead of the original media when previewing.
+ *
+ * The first time a track using proxies needs a file source, the uri of the
+ * source is queued for transcoding in the background to a small file made
+ * of motion JPEG frames and raw audio in a Matroska container, which are
+ * all intra and much cheaper to decode and seek in than most camera
+ * formats. The proxies are stored in the user cache directory, named after
+ * a checksum of the uri, and are considered valid as long as they are more
+ * recent than the original file. Timestamps are kept as is, so the in-points
+ * of the sources point to the same media in the proxy and in the original.
+ *
+ * Files are transcoded one at a time from the default main context. Once a
+ * proxy is ready, the tracks using proxies recreate the contents of their
+ * sources, which then decode the proxy.
+ *
+ * Only local (file://) uris get proxies. */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#include "ges-internal.h"
+#include "ges-utils.h"
+
+#define PROXY_HEIGHT 360
+#define PROXY_VIDEO_CAPS "video/x-raw-yuv,format=(fourcc)I420,height=%d"
+#define PROXY_AUDIO_CAPS \
+  "audio/x-raw-int,width=16,depth=16,signed=true,endianness=1234"
+
+typedef struct
+{
+  gchar *uri;
+  gchar *filename;              /* Where the proxy is or will be */
+  gchar *proxy_uri;             /* Set once the proxy is ready */
+
+  GstElement *pipeline;         /* Set while transcoding */
+  GstElement *mux;
+  gboolean has_video, has_audio;
+  gboolean failed;
+} Proxy;
+
+G_LOCK_DEFINE_STATIC (proxy_lock);
+static GHashTable *proxies = NULL;      /* uri => Proxy */
+static GQueue pending = G_QUEUE_INIT;   /* Proxy waiting to be transcoded */
+static Proxy *running = NULL;
+static GList *watchers = NULL;  /* GESTrack using proxies */
+static gchar *directory = NULL;
+
+static void start_next (void);
+
+static void
+free_proxy (Proxy * proxy)
+{
+  g_free (proxy->uri);
+  g_free (proxy->filename);
+  g_free (proxy->proxy_uri);
+  g_slice_free (Proxy, proxy);
+}
+
+static gboolean
+get_mtime (const gchar * filename, gint64 * mtime)
+{
+  struct stat st;
+
+  if (g_stat (filename, &st) != 0)
+    return FALSE;
+
+  *mtime = (gint64) st.st_mtime;
+  return TRUE;
+}
+
+/* Must be called with the proxy_lock taken */
+static Proxy *
+get_proxy (const gchar * uri)
+{
+  Proxy *proxy;
+  gchar *original, *checksum, *name;
+  gint64 mtime, proxy_mtime;
+
+  if (G_UNLIKELY (proxies == NULL))
+    proxies = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+        (GDestroyNotify) free_proxy);
+
+  if ((proxy = g_hash_table_lookup (proxies, uri)))
+    return proxy;
+
+  if (!g_str_has_prefix (uri, "file://"))
+    return NULL;
+
+  if (!(original = g_filename_from_uri (uri, NULL, NULL)))
+    return NULL;
+
+  if (directory == NULL)
+    directory = g_build_filename (g_get_user_cache_dir (),
+        "gstreamer-editing-services", "proxies", NULL);
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, -1);
+  name = g_strconcat (checksum, ".mkv", NULL);
+
+  proxy = g_slice_new0 (Proxy);
+  proxy->uri = g_strdup (uri);
+  proxy->filename = g_build_filename (directory, name, NULL);
+
+  if (get_mtime (original, &mtime) &&
+      get_mtime (proxy->filename, &proxy_mtime) && proxy_mtime >= mtime)
+    proxy->proxy_uri = g_filename_to_uri (proxy->filename, NULL, NULL);
+
+  GST_DEBUG ("uri:%s, proxy:%s, ready:%d", uri, proxy->filename,
+      proxy->proxy_uri != NULL);
+
+  g_hash_table_insert (proxies, proxy->uri, proxy);
+
+  g_free (name);
+  g_free (checksum);
+  g_free (original);
+
+  return proxy;
+}
+
+static GstElement *
+make_chain (const gchar * description)
+{
+  GError *error = NULL;
+  GstElement *bin;
+
+  bin = gst_parse_bin_from_description (description, TRUE, &error);
+  if (bin == NULL) {
+    GST_WARNING ("Could not create '%s': %s", description, error->message);
+    g_error_free (error);
+  }
+
+  return bin;
+}
+
+static void
+pad_added_cb (GstElement * decodebin, GstPad * pad, Proxy * proxy)
+{
+  GstCaps *caps = gst_pad_get_caps (pad);
+  const gchar *name = gst_structure_get_name (gst_caps_get_structure (caps,
+          0));
+  GstElement *chain = NULL;
+  GstPad *sinkpad, *srcpad, *muxpad = NULL;
+  gchar *description;
+
+  if (g_str_has_prefix (name, "video/x-raw") && !proxy->has_video) {
+    description = g_strdup_printf ("queue ! ffmpegcolorspace ! videoscale ! "
+        PROXY_VIDEO_CAPS " ! jpegenc", PROXY_HEIGHT);
+    chain = make_chain (description);
+    g_free (description);
+    muxpad = gst_element_get_request_pad (proxy->mux, "video_%d");
+    proxy->has_video = TRUE;
+  } else if (g_str_has_prefix (name, "audio/x-raw") && !proxy->has_audio) {
+    chain = make_chain ("queue ! audioconvert ! " PROXY_AUDIO_CAPS);
+    muxpad = gst_element_get_request_pad (proxy->mux, "audio_%d");
+    proxy->has_audio = TRUE;
+  }
+  gst_caps_unref (caps);
+
+  if (chain == NULL || muxpad == NULL) {
+    GST_DEBUG ("Ignoring %" GST_PTR_FORMAT, pad);
+    if (chain)
+      gst_object_unref (chain);
+    if (muxpad)
+      gst_element_release_request_pad (proxy->mux, muxpad);
+    return;
+  }
+
+  gst_bin_add (GST_BIN (proxy->pipeline), chain);
+  sinkpad = gst_element_get_static_pad (chain, "sink");
+  srcpad = gst_element_get_static_pad (chain, "src");
+  if (GST_PAD_LINK_FAILED (gst_pad_link (pad, sinkpad)) ||
+      GST_PAD_LINK_FAILED (gst_pad_link (srcpad, muxpad)))
+    GST_WARNING ("Couldn't link %" GST_PTR_FORMAT, pad);
+  gst_object_unref (sinkpad);
+  gst_object_unref (srcpad);
+  gst_object_unref (muxpad);
+
+  gst_element_sync_state_with_parent (chain);
+}
+
+/* Must be called with the proxy_lock taken */
+static gboolean
+make_pipeline (Proxy * proxy, const gchar * location)
+{
+  GstElement *decodebin, *sink;
+
+  decodebin = gst_element_factory_make ("uridecodebin", NULL);
+  proxy->mux = gst_element_factory_make ("matroskamux", NULL);
+  sink = gst_element_factory_make ("filesink", NULL);
+
+  if (decodebin == NULL || proxy->mux == NULL || sink == NULL) {
+    GST_WARNING ("Missing elements to create proxies");
+    if (decodebin)
+      gst_object_unref (decodebin);
+    if (proxy->mux)
+      gst_object_unref (proxy->mux);
+    if (sink)
+      gst_object_unref (sink);
+    proxy->mux = NULL;
+    return FALSE;
+  }
+
+  g_object_set (decodebin, "uri", proxy->uri, NULL);
+  g_object_set (sink, "location", location, NULL);
+  g_signal_connect (decodebin, "pad-added", G_CALLBACK (pad_added_cb), proxy);
+
+  proxy->pipeline = gst_pipeline_new ("proxy");
+  gst_bin_add_many (GST_BIN (proxy->pipeline), decodebin, proxy->mux, sink,
+      NULL);
+  gst_element_link (proxy->mux, sink);
+
+  return TRUE;
+}
+
+static gchar *
+temporary_location (Proxy * proxy)
+{
+  return g_strconcat (proxy->filename, ".part", NULL);
+}
+
+static gboolean
+bus_cb (GstBus * bus, GstMessage * message, Proxy * proxy)
+{
+  GList *tmp, *tracks;
+  gchar *location;
+  GError *error = NULL;
+
+  switch (GST_MESSAGE_TYPE (message)) {
+    case GST_MESSAGE_EOS:
+    case GST_MESSAGE_ERROR:
+      break;
+    default:
+      return TRUE;
+  }
+
+  gst_element_set_state (proxy->pipeline, GST_STATE_NULL);
+  location = temporary_location (proxy);
+
+  G_LOCK (proxy_lock);
+  gst_object_unref (proxy->pipeline);
+  proxy->pipeline = NULL;
+  proxy->mux = NULL;
+  running = NULL;
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR) {
+    gst_message_parse_error (message, &error, NULL);
+    GST_WARNING ("Could not create a proxy for %s: %s", proxy->uri,
+        error->message);
+    g_error_free (error);
+    proxy->failed = TRUE;
+    g_unlink (location);
+  } else if (g_rename (location, proxy->filename) == 0) {
+    GST_DEBUG ("Proxy of %s ready", proxy->uri);
+    proxy->proxy_uri = g_filename_to_uri (proxy->filename, NULL, NULL);
+  } else {
+    proxy->failed = TRUE;
+  }
+
+  tracks = g_list_copy (watchers);
+  for (tmp = tracks; tmp; tmp = tmp->next)
+    g_object_ref (tmp->data);
+  G_UNLOCK (proxy_lock);
+
+  g_free (location);
+
+  if (proxy->proxy_uri) {
+    for (tmp = tracks; tmp; tmp = tmp->next)
+      ges_track_proxy_ready ((GESTrack *) tmp->data, proxy->uri);
+  }
+  for (tmp = tracks; tmp; tmp = tmp->next)
+    g_object_unref (tmp->data);
+  g_list_free (tracks);
+
+  start_next ();
+
+  return FALSE;
+}
+
+/* Starts transcoding the next queued uri, unless one already is */
+static void
+start_next (void)
+{
+  Proxy *proxy;
+  GstBus *bus;
+  gchar *location, *dirname;
+  gboolean ok;
+
+  G_LOCK (proxy_lock);
+  while (running == NULL && (proxy = g_queue_pop_head (&pending))) {
+    location = temporary_location (proxy);
+    dirname = g_path_get_dirname (proxy->filename);
+
+    ok = g_mkdir_with_parents (dirname, 0755) == 0 &&
+        make_pipeline (proxy, location);
+    g_free (dirname);
+    g_free (location);
+
+    if (!ok) {
+      proxy->failed = TRUE;
+      continue;
+    }
+
+    GST_DEBUG ("Transcoding %s to %s", proxy->uri, proxy->filename);
+
+    bus = gst_pipeline_get_bus (GST_PIPELINE (proxy->pipeline));
+    gst_bus_add_watch (bus, (GstBusFunc) bus_cb, proxy);
+    gst_object_unref (bus);
+
+    running = proxy;
+    gst_element_set_state (proxy->pipeline, GST_STATE_PLAYING);
+  }
+  G_UNLOCK (proxy_lock);
+}
+
+/* INTERNAL USAGE
+ *
+ * Returns: (transfer full): the uri of the proxy of @uri if it is ready,
+ * else %NULL, in which case the proxy gets created in the background */
+gchar *
+ges_proxy_cache_request (const gchar * uri)
+{
+  Proxy *proxy;
+  gchar *ret = NULL;
+  gboolean start = FALSE;
+
+  G_LOCK (proxy_lock);
+  if ((proxy = get_proxy (uri))) {
+    ret = g_strdup (proxy->proxy_uri);
+    if (ret == NULL && !proxy->failed && proxy != running &&
+        !g_queue_find (&pending, proxy)) {
+      g_queue_push_tail (&pending, proxy);
+      start = TRUE;
+    }
+  }
+  G_UNLOCK (proxy_lock);
+
+  if (start)
+    start_next ();
+
+  return ret;
+}
+
+/* INTERNAL USAGE
+ *
+ * Makes ges_track_proxy_ready() get called on @track whenever a proxy gets
+ * ready, until ges_proxy_cache_unwatch() */
+void
+ges_proxy_cache_watch (GESTrack * track)
+{
+  G_LOCK (proxy_lock);
+  if (!g_list_find (watchers, track))
+    watchers = g_list_prepend (watchers, track);
+  G_UNLOCK (proxy_lock);
+}
+
+void
+ges_proxy_cache_unwatch (GESTrack * track)
+{
+  G_LOCK (proxy_lock);
+  watchers = g_list_remove (watchers, track);
+  G_UNLOCK (proxy_lock);
+}
+
+/**
+ * ges_proxy_cache_get_proxy_uri:
+ * @uri: the uri of a media file
+ *
+ * Get the proxy used instead of @uri by the tracks with
+ * #GESTrack:use-proxies set. Proxies are only created for the sources of
+ * such tracks.
+ *
+ * Returns: (transfer full): the uri of the proxy of @uri, or %NULL if there
+ * is no such proxy yet.
+ */
+gchar *
+ges_proxy_cache_get_proxy_uri (const gchar * uri)
+{
+  Proxy *proxy;
+  gchar *ret = NULL;
+
+  g_return_val_if_fail (uri != NULL, NULL);
+
+  G_LOCK (proxy_lock);
+  if ((proxy = get_proxy (uri)))
+    ret = g_strdup (proxy->proxy_uri);
+  G_UNLOCK (proxy_lock);
+
+  return ret;
+}
+
+static gboolean
+is_idle (gpointer key, Proxy * proxy, gpointer user_data)
+{
+  return proxy != running && !g_queue_find (&pending, proxy);
+}
+
+/**
+ * ges_proxy_cache_set_directory:
+ * @path: (allow-none): the directory to store proxies in, or %NULL for the
+ * default one
+ *
+ * Sets where the proxies of the media files are stored. By default they are
+ * stored in the 'gstreamer-editing-services/proxies' subdirectory of the
+ * user cache directory.
+ */
+void
+ges_proxy_cache_set_directory (const gchar * path)
+{
+  GST_DEBUG ("path:%s", path);
+
+  G_LOCK (proxy_lock);
+  g_free (directory);
+  directory = g_strdup (path);
+
+  /* Forget what we knew about the previous directory */
+  if (proxies)
+    g_hash_table_foreach_remove (proxies, (GHRFunc) is_idle, NULL);
+  G_UNLOCK (proxy_lock);
+}
@@ -19,12 +19,247 @@
  */
 
 #include <gst/gst.h>
-#include <gst/video/video.h>
 #include "ges-screenshot.h"
 #include "ges-internal.h"
 
+/* Frame converters.
+ *
+ * A converter is a small pipeline (ffmpegcolorspace ! videoscale !
+ * capsfilter, followed by an image encoder and another capsfilter if the
+ * output caps aren't raw video) which stays in PLAYING for as long as the
+ * converter lives. Frames are pushed into it from a pad of our own and come
+ * out of a fakesink in the same thread, so converting a frame doesn't
+ * involve creating a pipeline or waiting for it to preroll. */
+
+struct _GESFrameConverter
+{
+  GMutex *lock;
+  GstElement *pipeline;
+  GstPad *srcpad;               /* Feeds the pipeline */
+  GstBuffer *result;            /* Set from the fakesink handoff */
+};
+
+/* The raw video caps to convert to before encoding to @caps */
+static GstCaps *
+make_raw_caps (const GstCaps * caps)
+{
+  static const gchar *fields[] = { "width", "height", "pixel-aspect-ratio" };
+  GstStructure *structure = gst_caps_get_structure (caps, 0);
+  GstCaps *raw;
+  guint i, j;
+
+  raw = gst_caps_from_string ("video/x-raw-yuv;video/x-raw-rgb");
+  for (i = 0; i < gst_caps_get_size (raw); i++) {
+    GstStructure *rstructure = gst_caps_get_structure (raw, i);
+
+    for (j = 0; j < G_N_ELEMENTS (fields); j++)
+      if (gst_structure_has_field (structure, fields[j]))
+        gst_structure_set_value (rstructure, fields[j],
+            gst_structure_get_value (structure, fields[j]));
+  }
+
+  return raw;
+}
+
+/* Returns: (transfer floating): the best ranked image encoder outputting
+ * @caps, or %NULL */
+static GstElement *
+make_encoder (const GstCaps * caps)
+{
+  GList *factories, *encoders;
+  GstElement *encoder = NULL;
+
+  factories = gst_element_factory_list_get_elements
+      (GST_ELEMENT_FACTORY_TYPE_ENCODER | GST_ELEMENT_FACTORY_TYPE_MEDIA_IMAGE,
+      GST_RANK_NONE);
+  encoders = gst_element_factory_list_filter (factories, caps, GST_PAD_SRC,
+      FALSE);
+  encoders = g_list_sort (encoders, gst_plugin_feature_rank_compare_func);
+
+  if (encoders)
+    encoder = gst_element_factory_create (encoders->data, NULL);
+
+  /* pngenc sends EOS after its first frame unless told otherwise */
+  if (encoder &&
+      g_object_class_find_property (G_OBJECT_GET_CLASS (encoder), "snapshot"))
+    g_object_set (encoder, "snapshot", FALSE, NULL);
+
+  gst_plugin_feature_list_free (encoders);
+  gst_plugin_feature_list_free (factories);
+
+  return encoder;
+}
+
+static void
+handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    GESFrameConverter * converter)
+{
+  gst_buffer_replace (&converter->result, buffer);
+}
+
+/**
+ * GESFrameConverter:
+ *
+ * Converts video frames to a given raw video or image format, reusing the
+ * same elements for every frame.
+ */
+
+/**
+ * ges_frame_converter_new:
+ * @caps: the caps to convert frames to, raw video or an image format
+ *
+ * Returns: a new #GESFrameConverter, or %NULL if no elements could convert
+ * frames to @caps
+ */
+GESFrameConverter *
+ges_frame_converter_new (const GstCaps * caps)
+{
+  GESFrameConverter *converter;
+  GstElement *csp, *scale, *filter, *encoder = NULL, *efilter = NULL, *sink;
+  GstElement *last;
+  GstCaps *raw = NULL;
+  GstBus *bus;
+  GstPad *sinkpad;
+  gboolean is_raw;
+
+  g_return_val_if_fail (GST_IS_CAPS (caps) && !gst_caps_is_empty (caps),
+      NULL);
+
+  is_raw = gst_caps_is_any (caps) || g_str_has_prefix (gst_structure_get_name
+      (gst_caps_get_structure (caps, 0)), "video/x-raw");
+
+  if (!is_raw && !(encoder = make_encoder (caps))) {
+    GST_WARNING ("No encoder for %" GST_PTR_FORMAT, caps);
+    return NULL;
+  }
+
+  csp = gst_element_factory_make ("ffmpegcolorspace", NULL);
+  scale = gst_element_factory_make ("videoscale", NULL);
+  filter = gst_element_factory_make ("capsfilter", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (!is_raw)
+    efilter = gst_element_factory_make ("capsfilter", NULL);
+
+  if (!csp || !scale || !filter || !sink || (!is_raw && !efilter)) {
+    GST_WARNING ("Missing elements to convert frames");
+    if (csp)
+      gst_object_unref (csp);
+    if (scale)
+      gst_object_unref (scale);
+    if (filter)
+      gst_object_unref (filter);
+    if (sink)
+      gst_object_unref (sink);
+    if (encoder)
+      gst_object_unref (encoder);
+    if (efilter)
+      gst_object_unref (efilter);
+    return NULL;
+  }
+
+  converter = g_slice_new0 (GESFrameConverter);
+  converter->lock = g_mutex_new ();
+  converter->pipeline = gst_pipeline_new ("frame-converter");
+  gst_bin_add_many (GST_BIN (converter->pipeline), csp, scale, filter, sink,
+      NULL);
+  gst_element_link_many (csp, scale, filter, NULL);
+  last = filter;
+
+  if (is_raw) {
+    g_object_set (filter, "caps", caps, NULL);
+  } else {
+    raw = make_raw_caps (caps);
+    g_object_set (filter, "caps", raw, NULL);
+    gst_caps_unref (raw);
+    g_object_set (efilter, "caps", caps, NULL);
+    gst_bin_add_many (GST_BIN (converter->pipeline), encoder, efilter, NULL);
+    gst_element_link_many (filter, encoder, efilter, NULL);
+    last = efilter;
+  }
+  gst_element_link (last, sink);
+
+  g_object_set (sink, "sync", FALSE, "async", FALSE, "signal-handoffs", TRUE,
+      "enable-last-buffer", FALSE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff_cb), converter);
+
+  /* Nobody reads the messages of the converter */
+  bus = gst_pipeline_get_bus (GST_PIPELINE (converter->pipeline));
+  gst_bus_set_flushing (bus, TRUE);
+  gst_object_unref (bus);
+
+  converter->srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  sinkpad = gst_element_get_static_pad (csp, "sink");
+  gst_pad_link (converter->srcpad, sinkpad);
+  gst_object_unref (sinkpad);
+  gst_pad_set_active (converter->srcpad, TRUE);
+
+  if (gst_element_set_state (converter->pipeline, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE) {
+    ges_frame_converter_free (converter);
+    return NULL;
+  }
+
+  gst_pad_push_event (converter->srcpad, gst_event_new_new_segment (FALSE,
+          1.0, GST_FORMAT_TIME, 0, -1, 0));
+
+  return converter;
+}
+
+/**
+ * ges_frame_converter_free:
+ * @converter: a #GESFrameConverter
+ *
+ * Frees @converter and the elements it was using.
+ */
+void
+ges_frame_converter_free (GESFrameConverter * converter)
+{
+  gst_element_set_state (converter->pipeline, GST_STATE_NULL);
+  gst_pad_set_active (converter->srcpad, FALSE);
+  gst_object_unref (converter->srcpad);
+  gst_object_unref (converter->pipeline);
+  if (converter->result)
+    gst_buffer_unref (converter->result);
+  g_mutex_free (converter->lock);
+  g_slice_free (GESFrameConverter, converter);
+}
+
+/**
+ * ges_frame_converter_convert:
+ * @converter: a #GESFrameConverter
+ * @buffer: (transfer none): the frame to convert, with caps
+ *
+ * Returns: (transfer full): @buffer converted to the caps of @converter, or
+ * %NULL if it could not be converted
+ */
+GstBuffer *
+ges_frame_converter_convert (GESFrameConverter * converter,
+    GstBuffer * buffer)
+{
+  GstBuffer *result;
+  GstFlowReturn flow;
+
+  g_mutex_lock (converter->lock);
+  flow = gst_pad_push (converter->srcpad, gst_buffer_ref (buffer));
+  result = converter->result;
+  converter->result = NULL;
+  g_mutex_unlock (converter->lock);
+
+  if (flow != GST_FLOW_OK) {
+    GST_ERROR ("Error converting frame: %s", gst_flow_get_name (flow));
+    if (result)
+      gst_buffer_unref (result);
+    return NULL;
+  }
+
+  return result;
+}
+
+/* Gets the current frame of @playsink, converted by @converter if not
+ * %NULL */
 GstBuffer *
-ges_play_sink_convert_frame (GstElement * playsink, GstCaps * caps)
+ges_play_sink_convert_frame (GstElement * playsink,
+    GESFrameConverter * converter)
 {
   GstBuffer *result;
 
@@ -32,18 +267,11 @@ ges_play_sink_convert_frame (GstElement * playsink, GstCaps * caps)
 
   GST_DEBUG ("got buffer %p from playsink", result);
 
-  if (result != NULL && caps != NULL) {
+  if (result != NULL && converter != NULL) {
     GstBuffer *temp;
-    GError *err = NULL;
 
-    temp = gst_video_convert_frame (result, caps, 25 * GST_SECOND, &err);
+    temp = ges_frame_converter_convert (converter, result);
     gst_buffer_unref (result);
-    if (temp == NULL && err) {
-      /* I'm really uncertain whether we should make playsink post an error
-       * on the bus or not. It's not like it's a critical issue regarding
-       * playsink behaviour. */
-      GST_ERROR ("Error converting frame: %s", err->message);
-    }
     result = temp;
   }
   return result;
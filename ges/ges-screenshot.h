@@ -25,8 +25,19 @@
 
 G_BEGIN_DECLS
 
+typedef struct _GESFrameConverter GESFrameConverter;
+
+GESFrameConverter *
+ges_frame_converter_new (const GstCaps * caps);
+void
+ges_frame_converter_free (GESFrameConverter * converter);
+GstBuffer *
+ges_frame_converter_convert (GESFrameConverter * converter,
+    GstBuffer * buffer);
+
 GstBuffer *
-ges_play_sink_convert_frame (GstElement * playsink, GstCaps * caps);
+ges_play_sink_convert_frame (GstElement * playsink,
+    GESFrameConverter * converter);
 
 G_END_DECLS
 
@@ -46,7 +46,11 @@ ges_simple_timeline_layer_object_added (GESTimelineLayer * layer,
     GESTimelineObject * object);
 
 static void
-timeline_object_height_changed_cb (GESTimelineObject * object G_GNUC_UNUSED,
+timeline_object_height_changed_cb (GESTimelineObject * object,
+    GParamSpec * arg G_GNUC_UNUSED, GESSimpleTimelineLayer * layer);
+
+static void
+timeline_object_duration_changed_cb (GESTimelineObject * object,
     GParamSpec * arg G_GNUC_UNUSED, GESSimpleTimelineLayer * layer);
 
 static GList *get_objects (GESTimelineLayer * layer);
@@ -54,10 +58,34 @@ static GList *get_objects (GESTimelineLayer * layer);
 G_DEFINE_TYPE (GESSimpleTimelineLayer, ges_simple_timeline_layer,
     GES_TYPE_TIMELINE_LAYER);
 
+/* Running values of gstl_recalculate_from() after placing an object */
+typedef struct
+{
+  GstClockTime pos;             /* Start of the next source */
+  gint priority;                /* Priority of the next source */
+  gint transition_priority;     /* Priority of the next transition */
+  GstClockTime transition_end;  /* End of the last transition so far */
+  gboolean invalid;             /* Whether the object itself is misplaced */
+} ObjectState;
+
+typedef struct
+{
+  GESTimelineObject *object;
+  GSequenceIter *iter;          /* Position of the entry in the sequence */
+  ObjectState state;
+} ObjectEntry;
+
 struct _GESSimpleTimelineLayerPrivate
 {
-  /* Sorted list of objects */
-  GList *objects;
+  /* Sorted sequence of ObjectEntry. GSequence is a balanced tree, so
+   * accessing, inserting and moving by position are O(log n) */
+  GSequence *objects;
+  /* GESTimelineObject => ObjectEntry */
+  GHashTable *entries;
+  /* Number of objects whose ObjectState is invalid */
+  guint n_invalid;
+  /* Priority of the first source the states were computed with */
+  gint base_priority;
 
   gboolean adding_object;
   gboolean valid;
@@ -104,6 +132,23 @@ ges_simple_timeline_layer_set_property (GObject * object, guint property_id,
   }
 }
 
+static void
+free_entry (ObjectEntry * entry)
+{
+  g_slice_free (ObjectEntry, entry);
+}
+
+static void
+ges_simple_timeline_layer_finalize (GObject * object)
+{
+  GESSimpleTimelineLayer *self = GES_SIMPLE_TIMELINE_LAYER (object);
+
+  g_sequence_free (self->priv->objects);
+  g_hash_table_destroy (self->priv->entries);
+
+  G_OBJECT_CLASS (ges_simple_timeline_layer_parent_class)->finalize (object);
+}
+
 static void
 ges_simple_timeline_layer_class_init (GESSimpleTimelineLayerClass * klass)
 {
@@ -114,6 +159,7 @@ ges_simple_timeline_layer_class_init (GESSimpleTimelineLayerClass * klass)
 
   object_class->get_property = ges_simple_timeline_layer_get_property;
   object_class->set_property = ges_simple_timeline_layer_set_property;
+  object_class->finalize = ges_simple_timeline_layer_finalize;
 
   /* Be informed when objects are being added/removed from elsewhere */
   layer_class->object_removed = ges_simple_timeline_layer_object_removed;
@@ -156,120 +202,214 @@ ges_simple_timeline_layer_init (GESSimpleTimelineLayer * self)
   self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
       GES_TYPE_SIMPLE_TIMELINE_LAYER, GESSimpleTimelineLayerPrivate);
 
-  self->priv->objects = NULL;
+  self->priv->objects = g_sequence_new ((GDestroyNotify) free_entry);
+  self->priv->entries = g_hash_table_new (g_direct_hash, g_direct_equal);
+  self->priv->base_priority = GES_TIMELINE_LAYER (self)->min_gnl_priority + 2;
+}
+
+/* GSequence iterator helpers, returning NULL instead of the begin/end
+ * boundaries */
+static GSequenceIter *
+iter_prev (GSequenceIter * iter)
+{
+  if (iter == NULL || g_sequence_iter_is_begin (iter))
+    return NULL;
+  return g_sequence_iter_prev (iter);
+}
+
+static GSequenceIter *
+iter_next (GSequenceIter * iter)
+{
+  if (iter == NULL)
+    return NULL;
+  iter = g_sequence_iter_next (iter);
+  return g_sequence_iter_is_end (iter) ? NULL : iter;
+}
+
+static GSequenceIter *
+iter_nth (GSequence * seq, gint position)
+{
+  GSequenceIter *iter;
+
+  if (position < 0)
+    return NULL;
+  iter = g_sequence_get_iter_at_pos (seq, position);
+  return g_sequence_iter_is_end (iter) ? NULL : iter;
 }
 
+static GSequenceIter *
+iter_last (GSequence * seq)
+{
+  return iter_prev (g_sequence_get_end_iter (seq));
+}
+
+static GESTimelineObject *
+iter_object (GSequenceIter * iter)
+{
+  return iter ? ((ObjectEntry *) g_sequence_get (iter))->object : NULL;
+}
+
+/* Returns whether @obj is misplaced, given its neighbours and the end of the
+ * last transition placed before it */
+static gboolean
+transition_is_invalid (GESTimelineObject * obj, GSequenceIter * iter,
+    GstClockTime pos, GstClockTime transition_end)
+{
+  GESTimelineObject *prev = iter_object (iter_prev (iter));
+  GESTimelineObject *next = iter_object (iter_next (iter));
+  guint64 dur = GES_TIMELINE_OBJECT_DURATION (obj);
+  gboolean invalid = FALSE;
+
+  if (GES_IS_TIMELINE_TRANSITION (prev)) {
+    GST_ERROR ("two transitions in sequence!");
+    invalid = TRUE;
+  }
+
+  if (prev && (GES_TIMELINE_OBJECT_DURATION (prev) < dur)) {
+    GST_ERROR ("transition duration exceeds that of previous neighbor!");
+    invalid = TRUE;
+  }
+
+  if (next && (GES_TIMELINE_OBJECT_DURATION (next) < dur)) {
+    GST_ERROR ("transition duration exceeds that of next neighbor!");
+    invalid = TRUE;
+  }
+
+  if (GST_CLOCK_TIME_IS_VALID (transition_end) && transition_end > pos) {
+    GST_ERROR ("%" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ": "
+        "overlapping transitions!", pos, transition_end);
+    invalid = TRUE;
+  }
+
+  return invalid;
+}
+
+/* Places the objects from @first onward, using the running values stored for
+ * the object preceding @first. All the objects up to @until (included) and
+ * the one following it are always placed. After that we stop as soon as the
+ * running values of an object are the same as the ones computed by the
+ * previous recalculation, since nothing after it can have changed. */
 static void
-gstl_recalculate (GESSimpleTimelineLayer * self)
-{
-  GList *tmp;
-  GstClockTime pos = 0;
-  gint priority = 0;
-  gint transition_priority = 0;
-  gint height;
-  GESTimelineObject *prev_object = NULL;
-  GESTimelineObject *prev_transition = NULL;
-  gboolean valid = TRUE;
+gstl_recalculate_from (GESSimpleTimelineLayer * self, GSequenceIter * first,
+    GSequenceIter * until)
+{
+  GSequenceIter *tmp, *last;
+  ObjectState state;
+  gboolean reached = (until == NULL);
+  gboolean valid;
+  gint base_priority;
   GESSimpleTimelineLayerPrivate *priv = self->priv;
 
-  priority = GES_TIMELINE_LAYER (self)->min_gnl_priority + 2;
+  base_priority = GES_TIMELINE_LAYER (self)->min_gnl_priority + 2;
+
+  /* The layer priority changed, everything needs to be placed again */
+  if (G_UNLIKELY (base_priority != priv->base_priority)) {
+    priv->base_priority = base_priority;
+    first = iter_nth (priv->objects, 0);
+    until = iter_last (priv->objects);
+    reached = (until == NULL);
+  }
 
   GST_DEBUG ("recalculating values");
 
-  if (priv->objects && GES_IS_TIMELINE_TRANSITION (priv->objects->data)) {
-    valid = FALSE;
+  if (iter_prev (first)) {
+    state = ((ObjectEntry *) g_sequence_get (iter_prev (first)))->state;
+  } else {
+    state.pos = 0;
+    state.priority = base_priority;
+    state.transition_priority = 0;
+    state.transition_end = GST_CLOCK_TIME_NONE;
+    state.invalid = FALSE;
   }
 
-  for (tmp = priv->objects; tmp; tmp = tmp->next) {
+  for (tmp = first; tmp; tmp = iter_next (tmp)) {
     GESTimelineObject *obj;
+    ObjectState *ostate;
     guint64 dur;
-    GList *l_next;
+    gint height;
+    gboolean unchanged;
 
-    obj = (GESTimelineObject *) tmp->data;
+    obj = iter_object (tmp);
+    ostate = &((ObjectEntry *) g_sequence_get (tmp))->state;
     dur = GES_TIMELINE_OBJECT_DURATION (obj);
     height = GES_TIMELINE_OBJECT_HEIGHT (obj);
 
+    state.invalid = FALSE;
+
     if (GES_IS_TIMELINE_SOURCE (obj)) {
 
-      GST_LOG ("%p obj: height: %d: priority %d", obj, height, priority);
+      GST_LOG ("%p obj: height: %d: priority %d", obj, height, state.priority);
 
-      if (G_UNLIKELY (GES_TIMELINE_OBJECT_START (obj) != pos)) {
-        ges_timeline_object_set_start (obj, pos);
+      if (G_UNLIKELY (GES_TIMELINE_OBJECT_START (obj) != state.pos)) {
+        ges_timeline_object_set_start (obj, state.pos);
       }
 
-      if (G_UNLIKELY (GES_TIMELINE_OBJECT_PRIORITY (obj) != priority)) {
-        ges_timeline_object_set_priority (obj, priority);
+      if (G_UNLIKELY (GES_TIMELINE_OBJECT_PRIORITY (obj) != state.priority)) {
+        ges_timeline_object_set_priority (obj, state.priority);
       }
 
-      transition_priority = MAX (0, priority - 1);
-      priority += height;
-      pos += dur;
+      state.transition_priority = MAX (0, state.priority - 1);
+      state.priority += height;
+      state.pos += dur;
 
-      g_assert (priority != -1);
+      g_assert (state.priority != -1);
 
     } else if (GES_IS_TIMELINE_TRANSITION (obj)) {
 
-      pos -= dur;
+      state.pos -= dur;
 
       GST_LOG ("%p obj: height: %d: trans_priority %d", obj, height,
-          transition_priority);
+          state.transition_priority);
 
-      g_assert (transition_priority != -1);
+      g_assert (state.transition_priority != -1);
 
-      if (G_UNLIKELY (GES_TIMELINE_OBJECT_START (obj) != pos))
-        ges_timeline_object_set_start (obj, pos);
+      if (G_UNLIKELY (GES_TIMELINE_OBJECT_START (obj) != state.pos))
+        ges_timeline_object_set_start (obj, state.pos);
 
       if (G_UNLIKELY (GES_TIMELINE_OBJECT_PRIORITY (obj) !=
-              transition_priority)) {
-        ges_timeline_object_set_priority (obj, transition_priority);
+              state.transition_priority)) {
+        ges_timeline_object_set_priority (obj, state.transition_priority);
       }
 
       /* sanity checks */
-      l_next = g_list_next (tmp);
-
-      if (GES_IS_TIMELINE_TRANSITION (prev_object)) {
-        GST_ERROR ("two transitions in sequence!");
-        valid = FALSE;
-      }
-
-      if (prev_object && (GES_TIMELINE_OBJECT_DURATION (prev_object) < dur)) {
-        GST_ERROR ("transition duration exceeds that of previous neighbor!");
-        valid = FALSE;
-      }
-
-      if (l_next && (GES_TIMELINE_OBJECT_DURATION (l_next->data) < dur)) {
-        GST_ERROR ("transition duration exceeds that of next neighbor!");
-        valid = FALSE;
-      }
-
-      if (prev_transition) {
-        guint64 start, end;
-        end = (GES_TIMELINE_OBJECT_DURATION (prev_transition) +
-            GES_TIMELINE_OBJECT_START (prev_transition));
-
-        start = pos;
-
-        if (end > start) {
-          GST_ERROR ("%" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ": "
-              "overlapping transitions!", start, end);
-          valid = FALSE;
-        }
-      }
-      prev_transition = obj;
+      state.invalid = transition_is_invalid (obj, tmp, state.pos,
+          state.transition_end);
+      state.transition_end = state.pos + dur;
     }
 
-    prev_object = obj;
+    if (state.invalid != ostate->invalid)
+      priv->n_invalid += state.invalid ? 1 : -1;
 
+    unchanged = (state.pos == ostate->pos && state.priority == ostate->priority
+        && state.transition_priority == ostate->transition_priority
+        && state.transition_end == ostate->transition_end);
+    *ostate = state;
+
+    if (reached && unchanged)
+      break;
+    if (tmp == until)
+      reached = TRUE;
   }
 
-  if (prev_object && GES_IS_TIMELINE_TRANSITION (prev_object)) {
-    valid = FALSE;
+  /* The final values are the ones after the last object */
+  last = iter_last (priv->objects);
+  if (last) {
+    state = ((ObjectEntry *) g_sequence_get (last))->state;
+  } else {
+    state.pos = 0;
+    state.priority = base_priority;
   }
 
   GST_DEBUG ("Finished recalculating: final start pos is: %" GST_TIME_FORMAT,
-      GST_TIME_ARGS (pos));
+      GST_TIME_ARGS (state.pos));
 
-  GES_TIMELINE_LAYER (self)->max_gnl_priority = priority;
+  GES_TIMELINE_LAYER (self)->max_gnl_priority = state.priority;
+
+  valid = (priv->n_invalid == 0);
+  if (GES_IS_TIMELINE_TRANSITION (iter_object (iter_nth (priv->objects, 0))))
+    valid = FALSE;
+  if (GES_IS_TIMELINE_TRANSITION (iter_object (last)))
+    valid = FALSE;
 
   if (valid != self->priv->valid) {
     self->priv->valid = valid;
@@ -277,6 +417,38 @@ gstl_recalculate (GESSimpleTimelineLayer * self)
   }
 }
 
+/* Places again the objects affected by a change of @iter's object */
+static void
+gstl_recalculate (GESSimpleTimelineLayer * self, GSequenceIter * iter)
+{
+  gstl_recalculate_from (self, iter_prev (iter) ? iter_prev (iter) : iter,
+      iter);
+}
+
+/* Inserts an entry for @object before @before (or at the end if NULL) */
+static ObjectEntry *
+insert_entry (GESSimpleTimelineLayer * self, GESTimelineObject * object,
+    GSequenceIter * before)
+{
+  ObjectEntry *entry = g_slice_new0 (ObjectEntry);
+
+  entry->object = object;
+  entry->iter = g_sequence_insert_before (before ? before :
+      g_sequence_get_end_iter (self->priv->objects), entry);
+  g_hash_table_insert (self->priv->entries, object, entry);
+
+  return entry;
+}
+
+static void
+remove_entry (GESSimpleTimelineLayer * self, ObjectEntry * entry)
+{
+  if (entry->state.invalid)
+    self->priv->n_invalid--;
+  g_hash_table_remove (self->priv->entries, entry->object);
+  g_sequence_remove (entry->iter);
+}
+
 /**
  * ges_simple_timeline_layer_add_object:
  * @layer: a #GESSimpleTimelineLayer
@@ -301,18 +473,17 @@ ges_simple_timeline_layer_add_object (GESSimpleTimelineLayer * layer,
     GESTimelineObject * object, gint position)
 {
   gboolean res;
-  GList *nth;
+  GSequenceIter *nth;
+  ObjectEntry *entry;
   GESSimpleTimelineLayerPrivate *priv = layer->priv;
 
   GST_DEBUG ("layer:%p, object:%p, position:%d", layer, object, position);
 
-  nth = g_list_nth (priv->objects, position);
+  nth = iter_nth (priv->objects, position);
 
   if (GES_IS_TIMELINE_TRANSITION (object)) {
-    GList *lprev = g_list_previous (nth);
-
-    GESTimelineObject *prev = GES_TIMELINE_OBJECT (lprev ? lprev->data : NULL);
-    GESTimelineObject *next = GES_TIMELINE_OBJECT (nth ? nth->data : NULL);
+    GESTimelineObject *prev = iter_object (iter_prev (nth));
+    GESTimelineObject *next = iter_object (nth);
 
     if ((prev && GES_IS_TIMELINE_TRANSITION (prev)) ||
         (next && GES_IS_TIMELINE_TRANSITION (next))) {
@@ -326,7 +497,7 @@ ges_simple_timeline_layer_add_object (GESSimpleTimelineLayer * layer,
   priv->adding_object = TRUE;
 
   /* provisionally insert the object */
-  priv->objects = g_list_insert (priv->objects, object, position);
+  entry = insert_entry (layer, object, nth);
 
   res = ges_timeline_layer_add_object ((GESTimelineLayer *) layer, object);
 
@@ -334,7 +505,7 @@ ges_simple_timeline_layer_add_object (GESSimpleTimelineLayer * layer,
   if (G_UNLIKELY (!res)) {
     priv->adding_object = FALSE;
     /* we failed to add the object, so remove it from our list */
-    priv->objects = g_list_remove (priv->objects, object);
+    remove_entry (layer, entry);
     return FALSE;
   }
 
@@ -347,7 +518,7 @@ ges_simple_timeline_layer_add_object (GESSimpleTimelineLayer * layer,
       (timeline_object_height_changed_cb), layer);
 
   /* recalculate positions */
-  gstl_recalculate (layer);
+  gstl_recalculate (layer, entry->iter);
 
   return TRUE;
 }
@@ -366,15 +537,9 @@ ges_simple_timeline_layer_add_object (GESSimpleTimelineLayer * layer,
 GESTimelineObject *
 ges_simple_timeline_layer_nth (GESSimpleTimelineLayer * layer, gint position)
 {
-  GList *list;
   GESSimpleTimelineLayerPrivate *priv = layer->priv;
 
-  list = g_list_nth (priv->objects, position);
-
-  if (list)
-    return GES_TIMELINE_OBJECT (list->data);
-
-  return NULL;
+  return iter_object (iter_nth (priv->objects, position));
 }
 
 /**
@@ -393,7 +558,9 @@ ges_simple_timeline_layer_index (GESSimpleTimelineLayer * layer,
     GESTimelineObject * object)
 {
   GESSimpleTimelineLayerPrivate *priv = layer->priv;
-  return g_list_index (priv->objects, object);
+  ObjectEntry *entry = g_hash_table_lookup (priv->entries, object);
+
+  return entry ? g_sequence_iter_get_position (entry->iter) : -1;
 }
 
 /**
@@ -413,7 +580,9 @@ gboolean
 ges_simple_timeline_layer_move_object (GESSimpleTimelineLayer * layer,
     GESTimelineObject * object, gint newposition)
 {
-  gint idx;
+  gint idx, newidx;
+  ObjectEntry *entry;
+  GSequenceIter *dest;
   GESSimpleTimelineLayerPrivate *priv = layer->priv;
   GESTimelineLayer *tl_obj_layer;
 
@@ -430,11 +599,12 @@ ges_simple_timeline_layer_move_object (GESSimpleTimelineLayer * layer,
     g_object_unref (tl_obj_layer);
 
   /* Find it's current position */
-  idx = g_list_index (priv->objects, object);
-  if (G_UNLIKELY (idx == -1)) {
+  entry = g_hash_table_lookup (priv->entries, object);
+  if (G_UNLIKELY (entry == NULL)) {
     GST_WARNING ("TimelineObject not controlled by this layer");
     return FALSE;
   }
+  idx = g_sequence_iter_get_position (entry->iter);
 
   GST_DEBUG ("Object was previously at position %d", idx);
 
@@ -442,14 +612,21 @@ ges_simple_timeline_layer_move_object (GESSimpleTimelineLayer * layer,
   if (idx == newposition)
     return TRUE;
 
-  /* pop it off the list */
-  priv->objects = g_list_remove (priv->objects, object);
-
-  /* re-add it at the proper position */
-  priv->objects = g_list_insert (priv->objects, object, newposition);
-
-  /* recalculate positions */
-  gstl_recalculate (layer);
+  /* move it to the proper position, as if it had been popped off the
+   * sequence and re-added at @newposition */
+  if (newposition < 0)
+    dest = g_sequence_get_end_iter (priv->objects);
+  else
+    dest = g_sequence_get_iter_at_pos (priv->objects,
+        newposition > idx ? newposition + 1 : newposition);
+  g_sequence_move (entry->iter, dest);
+
+  /* recalculate positions, everything between the old and new position
+   * got shifted */
+  newidx = g_sequence_iter_get_position (entry->iter);
+  gstl_recalculate_from (layer,
+      iter_nth (priv->objects, MAX (MIN (idx, newidx) - 1, 0)),
+      iter_nth (priv->objects, MAX (idx, newidx)));
 
   g_signal_emit (layer, gstl_signals[OBJECT_MOVED], 0, object, idx,
       newposition);
@@ -492,10 +669,26 @@ ges_simple_timeline_layer_object_removed (GESTimelineLayer * layer,
     GESTimelineObject * object)
 {
   GESSimpleTimelineLayer *sl = (GESSimpleTimelineLayer *) layer;
+  GESSimpleTimelineLayerPrivate *priv = sl->priv;
+  ObjectEntry *entry;
+  GSequenceIter *prev, *next;
+
+  g_signal_handlers_disconnect_by_func (object,
+      timeline_object_height_changed_cb, layer);
+  g_signal_handlers_disconnect_by_func (object,
+      timeline_object_duration_changed_cb, layer);
+
+  entry = g_hash_table_lookup (priv->entries, object);
+  if (G_UNLIKELY (entry == NULL))
+    return;
 
   /* remove object from our list */
-  sl->priv->objects = g_list_remove (sl->priv->objects, object);
-  gstl_recalculate (sl);
+  prev = iter_prev (entry->iter);
+  next = iter_next (entry->iter);
+  remove_entry (sl, entry);
+
+  /* Only the neighbours and what follows can have moved */
+  gstl_recalculate_from (sl, prev ? prev : next, next);
 }
 
 static void
@@ -505,34 +698,46 @@ ges_simple_timeline_layer_object_added (GESTimelineLayer * layer,
   GESSimpleTimelineLayer *sl = (GESSimpleTimelineLayer *) layer;
 
   if (sl->priv->adding_object == FALSE) {
-    /* remove object from our list */
-    sl->priv->objects = g_list_append (sl->priv->objects, object);
-    gstl_recalculate (sl);
+    /* add object to our list */
+    gstl_recalculate (sl, insert_entry (sl, object, NULL)->iter);
   }
-  g_signal_connect_swapped (object, "notify::duration",
-      G_CALLBACK (gstl_recalculate), layer);
+  g_signal_connect (object, "notify::duration",
+      G_CALLBACK (timeline_object_duration_changed_cb), layer);
 }
 
 static void
 timeline_object_height_changed_cb (GESTimelineObject * object,
     GParamSpec * arg G_GNUC_UNUSED, GESSimpleTimelineLayer * layer)
 {
+  ObjectEntry *entry;
+
   GST_LOG ("layer %p: notify height changed %p", layer, object);
-  gstl_recalculate (layer);
+
+  if ((entry = g_hash_table_lookup (layer->priv->entries, object)))
+    gstl_recalculate (layer, entry->iter);
+}
+
+static void
+timeline_object_duration_changed_cb (GESTimelineObject * object,
+    GParamSpec * arg G_GNUC_UNUSED, GESSimpleTimelineLayer * layer)
+{
+  ObjectEntry *entry;
+
+  GST_LOG ("layer %p: notify duration changed %p", layer, object);
+
+  if ((entry = g_hash_table_lookup (layer->priv->entries, object)))
+    gstl_recalculate (layer, entry->iter);
 }
 
 static GList *
 get_objects (GESTimelineLayer * l)
 {
-  GList *ret;
-  GList *tmp;
+  GList *ret = NULL;
+  GSequenceIter *tmp;
   GESSimpleTimelineLayer *layer = (GESSimpleTimelineLayer *) l;
 
-  ret = g_list_copy (layer->priv->objects);
-
-  for (tmp = ret; tmp; tmp = tmp->next) {
-    g_object_ref (tmp->data);
-  }
+  for (tmp = iter_nth (layer->priv->objects, 0); tmp; tmp = iter_next (tmp))
+    ret = g_list_prepend (ret, g_object_ref (iter_object (tmp)));
 
-  return ret;
+  return g_list_reverse (ret);
 }
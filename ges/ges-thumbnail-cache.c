@@ -0,0 +1,363 @@
+/* GStreamer Editing Services
+ * Copyright (C) 2011 The GStreamer Editing Services authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Persistent cache of encoded thumbnails.
+ *
+ * Thumbnails saved by a #GESTimelinePipeline are stored in the user cache
+ * directory under a checksum of a key describing everything the frame
+ * depends on: the objects playing at the position of the thumbnail (their
+ * type, their properties, their offset from the position, and the size and
+ * modification time of their file), and the size and format of the image.
+ *
+ * Since the key describes the contents of the timeline rather than the
+ * timeline itself, editing the objects around a position gives another key
+ * and the previous thumbnail simply isn't looked up anymore, while edits
+ * elsewhere in the timeline keep it valid. The same clip at the same offset
+ * in another project also shares its thumbnails.
+ *
+ * The directory is kept under a maximum size by removing the least recently
+ * used thumbnails, lookups refreshing the modification time of the files. */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#include "ges-internal.h"
+#include "ges-utils.h"
+#include "ges.h"
+
+#define DEFAULT_MAX_SIZE (64 * 1024 * 1024)
+
+/* The length of a SHA1 checksum in hexadecimal */
+#define FILENAME_LENGTH 40
+
+typedef struct
+{
+  gchar *filename;
+  guint64 size;
+  gint64 mtime;
+} CacheEntry;
+
+G_LOCK_DEFINE_STATIC (cache_lock);
+static gchar *directory = NULL;
+static guint64 max_size = DEFAULT_MAX_SIZE;
+/* The size of the thumbnails in the directory, -1 until it was computed */
+static gint64 current_size = -1;
+
+/* Must be called with the cache_lock taken */
+static gchar *
+get_filename (const gchar * key)
+{
+  gchar *checksum, *filename;
+
+  if (directory == NULL)
+    directory = g_build_filename (g_get_user_cache_dir (),
+        "gstreamer-editing-services", "thumbnails", NULL);
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, key, -1);
+  filename = g_build_filename (directory, checksum, NULL);
+  g_free (checksum);
+
+  return filename;
+}
+
+static gint
+compare_entries (gconstpointer a, gconstpointer b)
+{
+  const CacheEntry *ea = a, *eb = b;
+
+  if (ea->mtime < eb->mtime)
+    return -1;
+  if (ea->mtime > eb->mtime)
+    return 1;
+  return 0;
+}
+
+/* Must be called with the cache_lock taken. Computes the size of the
+ * directory, and if it is above @limit, removes the least recently used
+ * thumbnails until it only takes 3/4 of it, so that the directory doesn't
+ * need to be scanned again at each new thumbnail. */
+static void
+trim (guint64 limit)
+{
+  GArray *entries;
+  GDir *dir;
+  const gchar *name;
+  guint i;
+
+  if (directory == NULL || !(dir = g_dir_open (directory, 0, NULL)))
+    return;
+
+  entries = g_array_new (FALSE, FALSE, sizeof (CacheEntry));
+  current_size = 0;
+
+  while ((name = g_dir_read_name (dir))) {
+    CacheEntry entry;
+    struct stat st;
+
+    /* Leaves alone the temporary files of g_file_set_contents() */
+    if (strlen (name) != FILENAME_LENGTH || strchr (name, '.'))
+      continue;
+
+    entry.filename = g_build_filename (directory, name, NULL);
+    if (g_stat (entry.filename, &st) != 0) {
+      g_free (entry.filename);
+      continue;
+    }
+
+    entry.size = st.st_size;
+    entry.mtime = st.st_mtime;
+    current_size += entry.size;
+    g_array_append_val (entries, entry);
+  }
+  g_dir_close (dir);
+
+  if ((guint64) current_size > limit) {
+    g_array_sort (entries, compare_entries);
+
+    for (i = 0; i < entries->len &&
+        (guint64) current_size > limit / 4 * 3; i++) {
+      CacheEntry *entry = &g_array_index (entries, CacheEntry, i);
+
+      GST_LOG ("Removing %s", entry->filename);
+      if (g_unlink (entry->filename) == 0)
+        current_size -= entry->size;
+    }
+  }
+
+  for (i = 0; i < entries->len; i++)
+    g_free (g_array_index (entries, CacheEntry, i).filename);
+  g_array_free (entries, TRUE);
+}
+
+static void
+append_file_stats (GString * key, const gchar * uri)
+{
+  gchar *filename;
+  struct stat st;
+
+  if (!g_str_has_prefix (uri, "file://") ||
+      !(filename = g_filename_from_uri (uri, NULL, NULL)))
+    return;
+
+  if (g_stat (filename, &st) == 0)
+    g_string_append_printf (key, " size=%" G_GUINT64_FORMAT " mtime=%"
+        G_GINT64_FORMAT, (guint64) st.st_size, (gint64) st.st_mtime);
+  g_free (filename);
+}
+
+static void
+append_object (GString * key, GESTimelineObject * object, guint64 position,
+    gboolean use_proxies)
+{
+  GParamSpec **pspecs;
+  guint i, n;
+
+  g_string_append_printf (key, "\n%s offset=%" G_GUINT64_FORMAT,
+      G_OBJECT_TYPE_NAME (object), position - object->start);
+
+  /* Everything but the start, which the offset accounts for */
+  pspecs = g_object_class_list_properties (G_OBJECT_GET_CLASS (object), &n);
+  for (i = 0; i < n; i++) {
+    GValue value = { 0, };
+    gchar *contents;
+
+    if (!(pspecs[i]->flags & G_PARAM_READABLE) ||
+        !strcmp (pspecs[i]->name, "start") ||
+        G_IS_PARAM_SPEC_OBJECT (pspecs[i]) ||
+        G_IS_PARAM_SPEC_POINTER (pspecs[i]))
+      continue;
+
+    g_value_init (&value, pspecs[i]->value_type);
+    g_object_get_property ((GObject *) object, pspecs[i]->name, &value);
+    contents = g_strdup_value_contents (&value);
+    g_string_append_printf (key, " %s=%s", pspecs[i]->name, contents);
+    g_free (contents);
+    g_value_unset (&value);
+  }
+  g_free (pspecs);
+
+  if (GES_IS_TIMELINE_FILE_SOURCE (object)) {
+    const gchar *uri =
+        ges_timeline_filesource_get_uri ((GESTimelineFileSource *) object);
+    gchar *proxy = NULL;
+
+    append_file_stats (key, uri);
+
+    /* What is decoded, the frames of a proxy differing from the original */
+    if (use_proxies && (proxy = ges_proxy_cache_get_proxy_uri (uri))) {
+      g_string_append_printf (key, " proxy=%s", proxy);
+      append_file_stats (key, proxy);
+      g_free (proxy);
+    }
+  }
+}
+
+/* INTERNAL USAGE
+ *
+ * Returns: (transfer full): the key of the thumbnail of @timeline at
+ * @position, saved in @format (with @extra describing its size), the file
+ * sources being decoded from their proxies, when ready, if @use_proxies is
+ * set */
+gchar *
+ges_thumbnail_cache_make_key (GESTimeline * timeline, guint64 position,
+    gboolean use_proxies, const gchar * format, const gchar * extra)
+{
+  GString *key = g_string_new (NULL);
+  GList *layers, *ltmp, *objects, *otmp;
+
+  g_string_append_printf (key, "%s %s", format, extra ? extra : "");
+
+  layers = ges_timeline_get_layers (timeline);
+  for (ltmp = layers; ltmp; ltmp = ltmp->next) {
+    GESTimelineLayer *layer = (GESTimelineLayer *) ltmp->data;
+
+    g_string_append_printf (key, "\nlayer %u",
+        ges_timeline_layer_get_priority (layer));
+
+    objects = ges_timeline_layer_get_objects_in_range (layer, position,
+        position);
+    for (otmp = objects; otmp; otmp = otmp->next) {
+      append_object (key, (GESTimelineObject *) otmp->data, position,
+          use_proxies);
+      g_object_unref (otmp->data);
+    }
+    g_list_free (objects);
+    g_object_unref (layer);
+  }
+  g_list_free (layers);
+
+  return g_string_free (key, FALSE);
+}
+
+/* INTERNAL USAGE
+ *
+ * Returns: %TRUE if an image was stored for @key, in which case @data
+ * (to be freed) and @size are set */
+gboolean
+ges_thumbnail_cache_lookup (const gchar * key, gchar ** data, gsize * size)
+{
+  gchar *filename;
+  gboolean ret;
+
+  G_LOCK (cache_lock);
+  filename = get_filename (key);
+  G_UNLOCK (cache_lock);
+
+  ret = g_file_get_contents (filename, data, size, NULL);
+  GST_LOG ("%s: %d", filename, ret);
+
+  /* Marks it as recently used */
+  if (ret)
+    g_utime (filename, NULL);
+  g_free (filename);
+
+  return ret;
+}
+
+void
+ges_thumbnail_cache_store (const gchar * key, const gchar * data, gsize size)
+{
+  gchar *filename, *dirname;
+  GError *error = NULL;
+
+  G_LOCK (cache_lock);
+  filename = get_filename (key);
+  dirname = g_strdup (directory);
+  G_UNLOCK (cache_lock);
+
+  GST_LOG ("%s", filename);
+
+  /* g_file_set_contents() writes to a temporary file first, so concurrent
+   * readers never see partial images */
+  if (g_mkdir_with_parents (dirname, 0755) != 0 ||
+      !g_file_set_contents (filename, data, size, &error)) {
+    GST_DEBUG ("Could not store thumbnail in %s: %s", filename,
+        error ? error->message : g_strerror (errno));
+    if (error)
+      g_error_free (error);
+  } else {
+    G_LOCK (cache_lock);
+    if (current_size >= 0)
+      current_size += size;
+    if (current_size < 0 || (guint64) current_size > max_size)
+      trim (max_size);
+    G_UNLOCK (cache_lock);
+  }
+
+  g_free (dirname);
+  g_free (filename);
+}
+
+/**
+ * ges_thumbnail_cache_set_directory:
+ * @path: (allow-none): the directory to store thumbnails in, or %NULL for
+ * the default one
+ *
+ * Sets where the thumbnails saved with ges_timeline_pipeline_save_thumbnail()
+ * are cached. By default they are stored in the
+ * 'gstreamer-editing-services/thumbnails' subdirectory of the user cache
+ * directory.
+ */
+void
+ges_thumbnail_cache_set_directory (const gchar * path)
+{
+  GST_DEBUG ("path:%s", path);
+
+  G_LOCK (cache_lock);
+  g_free (directory);
+  directory = g_strdup (path);
+  current_size = -1;
+  G_UNLOCK (cache_lock);
+}
+
+/**
+ * ges_thumbnail_cache_set_max_size:
+ * @size: the maximum size of the cached thumbnails, in bytes
+ *
+ * Sets how much disk space the thumbnail cache may use. When it uses more,
+ * the least recently used thumbnails are removed. The default is 64 MiB.
+ */
+void
+ges_thumbnail_cache_set_max_size (guint64 size)
+{
+  GST_DEBUG ("size:%" G_GUINT64_FORMAT, size);
+
+  G_LOCK (cache_lock);
+  max_size = size;
+  if (current_size >= 0)
+    trim (max_size);
+  G_UNLOCK (cache_lock);
+}
+
+/**
+ * ges_thumbnail_cache_get_max_size:
+ *
+ * Get the maximum size of the thumbnail cache. See
+ * ges_thumbnail_cache_set_max_size().
+ *
+ * Returns: the maximum size of the cached thumbnails, in bytes.
+ */
+guint64
+ges_thumbnail_cache_get_max_size (void)
+{
+  return max_size;
+}
@@ -67,6 +67,9 @@ enum
 static GESTrackObject
     * ges_timeline_filesource_create_track_object (GESTimelineObject * obj,
     GESTrack * track);
+static gboolean
+ges_timeline_filesource_create_track_objects (GESTimelineObject * obj,
+    GESTrack * track);
 
 static void
 ges_timeline_filesource_get_property (GObject * object, guint property_id,
@@ -216,6 +219,8 @@ ges_timeline_filesource_class_init (GESTimelineFileSourceClass * klass)
 
   timobj_class->create_track_object =
       ges_timeline_filesource_create_track_object;
+  timobj_class->create_track_objects =
+      ges_timeline_filesource_create_track_objects;
   timobj_class->need_fill_track = FALSE;
 }
 
@@ -440,8 +445,9 @@ ges_timeline_filesource_create_track_object (GESTimelineObject * obj,
 
   if (priv->is_image) {
     if (track->type != GES_TRACK_TYPE_VIDEO) {
-      GST_DEBUG ("Object is still image, creating silent audio source");
-      res = (GESTrackObject *) ges_track_audio_test_source_new ();
+      /* The background of the track already plays silence there */
+      GST_DEBUG ("Object is still image, not creating anything");
+      return NULL;
     } else {
       GST_DEBUG ("Creating a GESTrackImageSource");
       res = (GESTrackObject *) ges_track_image_source_new (priv->uri);
@@ -467,6 +473,20 @@ ges_timeline_filesource_create_track_object (GESTimelineObject * obj,
   return res;
 }
 
+static gboolean
+ges_timeline_filesource_create_track_objects (GESTimelineObject * obj,
+    GESTrack * track)
+{
+  GESTimelineFileSourcePrivate *priv = GES_TIMELINE_FILE_SOURCE (obj)->priv;
+
+  /* Still images have nothing to offer to non-video tracks, which is fine */
+  if (priv->is_image && track->type != GES_TRACK_TYPE_VIDEO)
+    return TRUE;
+
+  return GES_TIMELINE_OBJECT_CLASS (ges_timeline_filesource_parent_class)->
+      create_track_objects (obj, track);
+}
+
 /**
  * ges_timeline_filesource_new:
  * @uri: the URI the source should control
@@ -28,6 +28,8 @@
  * same priority within a given timeline.
  */
 
+#include <stdlib.h>
+
 #include "ges-internal.h"
 #include "gesmarshal.h"
 #include "ges-timeline-layer.h"
@@ -40,6 +42,8 @@ struct _GESTimelineLayerPrivate
   /*< private > */
   GSList *objects_start;        /* The TimelineObjects sorted by start and
                                  * priority */
+  GESIntervalTree *index;       /* The TimelineObjects indexed by the time
+                                 * range they cover */
 
   guint32 priority;             /* The priority of the layer within the 
                                  * containing timeline */
@@ -107,6 +111,16 @@ ges_timeline_layer_dispose (GObject * object)
   G_OBJECT_CLASS (ges_timeline_layer_parent_class)->dispose (object);
 }
 
+static void
+ges_timeline_layer_finalize (GObject * object)
+{
+  GESTimelineLayer *layer = GES_TIMELINE_LAYER (object);
+
+  ges_interval_tree_free (layer->priv->index);
+
+  G_OBJECT_CLASS (ges_timeline_layer_parent_class)->finalize (object);
+}
+
 static void
 ges_timeline_layer_class_init (GESTimelineLayerClass * klass)
 {
@@ -117,6 +131,7 @@ ges_timeline_layer_class_init (GESTimelineLayerClass * klass)
   object_class->get_property = ges_timeline_layer_get_property;
   object_class->set_property = ges_timeline_layer_set_property;
   object_class->dispose = ges_timeline_layer_dispose;
+  object_class->finalize = ges_timeline_layer_finalize;
 
   /**
    * GESTimelineLayer:priority
@@ -164,6 +179,8 @@ ges_timeline_layer_init (GESTimelineLayer * self)
   self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
       GES_TYPE_TIMELINE_LAYER, GESTimelineLayerPrivate);
 
+  self->priv->index = ges_interval_tree_new ();
+
   /* TODO : Keep those 3 values in sync */
   self->priv->priority = 0;
   self->min_gnl_priority = 0;
@@ -209,22 +226,31 @@ objects_start_compare (GESTimelineObject * a, GESTimelineObject * b)
   return 0;
 }
 
-/**
- * ges_timeline_layer_add_object:
- * @layer: a #GESTimelineLayer
- * @object: (transfer full): the #GESTimelineObject to add.
- *
- * Adds the given object to the layer. Sets the object's parent, and thus
- * takes ownership of the object.
- *
- * An object can only be added to one layer.
- *
- * Returns: TRUE if the object was properly added to the layer, or FALSE
- * if the @layer refuses to add the object.
- */
+static gint
+objects_start_compare_ptr (GESTimelineObject ** a, GESTimelineObject ** b)
+{
+  return objects_start_compare (*a, *b);
+}
 
-gboolean
-ges_timeline_layer_add_object (GESTimelineLayer * layer,
+/* Opens (or commits) an edit transaction on the timeline @layer belongs to */
+static void
+begin_timeline_update (GESTimelineLayer * layer)
+{
+  if (layer->timeline)
+    ges_timeline_begin_update (layer->timeline);
+}
+
+static void
+commit_timeline_update (GESTimelineLayer * layer)
+{
+  if (layer->timeline)
+    ges_timeline_commit (layer->timeline);
+}
+
+/* Takes ownership of @object and makes it part of @layer, without adding it
+ * to the sorted list of objects nor emitting 'object-added' */
+static gboolean
+ges_timeline_layer_take_object (GESTimelineLayer * layer,
     GESTimelineObject * object)
 {
   GESTimelineLayer *tl_obj_layer;
@@ -241,11 +267,6 @@ ges_timeline_layer_add_object (GESTimelineLayer * layer,
 
   g_object_ref_sink (object);
 
-  /* Take a reference to the object and store it stored by start/priority */
-  layer->priv->objects_start =
-      g_slist_insert_sorted (layer->priv->objects_start, object,
-      (GCompareFunc) objects_start_compare);
-
   /* Inform the object it's now in this layer */
   ges_timeline_object_set_layer (object, layer);
 
@@ -262,12 +283,114 @@ ges_timeline_layer_add_object (GESTimelineLayer * layer,
     ges_timeline_object_set_priority (object, layer->min_gnl_priority);
   }
 
+  ges_interval_tree_insert (layer->priv->index, object, object->start,
+      object->duration);
+
+  return TRUE;
+}
+
+/**
+ * ges_timeline_layer_add_object:
+ * @layer: a #GESTimelineLayer
+ * @object: (transfer full): the #GESTimelineObject to add.
+ *
+ * Adds the given object to the layer. Sets the object's parent, and thus
+ * takes ownership of the object.
+ *
+ * An object can only be added to one layer.
+ *
+ * Returns: TRUE if the object was properly added to the layer, or FALSE
+ * if the @layer refuses to add the object.
+ */
+
+gboolean
+ges_timeline_layer_add_object (GESTimelineLayer * layer,
+    GESTimelineObject * object)
+{
+  if (!ges_timeline_layer_take_object (layer, object))
+    return FALSE;
+
+  /* Store the object sorted by start/priority */
+  layer->priv->objects_start =
+      g_slist_insert_sorted (layer->priv->objects_start, object,
+      (GCompareFunc) objects_start_compare);
+
   /* emit 'object-added' */
   g_signal_emit (layer, ges_timeline_layer_signals[OBJECT_ADDED], 0, object);
 
   return TRUE;
 }
 
+/**
+ * ges_timeline_layer_add_objects:
+ * @layer: a #GESTimelineLayer
+ * @objects: (array length=n_objects) (transfer full): the #GESTimelineObject
+ * to add
+ * @n_objects: the number of objects in @objects
+ *
+ * Adds all the given @objects to the layer, taking ownership of them. This
+ * is equivalent to calling ges_timeline_layer_add_object() for each of them,
+ * but the layer's storage is only sorted once and the compositions of the
+ * timeline's tracks are only updated once all the objects were added.
+ *
+ * The 'object-added' signal is emitted for each object in the order of
+ * @objects.
+ *
+ * Returns: TRUE if all the objects were properly added to the layer, or FALSE
+ * if the @layer refused to add some of them.
+ */
+gboolean
+ges_timeline_layer_add_objects (GESTimelineLayer * layer,
+    GESTimelineObject ** objects, guint n_objects)
+{
+  GESTimelineObject **added, **sorted;
+  GSList *tmp, *merged = NULL;
+  guint i, n = 0;
+  gboolean ret = TRUE;
+
+  g_return_val_if_fail (GES_IS_TIMELINE_LAYER (layer), FALSE);
+  g_return_val_if_fail (objects != NULL || n_objects == 0, FALSE);
+
+  GST_DEBUG ("layer:%p, adding %u objects", layer, n_objects);
+
+  added = g_new (GESTimelineObject *, n_objects);
+  for (i = 0; i < n_objects; i++) {
+    if (ges_timeline_layer_take_object (layer, objects[i]))
+      added[n++] = objects[i];
+    else
+      ret = FALSE;
+  }
+
+  /* Sort the new objects once, and merge them with the existing ones */
+  sorted = g_memdup (added, n * sizeof (GESTimelineObject *));
+  qsort (sorted, n, sizeof (GESTimelineObject *),
+      (GCompareFunc) objects_start_compare_ptr);
+
+  tmp = layer->priv->objects_start;
+  i = 0;
+  while (tmp || i < n) {
+    if (i < n && (!tmp || objects_start_compare (sorted[i], tmp->data) < 0))
+      merged = g_slist_prepend (merged, sorted[i++]);
+    else {
+      merged = g_slist_prepend (merged, tmp->data);
+      tmp = tmp->next;
+    }
+  }
+  g_slist_free (layer->priv->objects_start);
+  layer->priv->objects_start = g_slist_reverse (merged);
+  g_free (sorted);
+
+  /* emit 'object-added', only updating the compositions at the end */
+  begin_timeline_update (layer);
+  for (i = 0; i < n; i++)
+    g_signal_emit (layer, ges_timeline_layer_signals[OBJECT_ADDED], 0,
+        added[i]);
+  commit_timeline_update (layer);
+  g_free (added);
+
+  return ret;
+}
+
 /**
  * ges_timeline_layer_remove_object:
  * @layer: a #GESTimelineLayer
@@ -310,6 +433,7 @@ ges_timeline_layer_remove_object (GESTimelineLayer * layer,
   /* Remove it from our list of controlled objects */
   layer->priv->objects_start =
       g_slist_remove (layer->priv->objects_start, object);
+  ges_interval_tree_remove (layer->priv->index, object);
 
   /* Remove our reference to the object */
   g_object_unref (object);
@@ -317,6 +441,78 @@ ges_timeline_layer_remove_object (GESTimelineLayer * layer,
   return TRUE;
 }
 
+/**
+ * ges_timeline_layer_remove_objects:
+ * @layer: a #GESTimelineLayer
+ * @objects: (array length=n_objects): the #GESTimelineObject to remove
+ * @n_objects: the number of objects in @objects
+ *
+ * Removes all the given @objects from the @layer and unparents them. This
+ * is equivalent to calling ges_timeline_layer_remove_object() for each of
+ * them, but the compositions of the timeline's tracks are only updated once
+ * all the objects were removed.
+ *
+ * Returns: TRUE if all the objects could be removed, FALSE if some of them
+ * did not belong to @layer.
+ */
+gboolean
+ges_timeline_layer_remove_objects (GESTimelineLayer * layer,
+    GESTimelineObject ** objects, guint n_objects)
+{
+  GHashTable *removed;
+  GSList *tmp, *remaining = NULL;
+  guint i;
+  gboolean ret = TRUE;
+
+  g_return_val_if_fail (GES_IS_TIMELINE_LAYER (layer), FALSE);
+  g_return_val_if_fail (objects != NULL || n_objects == 0, FALSE);
+
+  GST_DEBUG ("layer:%p, removing %u objects", layer, n_objects);
+
+  removed = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  begin_timeline_update (layer);
+  for (i = 0; i < n_objects; i++) {
+    GESTimelineObject *object = objects[i];
+    GESTimelineLayer *tl_obj_layer;
+
+    tl_obj_layer = ges_timeline_object_get_layer (object);
+    if (G_UNLIKELY (tl_obj_layer != layer)) {
+      GST_WARNING ("TimelineObject doesn't belong to this layer");
+      if (tl_obj_layer != NULL)
+        g_object_unref (tl_obj_layer);
+      ret = FALSE;
+      continue;
+    }
+    g_object_unref (tl_obj_layer);
+
+    /* emit 'object-removed' */
+    g_signal_emit (layer, ges_timeline_layer_signals[OBJECT_REMOVED], 0,
+        object);
+
+    /* inform the object it's no longer in a layer */
+    ges_timeline_object_set_layer (object, NULL);
+
+    ges_interval_tree_remove (layer->priv->index, object);
+    g_hash_table_insert (removed, object, object);
+  }
+  commit_timeline_update (layer);
+
+  /* Remove them from our list of controlled objects in one pass */
+  for (tmp = layer->priv->objects_start; tmp; tmp = tmp->next) {
+    if (g_hash_table_lookup (removed, tmp->data))
+      g_object_unref (tmp->data);
+    else
+      remaining = g_slist_prepend (remaining, tmp->data);
+  }
+  g_slist_free (layer->priv->objects_start);
+  layer->priv->objects_start = g_slist_reverse (remaining);
+
+  g_hash_table_destroy (removed);
+
+  return ret;
+}
+
 /**
  * ges_timeline_layer_resync_priorities:
  * @layer: a #GESTimelineLayer
@@ -329,17 +525,15 @@ ges_timeline_layer_resync_priorities (GESTimelineLayer * layer)
 {
   GSList *tmp;
 
-  /* TODO : Inhibit composition updates while doing this.
-   * Ideally we want to do it from an even higher level, but here will
-   * do in the meantime. */
-
   /* TODO : This is the dumb version where we put everything linearly,
    * will need to be adjusted for more complex usages (like with
    * transitions).  */
+  begin_timeline_update (layer);
   for (tmp = layer->priv->objects_start; tmp; tmp = tmp->next) {
     ges_timeline_object_set_priority ((GESTimelineObject *) tmp->data,
         layer->min_gnl_priority);
   }
+  commit_timeline_update (layer);
 
   return TRUE;
 }
@@ -419,3 +613,51 @@ ges_timeline_layer_get_objects (GESTimelineLayer * layer)
   ret = g_list_reverse (ret);
   return ret;
 }
+
+/**
+ * ges_timeline_layer_get_objects_in_range:
+ * @layer: a #GESTimelineLayer
+ * @start: the start of the range, in nanoseconds
+ * @end: the end of the range, in nanoseconds
+ *
+ * Get the timeline objects of @layer that are playing at some point
+ * between @start and @end, both included. An object plays from its start
+ * until (but not including) its start plus its duration. Passing the same
+ * value for @start and @end returns the objects playing at that position.
+ *
+ * The objects are looked up in an index, so this is much cheaper than
+ * going over the result of ges_timeline_layer_get_objects().
+ *
+ * Returns: (transfer full) (element-type GESTimelineObject): a #GList of
+ * timeline objects sorted by start. The user is responsible for
+ * unreffing the contained objects and freeing the list.
+ */
+
+GList *
+ges_timeline_layer_get_objects_in_range (GESTimelineLayer * layer,
+    guint64 start, guint64 end)
+{
+  GList *ret, *tmp;
+
+  g_return_val_if_fail (GES_IS_TIMELINE_LAYER (layer), NULL);
+  g_return_val_if_fail (start <= end, NULL);
+
+  ret = ges_interval_tree_query (layer->priv->index, start, end);
+
+  for (tmp = ret; tmp; tmp = tmp->next)
+    g_object_ref (tmp->data);
+
+  return ret;
+}
+
+void
+ges_timeline_layer_object_time_changed (GESTimelineLayer * layer,
+    GESTimelineObject * object)
+{
+  GST_LOG ("layer:%p, object:%p, start:%" GST_TIME_FORMAT ", duration:%"
+      GST_TIME_FORMAT, layer, object, GST_TIME_ARGS (object->start),
+      GST_TIME_ARGS (object->duration));
+
+  ges_interval_tree_update (layer->priv->index, object, object->start,
+      object->duration);
+}
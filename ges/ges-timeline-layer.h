@@ -99,11 +99,20 @@ gboolean ges_timeline_layer_add_object    (GESTimelineLayer * layer,
 					   GESTimelineObject * object);
 gboolean ges_timeline_layer_remove_object (GESTimelineLayer * layer,
 					   GESTimelineObject * object);
+gboolean ges_timeline_layer_add_objects   (GESTimelineLayer * layer,
+					   GESTimelineObject ** objects,
+					   guint n_objects);
+gboolean ges_timeline_layer_remove_objects (GESTimelineLayer * layer,
+					    GESTimelineObject ** objects,
+					    guint n_objects);
 
 void     ges_timeline_layer_set_priority  (GESTimelineLayer * layer,
 					   guint priority);
 guint    ges_timeline_layer_get_priority  (GESTimelineLayer * layer);
 GList*   ges_timeline_layer_get_objects   (GESTimelineLayer * layer);
+GList*   ges_timeline_layer_get_objects_in_range (GESTimelineLayer * layer,
+						  guint64 start,
+						  guint64 end);
 
 G_END_DECLS
 
@@ -92,7 +92,8 @@ struct _GESTimelineObjectPrivate
    */
   gboolean ignore_notifies;
 
-  GList *mappings;
+  /* GESTrackObject => ObjectMapping */
+  GHashTable *mappings;
 };
 
 enum
@@ -163,6 +164,22 @@ ges_timeline_object_set_property (GObject * object, guint property_id,
   }
 }
 
+static void
+free_mapping (ObjectMapping * mapping)
+{
+  g_slice_free (ObjectMapping, mapping);
+}
+
+static void
+ges_timeline_object_finalize (GObject * object)
+{
+  GESTimelineObject *self = GES_TIMELINE_OBJECT (object);
+
+  g_hash_table_destroy (self->priv->mappings);
+
+  G_OBJECT_CLASS (ges_timeline_object_parent_class)->finalize (object);
+}
+
 static void
 ges_timeline_object_class_init (GESTimelineObjectClass * klass)
 {
@@ -172,6 +189,7 @@ ges_timeline_object_class_init (GESTimelineObjectClass * klass)
 
   object_class->get_property = ges_timeline_object_get_property;
   object_class->set_property = ges_timeline_object_set_property;
+  object_class->finalize = ges_timeline_object_finalize;
   klass->create_track_objects = ges_timeline_object_create_track_objects_func;
 
   /**
@@ -254,6 +272,8 @@ ges_timeline_object_init (GESTimelineObject * self)
   self->height = 1;
   self->priv->trackobjects = NULL;
   self->priv->layer = NULL;
+  self->priv->mappings = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+      NULL, (GDestroyNotify) free_mapping);
 }
 
 /**
@@ -366,7 +386,7 @@ ges_timeline_object_add_track_object (GESTimelineObject * object, GESTrackObject
 
   mapping = g_slice_new0 (ObjectMapping);
   mapping->object = trobj;
-  object->priv->mappings = g_list_append (object->priv->mappings, mapping);
+  g_hash_table_insert (object->priv->mappings, trobj, mapping);
 
   GST_DEBUG ("Adding TrackObject to the list of controlled track objects");
   /* We steal the initial reference */
@@ -412,8 +432,7 @@ gboolean
 ges_timeline_object_release_track_object (GESTimelineObject * object,
     GESTrackObject * trackobject)
 {
-  GList *tmp;
-  ObjectMapping *mapping = NULL;
+  ObjectMapping *mapping;
 
   GST_DEBUG ("object:%p, trackobject:%p", object, trackobject);
 
@@ -425,13 +444,8 @@ ges_timeline_object_release_track_object (GESTimelineObject * object,
   /* FIXME : Do we need to tell the subclasses ?
    * If so, add a new virtual-method */
 
-  for (tmp = object->priv->mappings; tmp; tmp = tmp->next) {
-    mapping = (ObjectMapping *) tmp->data;
-    if (mapping->object == trackobject)
-      break;
-  }
-
-  if (tmp && mapping) {
+  mapping = g_hash_table_lookup (object->priv->mappings, trackobject);
+  if (mapping) {
 
     /* Disconnect all notify listeners */
     g_signal_handler_disconnect (trackobject, mapping->start_notifyid);
@@ -439,9 +453,7 @@ ges_timeline_object_release_track_object (GESTimelineObject * object,
     g_signal_handler_disconnect (trackobject, mapping->inpoint_notifyid);
     g_signal_handler_disconnect (trackobject, mapping->priority_notifyid);
 
-    g_slice_free (ObjectMapping, mapping);
-
-    object->priv->mappings = g_list_delete_link (object->priv->mappings, tmp);
+    g_hash_table_remove (object->priv->mappings, trackobject);
   }
 
   object->priv->trackobjects =
@@ -502,18 +514,10 @@ ges_timeline_object_fill_track_object_func (GESTimelineObject * object,
   return FALSE;
 }
 
-static ObjectMapping *
+static inline ObjectMapping *
 find_object_mapping (GESTimelineObject * object, GESTrackObject * child)
 {
-  GList *tmp;
-
-  for (tmp = object->priv->mappings; tmp; tmp = tmp->next) {
-    ObjectMapping *map = (ObjectMapping *) tmp->data;
-    if (map->object == child)
-      return map;
-  }
-
-  return NULL;
+  return g_hash_table_lookup (object->priv->mappings, child);
 }
 
 /**
@@ -551,6 +555,9 @@ ges_timeline_object_set_start (GESTimelineObject * object, guint64 start)
   object->priv->ignore_notifies = FALSE;
 
   object->start = start;
+
+  if (object->priv->layer)
+    ges_timeline_layer_object_time_changed (object->priv->layer, object);
 }
 
 /**
@@ -606,6 +613,9 @@ ges_timeline_object_set_duration (GESTimelineObject * object, guint64 duration)
   }
 
   object->duration = duration;
+
+  if (object->priv->layer)
+    ges_timeline_layer_object_time_changed (object->priv->layer, object);
 }
 
 /**
@@ -645,6 +655,80 @@ ges_timeline_object_set_priority (GESTimelineObject * object, guint priority)
   object->priority = priority;
 }
 
+/**
+ * ges_timeline_object_set_timing:
+ * @object: a #GESTimelineObject
+ * @start: the position in #GstClockTime
+ * @inpoint: the in-point in #GstClockTime
+ * @duration: the duration in #GstClockTime
+ * @priority: the priority
+ *
+ * Sets the start, in-point, duration and priority of @object at once. This
+ * is equivalent to calling ges_timeline_object_set_start(),
+ * ges_timeline_object_set_inpoint(), ges_timeline_object_set_duration() and
+ * ges_timeline_object_set_priority(), but each #GESTrackObject is only
+ * updated once, and the property notifications of @object are emitted after
+ * all the values were applied.
+ */
+void
+ges_timeline_object_set_timing (GESTimelineObject * object, guint64 start,
+    guint64 inpoint, guint64 duration, guint priority)
+{
+  GList *tmp;
+  GESTrackObject *tr;
+  ObjectMapping *map;
+
+  g_return_if_fail (GES_IS_TIMELINE_OBJECT (object));
+
+  GST_DEBUG ("object:%p, start:%" GST_TIME_FORMAT ", inpoint:%"
+      GST_TIME_FORMAT ", duration:%" GST_TIME_FORMAT ", priority:%d", object,
+      GST_TIME_ARGS (start), GST_TIME_ARGS (inpoint), GST_TIME_ARGS (duration),
+      priority);
+
+  g_object_freeze_notify (G_OBJECT (object));
+
+  object->priv->ignore_notifies = TRUE;
+
+  for (tmp = object->priv->trackobjects; tmp; tmp = g_list_next (tmp)) {
+    tr = (GESTrackObject *) tmp->data;
+    map = find_object_mapping (object, tr);
+
+    if (ges_track_object_is_locked (tr)) {
+      /* Move the child... */
+      ges_track_object_set_timing (tr, start + map->start_offset, inpoint,
+          duration, priority + map->priority_offset);
+    } else {
+      /* ... or update the offsets */
+      map->start_offset = start - tr->start;
+      map->priority_offset = priority - tr->priority;
+    }
+  }
+
+  object->priv->ignore_notifies = FALSE;
+
+  if (object->start != start) {
+    object->start = start;
+    g_object_notify (G_OBJECT (object), "start");
+  }
+  if (object->inpoint != inpoint) {
+    object->inpoint = inpoint;
+    g_object_notify (G_OBJECT (object), "in-point");
+  }
+  if (object->duration != duration) {
+    object->duration = duration;
+    g_object_notify (G_OBJECT (object), "duration");
+  }
+  if (object->priority != priority) {
+    object->priority = priority;
+    g_object_notify (G_OBJECT (object), "priority");
+  }
+
+  if (object->priv->layer)
+    ges_timeline_layer_object_time_changed (object->priv->layer, object);
+
+  g_object_thaw_notify (G_OBJECT (object));
+}
+
 /**
  * ges_timeline_object_find_track_object:
  * @object: a #GESTimelineObject
@@ -207,6 +207,9 @@ void ges_timeline_object_set_start (GESTimelineObject * object, guint64 start);
 void ges_timeline_object_set_inpoint (GESTimelineObject * object, guint64 inpoint);
 void ges_timeline_object_set_duration (GESTimelineObject * object, guint64 duration);
 void ges_timeline_object_set_priority (GESTimelineObject * object, guint priority);
+void ges_timeline_object_set_timing (GESTimelineObject * object, guint64 start,
+                                     guint64 inpoint, guint64 duration,
+                                     guint priority);
 
 void ges_timeline_object_set_layer (GESTimelineObject * object,
                    GESTimelineLayer * layer);
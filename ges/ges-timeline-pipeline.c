@@ -29,23 +29,43 @@
 
 #include <gst/gst.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "ges-internal.h"
 #include "ges-timeline-pipeline.h"
 #include "ges-screenshot.h"
 
 #define DEFAULT_TIMELINE_MODE  TIMELINE_MODE_PREVIEW
 
+/* How long we wait for the pipeline to preroll at a thumbnail position */
+#define THUMBNAIL_TIMEOUT (10 * GST_SECOND)
+
+/* Default limits of the queues decoupling decoding from encoding in
+ * pipelines created for rendering only. Decoders run ahead of the encoders
+ * by up to that much media, whatever the size of the buffers. */
+#define DEFAULT_RENDER_QUEUE_BUFFERS 0
+#define DEFAULT_RENDER_QUEUE_BYTES 0
+#define DEFAULT_RENDER_QUEUE_TIME (2 * GST_SECOND)
+
 /* Structure corresponding to a timeline - sink link */
 
 typedef struct
 {
   GESTrack *track;
   GstElement *tee;
+  GstElement *queue;            /* Replaces the tee when rendering only */
   GstPad *srcpad;               /* Timeline source pad */
   GstPad *playsinkpad;
   GstPad *encodebinpad;
 } OutputChain;
 
+/* Limits of the render queue of a track */
+typedef struct
+{
+  guint max_buffers;
+  guint max_bytes;
+  guint64 max_time;
+} RenderQueueLimits;
+
 G_DEFINE_TYPE (GESTimelinePipeline, ges_timeline_pipeline, GST_TYPE_PIPELINE);
 
 struct _GESTimelinePipelinePrivate
@@ -56,22 +76,47 @@ struct _GESTimelinePipelinePrivate
   /* Note : urisink is only created when a URI has been provided */
   GstElement *urisink;
 
+  /* Created with ges_timeline_pipeline_new_for_render(), never previews */
+  gboolean headless;
+  /* RenderQueueLimits of the tracks, by GESTrack */
+  GHashTable *render_queues;
+
   GESPipelineFlags mode;
 
   GList *chains;
 
   GstEncodingProfile *profile;
+
+  /* Restriction caps of the video tracks when previewing */
+  GstCaps *preview_caps;
+  /* Whether the tracks use proxies when previewing */
+  gboolean use_proxies;
+
+  /* Frame converters of the thumbnails, by output caps string */
+  GHashTable *converters;
+
+  /* Scrubbing, protected by the object lock */
+  gboolean scrubbing;
+  gboolean scrub_snap;          /* Seek to keyframes while scrubbing */
+  gboolean seek_in_flight;      /* Waiting for a seek to preroll */
+  GstEvent *pending_seek;       /* Latest seek requested meanwhile */
+  gint64 scrub_position;        /* Latest position requested */
+  guint scrub_idle;
 };
 
 static GstStateChangeReturn ges_timeline_pipeline_change_state (GstElement *
     element, GstStateChange transition);
+static gboolean save_thumbnail (GESTimelinePipeline * self, const gchar * key,
+    int width, int height, const gchar * format, const gchar * location);
 
 static OutputChain *get_output_chain_for_track (GESTimelinePipeline * self,
     GESTrack * track);
 static OutputChain *new_output_chain_for_track (GESTimelinePipeline * self,
     GESTrack * track);
-static gboolean play_sink_multiple_seeks_send_event (GstElement * element,
+static gboolean ges_timeline_pipeline_send_event (GstElement * element,
     GstEvent * event);
+static void ges_timeline_pipeline_handle_message (GstBin * bin,
+    GstMessage * message);
 
 static void
 ges_timeline_pipeline_dispose (GObject * object)
@@ -99,6 +144,27 @@ ges_timeline_pipeline_dispose (GObject * object)
     self->priv->profile = NULL;
   }
 
+  if (self->priv->preview_caps) {
+    gst_caps_unref (self->priv->preview_caps);
+    self->priv->preview_caps = NULL;
+  }
+
+  if (self->priv->converters) {
+    g_hash_table_destroy (self->priv->converters);
+    self->priv->converters = NULL;
+  }
+
+  if (self->priv->render_queues) {
+    g_hash_table_destroy (self->priv->render_queues);
+    self->priv->render_queues = NULL;
+  }
+
+  if (self->priv->scrub_idle) {
+    g_source_remove (self->priv->scrub_idle);
+    self->priv->scrub_idle = 0;
+  }
+  gst_event_replace (&self->priv->pending_seek, NULL);
+
   G_OBJECT_CLASS (ges_timeline_pipeline_parent_class)->dispose (object);
 }
 
@@ -107,6 +173,7 @@ ges_timeline_pipeline_class_init (GESTimelinePipelineClass * klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstBinClass *bin_class = GST_BIN_CLASS (klass);
 
   g_type_class_add_private (klass, sizeof (GESTimelinePipelinePrivate));
 
@@ -114,6 +181,10 @@ ges_timeline_pipeline_class_init (GESTimelinePipelineClass * klass)
 
   element_class->change_state =
       GST_DEBUG_FUNCPTR (ges_timeline_pipeline_change_state);
+  element_class->send_event =
+      GST_DEBUG_FUNCPTR (ges_timeline_pipeline_send_event);
+  bin_class->handle_message =
+      GST_DEBUG_FUNCPTR (ges_timeline_pipeline_handle_message);
 
   /* TODO : Add state_change handlers
    * Don't change state if we don't have a timeline */
@@ -122,14 +193,10 @@ ges_timeline_pipeline_class_init (GESTimelinePipelineClass * klass)
 static void
 ges_timeline_pipeline_init (GESTimelinePipeline * self)
 {
-  GstElementClass *playsinkclass;
-
-  GST_INFO_OBJECT (self, "Creating new 'playsink'");
   self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
       GES_TYPE_TIMELINE_PIPELINE, GESTimelinePipelinePrivate);
 
-  self->priv->playsink =
-      gst_element_factory_make ("playsink", "internal-sinks");
+  /* playsink is only created when previewing */
   self->priv->encodebin =
       gst_element_factory_make ("encodebin", "internal-encodebin");
   /* Limit encodebin buffering to 1 buffer since we know the various
@@ -138,18 +205,8 @@ ges_timeline_pipeline_init (GESTimelinePipeline * self)
       "queue-bytes-max", (guint32) 0, "queue-time-max", (guint64) 0,
       "avoid-reencoding", TRUE, NULL);
 
-  if (G_UNLIKELY (self->priv->playsink == NULL))
-    GST_ERROR_OBJECT (self, "Can't create playsink instance !");
   if (G_UNLIKELY (self->priv->encodebin == NULL))
     GST_ERROR_OBJECT (self, "Can't create encodebin instance !");
-  return;
-
-  /* HACK : Intercept events going through playsink */
-  playsinkclass = GST_ELEMENT_GET_CLASS (self->priv->playsink);
-  /* Replace playsink's GstBin::send_event with our own */
-  playsinkclass->send_event = play_sink_multiple_seeks_send_event;
-
-  ges_timeline_pipeline_set_mode (self, DEFAULT_TIMELINE_MODE);
 }
 
 /**
@@ -162,13 +219,139 @@ ges_timeline_pipeline_init (GESTimelinePipeline * self)
 GESTimelinePipeline *
 ges_timeline_pipeline_new (void)
 {
-  return g_object_new (GES_TYPE_TIMELINE_PIPELINE, NULL);
+  GESTimelinePipeline *pipeline;
+
+  pipeline = g_object_new (GES_TYPE_TIMELINE_PIPELINE, NULL);
+  ges_timeline_pipeline_set_mode (pipeline, DEFAULT_TIMELINE_MODE);
+
+  return pipeline;
+}
+
+/**
+ * ges_timeline_pipeline_new_for_render:
+ *
+ * Creates a new #GESTimelinePipeline which can only render timelines, for
+ * example on a machine without any display or sound card. It never creates
+ * a playsink, and only accepts the %TIMELINE_MODE_RENDER and
+ * %TIMELINE_MODE_SMART_RENDER modes, which have to be set after
+ * ges_timeline_pipeline_set_render_settings().
+ *
+ * Each track is linked to the encoder through a single queue, whose limits
+ * can be set with ges_timeline_pipeline_set_render_queue(), instead of
+ * being teed for previewing. No thumbnail can be taken from such a
+ * pipeline.
+ *
+ * Returns: the new #GESTimelinePipeline.
+ */
+GESTimelinePipeline *
+ges_timeline_pipeline_new_for_render (void)
+{
+  GESTimelinePipeline *pipeline;
+
+  pipeline = g_object_new (GES_TYPE_TIMELINE_PIPELINE, NULL);
+  pipeline->priv->headless = TRUE;
+
+  return pipeline;
 }
 
 #define TRACK_COMPATIBLE_PROFILE(tracktype, profile)			\
   ( (GST_IS_ENCODING_AUDIO_PROFILE (profile) && (tracktype) == GES_TRACK_TYPE_AUDIO) || \
     (GST_IS_ENCODING_VIDEO_PROFILE (profile) && (tracktype) == GES_TRACK_TYPE_VIDEO))
 
+/* Whether playsink outputs the contents of @track in the current mode */
+static gboolean
+preview_uses_track (GESTimelinePipeline * self, GESTrack * track)
+{
+  switch (track->type) {
+    case GES_TRACK_TYPE_VIDEO:
+      return (self->priv->mode & TIMELINE_MODE_PREVIEW_VIDEO) != 0;
+    case GES_TRACK_TYPE_AUDIO:
+      return (self->priv->mode & TIMELINE_MODE_PREVIEW_AUDIO) != 0;
+    case GES_TRACK_TYPE_TEXT:
+      return (self->priv->mode & TIMELINE_MODE_PREVIEW) != 0;
+    default:
+      return FALSE;
+  }
+}
+
+/* Whether encodebin encodes the contents of @track in the current mode, that
+ * is if the encoding profile has a stream for it */
+static gboolean
+render_uses_track (GESTimelinePipeline * self, GESTrack * track)
+{
+  GstEncodingProfile *profile = self->priv->profile;
+  const GList *tmp;
+
+  if (!(self->priv->mode & (TIMELINE_MODE_RENDER | TIMELINE_MODE_SMART_RENDER)))
+    return FALSE;
+
+  if (profile == NULL)
+    return TRUE;
+
+  if (!GST_IS_ENCODING_CONTAINER_PROFILE (profile))
+    return TRACK_COMPATIBLE_PROFILE (track->type, profile);
+
+  for (tmp = gst_encoding_container_profile_get_profiles (
+          (GstEncodingContainerProfile *) profile); tmp; tmp = tmp->next)
+    if (TRACK_COMPATIBLE_PROFILE (track->type, tmp->data))
+      return TRUE;
+
+  return FALSE;
+}
+
+/* Deactivates the tracks the current mode doesn't output, so that their
+ * sources aren't even created, and activates back the others */
+static void
+ges_timeline_pipeline_update_track_activation (GESTimelinePipeline * self)
+{
+  GList *tmp, *tracks;
+
+  if (self->priv->timeline == NULL)
+    return;
+
+  tracks = ges_timeline_get_tracks (self->priv->timeline);
+  for (tmp = tracks; tmp; tmp = tmp->next) {
+    GESTrack *track = (GESTrack *) tmp->data;
+    gboolean active = preview_uses_track (self, track) ||
+        render_uses_track (self, track);
+
+    GST_DEBUG_OBJECT (self, "track %p active:%d", track, active);
+    ges_track_set_active (track, active);
+    g_object_unref (track);
+  }
+  g_list_free (tracks);
+}
+
+/* Previewing uses the preview caps and proxies, rendering always runs at
+ * full quality from the original media */
+static void
+ges_timeline_pipeline_update_preview_settings (GESTimelinePipeline * self)
+{
+  GList *tmp, *tracks;
+  GstCaps *caps = NULL;
+  gboolean use_proxies = FALSE;
+
+  if (self->priv->timeline == NULL)
+    return;
+
+  if (!(self->priv->mode &
+          (TIMELINE_MODE_RENDER | TIMELINE_MODE_SMART_RENDER))) {
+    caps = self->priv->preview_caps;
+    use_proxies = self->priv->use_proxies;
+  }
+
+  tracks = ges_timeline_get_tracks (self->priv->timeline);
+  for (tmp = tracks; tmp; tmp = tmp->next) {
+    GESTrack *track = (GESTrack *) tmp->data;
+
+    if (track->type == GES_TRACK_TYPE_VIDEO)
+      ges_track_set_restriction_caps (track, caps);
+    ges_track_set_use_proxies (track, use_proxies);
+    g_object_unref (track);
+  }
+  g_list_free (tracks);
+}
+
 static gboolean
 ges_timeline_pipeline_update_caps (GESTimelinePipeline * self)
 {
@@ -199,6 +382,9 @@ ges_timeline_pipeline_update_caps (GESTimelinePipeline * self)
         if (self->priv->mode == TIMELINE_MODE_SMART_RENDER) {
           GstCaps *ocaps, *rcaps;
 
+          /* The file sources no operation plays over then output the
+           * format of the profile without decoding it, encodebin only
+           * re-encoding what's needed around the cuts */
           GST_DEBUG ("Smart Render mode, setting input caps");
           ocaps = gst_encoding_profile_get_input_caps (prof);
           if (track->type == GES_TRACK_TYPE_AUDIO)
@@ -207,6 +393,7 @@ ges_timeline_pipeline_update_caps (GESTimelinePipeline * self)
             rcaps = gst_caps_from_string ("video/x-raw-yuv;video/x-raw-rgb");
           gst_caps_append (ocaps, rcaps);
           ges_track_set_caps (track, ocaps);
+          gst_caps_unref (ocaps);
         } else {
           GstCaps *caps = NULL;
 
@@ -214,7 +401,7 @@ ges_timeline_pipeline_update_caps (GESTimelinePipeline * self)
           if (track->type == GES_TRACK_TYPE_VIDEO)
             caps = gst_caps_from_string ("video/x-raw-yuv;video/x-raw-rgb");
           else if (track->type == GES_TRACK_TYPE_AUDIO)
-            gst_caps_from_string ("audio/x-raw-int;audio/x-raw-float");
+            caps = gst_caps_from_string ("audio/x-raw-int;audio/x-raw-float");
 
           if (caps) {
             ges_track_set_caps (track, caps);
@@ -261,6 +448,9 @@ ges_timeline_pipeline_change_state (GstElement * element,
         ret = GST_STATE_CHANGE_FAILURE;
         goto done;
       }
+      /* Tracks might have been added since the mode was set */
+      ges_timeline_pipeline_update_preview_settings (self);
+      ges_timeline_pipeline_update_track_activation (self);
       /* Set caps on all tracks according to profile if present */
       /* FIXME : Add a new SMART_RENDER mode to avoid decoding */
       break;
@@ -361,6 +551,25 @@ get_compatible_unlinked_pad (GstElement * element, GstPad * pad)
   return res;
 }
 
+static void
+apply_render_queue_limits (GESTimelinePipeline * self, OutputChain * chain)
+{
+  RenderQueueLimits *limits = NULL;
+
+  if (self->priv->render_queues)
+    limits = g_hash_table_lookup (self->priv->render_queues, chain->track);
+
+  if (limits)
+    g_object_set (chain->queue, "max-size-buffers", limits->max_buffers,
+        "max-size-bytes", limits->max_bytes, "max-size-time",
+        limits->max_time, NULL);
+  else
+    g_object_set (chain->queue, "max-size-buffers",
+        DEFAULT_RENDER_QUEUE_BUFFERS, "max-size-bytes",
+        DEFAULT_RENDER_QUEUE_BYTES, "max-size-time",
+        (guint64) DEFAULT_RENDER_QUEUE_TIME, NULL);
+}
+
 static void
 pad_added_cb (GstElement * timeline, GstPad * pad, GESTimelinePipeline * self)
 {
@@ -368,6 +577,7 @@ pad_added_cb (GstElement * timeline, GstPad * pad, GESTimelinePipeline * self)
   GESTrack *track;
   GstPad *sinkpad;
   gboolean reconfigured = FALSE;
+  gboolean preview, render;
 
   GST_DEBUG_OBJECT (self, "new pad %s:%s , caps:%" GST_PTR_FORMAT,
       GST_DEBUG_PAD_NAME (pad), GST_PAD_CAPS (pad));
@@ -378,18 +588,12 @@ pad_added_cb (GstElement * timeline, GstPad * pad, GESTimelinePipeline * self)
     return;
   }
 
-  /* Don't connect track if it's not going to be used */
-  if (track->type == GES_TRACK_TYPE_VIDEO &&
-      !(self->priv->mode & TIMELINE_MODE_PREVIEW_VIDEO) &&
-      !(self->priv->mode & TIMELINE_MODE_RENDER) &&
-      !(self->priv->mode & TIMELINE_MODE_SMART_RENDER)) {
-    GST_DEBUG_OBJECT (self, "Video track... but we don't need it. Not linking");
-  }
-  if (track->type == GES_TRACK_TYPE_AUDIO &&
-      !(self->priv->mode & TIMELINE_MODE_PREVIEW_AUDIO) &&
-      !(self->priv->mode & TIMELINE_MODE_RENDER) &&
-      !(self->priv->mode & TIMELINE_MODE_SMART_RENDER)) {
-    GST_DEBUG_OBJECT (self, "Audio track... but we don't need it. Not linking");
+  /* Unused tracks are normally deactivated before they expose any pad */
+  preview = preview_uses_track (self, track);
+  render = render_uses_track (self, track);
+  if (!preview && !render) {
+    GST_DEBUG_OBJECT (self, "Track %p isn't used. Not linking", track);
+    return;
   }
 
   /* Get an existing chain or create it */
@@ -397,18 +601,30 @@ pad_added_cb (GstElement * timeline, GstPad * pad, GESTimelinePipeline * self)
     chain = new_output_chain_for_track (self, track);
   chain->srcpad = pad;
 
-  /* Adding tee */
-  chain->tee = gst_element_factory_make ("tee", NULL);
-  gst_bin_add (GST_BIN_CAST (self), chain->tee);
-  gst_element_sync_state_with_parent (chain->tee);
+  if (self->priv->headless) {
+    /* Nothing but encodebin ever consumes the track */
+    chain->queue = gst_element_factory_make ("queue", NULL);
+    apply_render_queue_limits (self, chain);
+    gst_bin_add (GST_BIN_CAST (self), chain->queue);
+    gst_element_sync_state_with_parent (chain->queue);
+
+    sinkpad = gst_element_get_static_pad (chain->queue, "sink");
+  } else {
+    /* Adding tee */
+    chain->tee = gst_element_factory_make ("tee", NULL);
+    gst_bin_add (GST_BIN_CAST (self), chain->tee);
+    gst_element_sync_state_with_parent (chain->tee);
+
+    sinkpad = gst_element_get_static_pad (chain->tee, "sink");
+  }
 
-  /* Linking pad to tee */
-  sinkpad = gst_element_get_static_pad (chain->tee, "sink");
+  /* Linking pad to tee or queue */
   gst_pad_link_full (pad, sinkpad, GST_PAD_LINK_CHECK_NOTHING);
   gst_object_unref (sinkpad);
+  sinkpad = NULL;
 
   /* Connect playsink */
-  if (self->priv->mode & TIMELINE_MODE_PREVIEW) {
+  if (preview) {
     const gchar *sinkpad_name;
     GstPad *tmppad;
 
@@ -458,7 +674,7 @@ pad_added_cb (GstElement * timeline, GstPad * pad, GESTimelinePipeline * self)
   }
 
   /* Connect to encodebin */
-  if (self->priv->mode & (TIMELINE_MODE_RENDER | TIMELINE_MODE_SMART_RENDER)) {
+  if (render) {
     GstPad *tmppad;
     GST_DEBUG_OBJECT (self, "Connecting to encodebin");
 
@@ -480,7 +696,10 @@ pad_added_cb (GstElement * timeline, GstPad * pad, GESTimelinePipeline * self)
       chain->encodebinpad = sinkpad;
     }
 
-    tmppad = gst_element_get_request_pad (chain->tee, "src%d");
+    if (chain->queue)
+      tmppad = gst_element_get_static_pad (chain->queue, "src");
+    else
+      tmppad = gst_element_get_request_pad (chain->tee, "src%d");
     if (G_UNLIKELY (gst_pad_link_full (tmppad,
                 chain->encodebinpad,
                 GST_PAD_LINK_CHECK_NOTHING) != GST_PAD_LINK_OK)) {
@@ -503,6 +722,9 @@ error:
     if (chain->tee) {
       gst_bin_remove (GST_BIN_CAST (self), chain->tee);
     }
+    if (chain->queue) {
+      gst_bin_remove (GST_BIN_CAST (self), chain->queue);
+    }
     if (sinkpad)
       gst_object_unref (sinkpad);
     g_free (chain);
@@ -514,6 +736,7 @@ pad_removed_cb (GstElement * timeline, GstPad * pad, GESTimelinePipeline * self)
 {
   OutputChain *chain;
   GESTrack *track;
+  GstElement *head;
   GstPad *peer;
 
   GST_DEBUG_OBJECT (self, "pad removed %s:%s", GST_DEBUG_PAD_NAME (pad));
@@ -547,12 +770,13 @@ pad_removed_cb (GstElement * timeline, GstPad * pad, GESTimelinePipeline * self)
     gst_object_unref (chain->playsinkpad);
   }
 
-  /* Unlike/remove tee */
-  peer = gst_element_get_static_pad (chain->tee, "sink");
+  /* Unlink/remove tee or queue */
+  head = chain->tee ? chain->tee : chain->queue;
+  peer = gst_element_get_static_pad (head, "sink");
   gst_pad_unlink (pad, peer);
   gst_object_unref (peer);
-  gst_element_set_state (chain->tee, GST_STATE_NULL);
-  gst_bin_remove (GST_BIN (self), chain->tee);
+  gst_element_set_state (head, GST_STATE_NULL);
+  gst_bin_remove (GST_BIN (self), head);
 
   self->priv->chains = g_list_remove (self->priv->chains, chain);
   g_free (chain);
@@ -592,9 +816,68 @@ ges_timeline_pipeline_add_timeline (GESTimelinePipeline * pipeline,
   g_signal_connect (timeline, "pad-removed", (GCallback) pad_removed_cb,
       pipeline);
 
+  ges_timeline_pipeline_update_preview_settings (pipeline);
+
   return TRUE;
 }
 
+/**
+ * ges_timeline_pipeline_set_preview_caps:
+ * @pipeline: a #GESTimelinePipeline
+ * @caps: (allow-none): the format to preview video in, or %NULL to preview
+ * at the native resolution of the sources
+ *
+ * Specify the quality at which the timeline is previewed, for example
+ * 'video/x-raw-yuv,width=640,height=360,framerate=25/1'. Only the fields of
+ * @caps are taken into account.
+ *
+ * They are set as the #GESTrack:restriction-caps of the video tracks of the
+ * timeline while in a preview mode, so that sources get scaled once right
+ * after being decoded and transitions, overlays and mixing work on small
+ * frames. Rendering modes always use the native resolution.
+ */
+void
+ges_timeline_pipeline_set_preview_caps (GESTimelinePipeline * pipeline,
+    const GstCaps * caps)
+{
+  g_return_if_fail (GES_IS_TIMELINE_PIPELINE (pipeline));
+
+  GST_DEBUG_OBJECT (pipeline, "caps:%" GST_PTR_FORMAT, caps);
+
+  if (pipeline->priv->preview_caps)
+    gst_caps_unref (pipeline->priv->preview_caps);
+  pipeline->priv->preview_caps = caps ? gst_caps_copy (caps) : NULL;
+
+  ges_timeline_pipeline_update_preview_settings (pipeline);
+}
+
+/**
+ * ges_timeline_pipeline_set_use_proxies:
+ * @pipeline: a #GESTimelinePipeline
+ * @use_proxies: whether to preview the file sources from proxies
+ *
+ * Specify whether the file sources of the timeline are previewed from low
+ * resolution proxies of their media, which are much cheaper to decode and
+ * seek in. Proxies are transcoded in the background the first time they
+ * are needed, and sources switch to them as soon as they are ready.
+ *
+ * This sets the #GESTrack:use-proxies property of the tracks of the
+ * timeline while in a preview mode. Rendering modes always use the
+ * original media, with the same timing.
+ */
+void
+ges_timeline_pipeline_set_use_proxies (GESTimelinePipeline * pipeline,
+    gboolean use_proxies)
+{
+  g_return_if_fail (GES_IS_TIMELINE_PIPELINE (pipeline));
+
+  GST_DEBUG_OBJECT (pipeline, "use_proxies:%d", use_proxies);
+
+  pipeline->priv->use_proxies = use_proxies;
+
+  ges_timeline_pipeline_update_preview_settings (pipeline);
+}
+
 /**
  * ges_timeline_pipeline_set_render_settings:
  * @pipeline: a #GESTimelinePipeline
@@ -642,6 +925,48 @@ ges_timeline_pipeline_set_render_settings (GESTimelinePipeline * pipeline,
   return TRUE;
 }
 
+/**
+ * ges_timeline_pipeline_set_render_queue:
+ * @pipeline: a #GESTimelinePipeline created with
+ * ges_timeline_pipeline_new_for_render()
+ * @track: the #GESTrack whose queue to configure
+ * @max_buffers: the maximum number of buffers in the queue, 0 for no limit
+ * @max_bytes: the maximum size of the queue (in bytes), 0 for no limit
+ * @max_time: the maximum duration of the queue (in nanoseconds), 0 for no
+ * limit
+ *
+ * Sets how far decoding @track can run ahead of encoding it. Larger queues
+ * keep decoders and encoders busy at the same time, at the cost of memory.
+ * By default each track can be decoded up to two seconds ahead.
+ */
+void
+ges_timeline_pipeline_set_render_queue (GESTimelinePipeline * pipeline,
+    GESTrack * track, guint max_buffers, guint max_bytes, guint64 max_time)
+{
+  RenderQueueLimits *limits;
+  OutputChain *chain;
+
+  g_return_if_fail (GES_IS_TIMELINE_PIPELINE (pipeline));
+  g_return_if_fail (GES_IS_TRACK (track));
+
+  GST_DEBUG_OBJECT (pipeline, "track:%p, buffers:%u, bytes:%u, time:%"
+      GST_TIME_FORMAT, track, max_buffers, max_bytes, GST_TIME_ARGS (max_time));
+
+  if (pipeline->priv->render_queues == NULL)
+    pipeline->priv->render_queues = g_hash_table_new_full (g_direct_hash,
+        g_direct_equal, g_object_unref, g_free);
+
+  limits = g_new (RenderQueueLimits, 1);
+  limits->max_buffers = max_buffers;
+  limits->max_bytes = max_bytes;
+  limits->max_time = max_time;
+  g_hash_table_insert (pipeline->priv->render_queues, g_object_ref (track),
+      limits);
+
+  if ((chain = get_output_chain_for_track (pipeline, track)) && chain->queue)
+    apply_render_queue_limits (pipeline, chain);
+}
+
 /**
  * ges_timeline_pipeline_set_mode:
  * @pipeline: a #GESTimelinePipeline
@@ -667,6 +992,11 @@ ges_timeline_pipeline_set_mode (GESTimelinePipeline * pipeline,
   if (mode == pipeline->priv->mode)
     return TRUE;
 
+  if (pipeline->priv->headless && (mode & TIMELINE_MODE_PREVIEW)) {
+    GST_ERROR_OBJECT (pipeline, "Pipeline was created for rendering only");
+    return FALSE;
+  }
+
   /* FIXME: It would be nice if we are only (de)activating preview
    * modes to not set the whole pipeline to NULL, but instead just
    * do the proper (un)linking to playsink. */
@@ -699,6 +1029,13 @@ ges_timeline_pipeline_set_mode (GESTimelinePipeline * pipeline,
     /* Add playsink */
     GST_DEBUG ("Adding playsink");
 
+    if (pipeline->priv->playsink == NULL)
+      pipeline->priv->playsink =
+          gst_element_factory_make ("playsink", "internal-sinks");
+    if (G_UNLIKELY (pipeline->priv->playsink == NULL)) {
+      GST_ERROR_OBJECT (pipeline, "Can't create playsink instance !");
+      return FALSE;
+    }
     if (!gst_bin_add (GST_BIN_CAST (pipeline), pipeline->priv->playsink)) {
       GST_ERROR_OBJECT (pipeline, "Couldn't add playsink");
       return FALSE;
@@ -736,9 +1073,55 @@ ges_timeline_pipeline_set_mode (GESTimelinePipeline * pipeline,
 
   pipeline->priv->mode = mode;
 
+  ges_timeline_pipeline_update_preview_settings (pipeline);
+
   return TRUE;
 }
 
+/* Converters are kept for the lifetime of the pipeline, since thumbnails
+ * are usually asked over and over in the same few formats */
+static GESFrameConverter *
+get_frame_converter (GESTimelinePipeline * self, GstCaps * caps)
+{
+  GESFrameConverter *converter;
+  gchar *key = gst_caps_to_string (caps);
+
+  GST_OBJECT_LOCK (self);
+  if (G_UNLIKELY (self->priv->converters == NULL))
+    self->priv->converters = g_hash_table_new_full (g_str_hash, g_str_equal,
+        g_free, (GDestroyNotify) ges_frame_converter_free);
+
+  if (!(converter = g_hash_table_lookup (self->priv->converters, key))) {
+    GST_DEBUG_OBJECT (self, "New frame converter for %s", key);
+    if ((converter = ges_frame_converter_new (caps))) {
+      g_hash_table_insert (self->priv->converters, key, converter);
+      key = NULL;
+    }
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  g_free (key);
+
+  return converter;
+}
+
+/* A converter which failed once, for example because its encoder sent EOS,
+ * won't ever work again */
+static void
+drop_frame_converter (GESTimelinePipeline * self, GstCaps * caps)
+{
+  gchar *key = gst_caps_to_string (caps);
+
+  GST_DEBUG_OBJECT (self, "Dropping frame converter for %s", key);
+
+  GST_OBJECT_LOCK (self);
+  if (self->priv->converters)
+    g_hash_table_remove (self->priv->converters, key);
+  GST_OBJECT_UNLOCK (self);
+
+  g_free (key);
+}
+
 /**
  * ges_timeline_pipeline_get_thumbnail_buffer:
  * @self: a #GESTimelinePipeline in %GST_STATE_PLAYING or %GST_STATE_PAUSED
@@ -751,6 +1134,9 @@ ges_timeline_pipeline_set_mode (GESTimelinePipeline * pipeline,
  * is currently used by the sink. This information can be retrieve from caps
  * associated with the buffer.
  *
+ * The elements converting the frames to @caps are kept around, so that
+ * getting other thumbnails in the same format only costs a conversion.
+ *
  * Returns: (transfer full): a #GstBuffer or %NULL
  */
 
@@ -759,7 +1145,8 @@ ges_timeline_pipeline_get_thumbnail_buffer (GESTimelinePipeline * self,
     GstCaps * caps)
 {
   GstElement *sink;
-  GstBuffer *buf;
+  GstBuffer *frame, *buf;
+  GESFrameConverter *converter = NULL;
 
   sink = self->priv->playsink;
   if (!sink) {
@@ -767,11 +1154,81 @@ ges_timeline_pipeline_get_thumbnail_buffer (GESTimelinePipeline * self,
     return NULL;
   }
 
-  buf = ges_play_sink_convert_frame (sink, caps);
+  if (caps && !gst_caps_is_any (caps) &&
+      !(converter = get_frame_converter (self, caps)))
+    return NULL;
+
+  frame = ges_play_sink_convert_frame (sink, NULL);
+  if (frame == NULL || converter == NULL)
+    return frame;
+
+  if (!(buf = ges_frame_converter_convert (converter, frame))) {
+    drop_frame_converter (self, caps);
+    if ((converter = get_frame_converter (self, caps)))
+      buf = ges_frame_converter_convert (converter, frame);
+  }
+  gst_buffer_unref (frame);
 
   return buf;
 }
 
+static gchar *
+make_thumbnail_key (GESTimelinePipeline * self, guint64 position, gint width,
+    gint height, const gchar * format)
+{
+  gchar *extra, *caps = NULL, *key;
+  gboolean use_proxies = FALSE;
+
+  if (self->priv->timeline == NULL)
+    return NULL;
+
+  /* The native size depends on the preview caps, and the frames on whether
+   * they come from proxies */
+  if (!(self->priv->mode &
+          (TIMELINE_MODE_RENDER | TIMELINE_MODE_SMART_RENDER))) {
+    if (self->priv->preview_caps)
+      caps = gst_caps_to_string (self->priv->preview_caps);
+    use_proxies = self->priv->use_proxies;
+  }
+
+  extra = g_strdup_printf ("%dx%d %s", width, height, caps ? caps : "");
+  key = ges_thumbnail_cache_make_key (self->priv->timeline, position,
+      use_proxies, format, extra);
+  g_free (extra);
+  g_free (caps);
+
+  return key;
+}
+
+/* While playing, the frame we get isn't exactly the one at the position, so
+ * it mustn't be cached */
+static gboolean
+is_paused (GESTimelinePipeline * self)
+{
+  GstState state;
+
+  return gst_element_get_state ((GstElement *) self, &state, NULL, 0) ==
+      GST_STATE_CHANGE_SUCCESS && state == GST_STATE_PAUSED;
+}
+
+static gboolean
+save_cached_thumbnail (const gchar * key, const gchar * location)
+{
+  gchar *data;
+  gsize size;
+  gboolean ret;
+
+  if (key == NULL || !ges_thumbnail_cache_lookup (key, &data, &size))
+    return FALSE;
+
+  GST_DEBUG ("Saving cached thumbnail to %s", location);
+
+  ret = g_file_set_contents (location, data, size, NULL);
+  g_free (data);
+
+  return ret;
+}
+
 /**
  * ges_timeline_pipeline_save_thumbnail:
  * @self: a #GESTimelinePipeline in %GST_STATE_PLAYING or %GST_STATE_PAUSED
@@ -782,6 +1239,12 @@ ges_timeline_pipeline_get_thumbnail_buffer (GESTimelinePipeline * self,
  * @location: the path to save the thumbnail
  *
  * Saves the current frame to the specified @location.
+ *
+ * Thumbnails are cached on disk, keyed by the objects playing at the
+ * current position, so that saving a thumbnail of the same contents again,
+ * in this timeline or another one, doesn't need the frame to be converted.
+ * The cache is only used while the pipeline is paused. See
+ * ges_timeline_pipeline_save_thumbnail_at() to also avoid seeking.
  * 
  * Returns: %TRUE if the thumbnail was properly save, else %FALSE.
  */
@@ -789,12 +1252,36 @@ ges_timeline_pipeline_get_thumbnail_buffer (GESTimelinePipeline * self,
 gboolean
 ges_timeline_pipeline_save_thumbnail (GESTimelinePipeline * self, int width, int
     height, const gchar * format, const gchar * location)
+{
+  GstFormat fmt = GST_FORMAT_TIME;
+  gint64 position;
+  gchar *key = NULL;
+  gboolean res;
+
+  if (is_paused (self) &&
+      gst_element_query_position ((GstElement *) self, &fmt, &position) &&
+      position >= 0)
+    key = make_thumbnail_key (self, position, width, height, format);
+
+  res = save_thumbnail (self, key, width, height, format, location);
+  g_free (key);
+
+  return res;
+}
+
+/* Saves the current frame, @key being the cache key of its position */
+static gboolean
+save_thumbnail (GESTimelinePipeline * self, const gchar * key, int width,
+    int height, const gchar * format, const gchar * location)
 {
   GstBuffer *b;
   FILE *fp;
   GstCaps *caps;
   gboolean res = TRUE;
 
+  if (save_cached_thumbnail (key, location))
+    return TRUE;
+
   caps = gst_caps_from_string (format);
 
   if (width > 1)
@@ -815,11 +1302,67 @@ ges_timeline_pipeline_save_thumbnail (GESTimelinePipeline * self, int width, int
   }
 
   fclose (fp);
+
+  if (res && key)
+    ges_thumbnail_cache_store (key, (const gchar *) GST_BUFFER_DATA (b),
+        GST_BUFFER_SIZE (b));
+
   gst_caps_unref (caps);
   gst_buffer_unref (b);
   return res;
 }
 
+/**
+ * ges_timeline_pipeline_save_thumbnail_at:
+ * @self: a #GESTimelinePipeline in %GST_STATE_PLAYING or %GST_STATE_PAUSED
+ * @position: the position (in nanoseconds) to get the thumbnail at
+ * @width: the requested width or -1 for native size
+ * @height: the requested height or -1 for native size
+ * @format: a string specifying the desired mime type (for example,
+ * image/jpeg)
+ * @location: the path to save the thumbnail
+ *
+ * Saves the frame at @position to the specified @location. If a thumbnail
+ * of the same contents was already saved, it is taken from the cache
+ * without seeking nor decoding anything. Else the pipeline is seeked to
+ * @position, and stays there. The thumbnail is only cached if the pipeline
+ * is paused.
+ *
+ * Returns: %TRUE if the thumbnail was properly saved, else %FALSE.
+ */
+gboolean
+ges_timeline_pipeline_save_thumbnail_at (GESTimelinePipeline * self,
+    GstClockTime position, int width, int height, const gchar * format,
+    const gchar * location)
+{
+  gchar *key;
+  gboolean res = FALSE;
+
+  g_return_val_if_fail (GES_IS_TIMELINE_PIPELINE (self), FALSE);
+  g_return_val_if_fail (GST_CLOCK_TIME_IS_VALID (position), FALSE);
+
+  key = make_thumbnail_key (self, position, width, height, format);
+
+  /* Cached under the requested position, even if the frame we get after
+   * seeking has a slightly different timestamp */
+  if (save_cached_thumbnail (key, location))
+    res = TRUE;
+  else if (gst_element_seek_simple ((GstElement *) self, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE, position) &&
+      gst_element_get_state ((GstElement *) self, NULL, NULL,
+          THUMBNAIL_TIMEOUT) != GST_STATE_CHANGE_FAILURE) {
+    if (!is_paused (self)) {
+      g_free (key);
+      key = NULL;
+    }
+    res = save_thumbnail (self, key, width, height, format, location);
+  }
+
+  g_free (key);
+
+  return res;
+}
+
 /**
  * ges_timeline_pipeline_get_thumbnail_rgb24:
  * @self: a #GESTimelinePipeline in %GST_STATE_PLAYING or %GST_STATE_PAUSED
@@ -858,14 +1401,487 @@ ges_timeline_pipeline_get_thumbnail_rgb24 (GESTimelinePipeline * self,
   return ret;
 }
 
+typedef struct
+{
+  GstClockTime position;
+  guint index;                  /* In the array given by the caller */
+} ThumbnailRequest;
+
+static gint
+compare_thumbnail_request (gconstpointer a, gconstpointer b)
+{
+  const ThumbnailRequest *ra = a, *rb = b;
+
+  if (ra->position < rb->position)
+    return -1;
+  if (ra->position > rb->position)
+    return 1;
+  return 0;
+}
+
+/* Plugs on the tee of the video track a branch converting frames to @caps
+ * and keeping the last one, without displaying anything */
+static GstElement *
+add_thumbnail_branch (GESTimelinePipeline * self, OutputChain * chain,
+    GstCaps * caps)
+{
+  GstElement *branch, *filter;
+  GstPad *teepad, *sinkpad;
+  GError *error = NULL;
+
+  branch = gst_parse_bin_from_description ("queue ! ffmpegcolorspace ! "
+      "videoscale ! capsfilter name=filter ! "
+      "fakesink name=sink sync=false enable-last-buffer=true", TRUE, &error);
+  if (G_UNLIKELY (branch == NULL)) {
+    GST_ERROR_OBJECT (self, "Couldn't create thumbnail branch: %s",
+        error->message);
+    g_error_free (error);
+    return NULL;
+  }
+
+  if (caps) {
+    filter = gst_bin_get_by_name (GST_BIN (branch), "filter");
+    g_object_set (filter, "caps", caps, NULL);
+    gst_object_unref (filter);
+  }
+
+  gst_bin_add (GST_BIN_CAST (self), branch);
+  gst_element_sync_state_with_parent (branch);
+
+  teepad = gst_element_get_request_pad (chain->tee, "src%d");
+  sinkpad = gst_element_get_static_pad (branch, "sink");
+  gst_pad_link_full (teepad, sinkpad, GST_PAD_LINK_CHECK_NOTHING);
+  gst_object_unref (sinkpad);
+  gst_object_unref (teepad);
+
+  return branch;
+}
+
+static void
+remove_thumbnail_branch (GESTimelinePipeline * self, OutputChain * chain,
+    GstElement * branch)
+{
+  GstPad *teepad, *sinkpad;
+
+  sinkpad = gst_element_get_static_pad (branch, "sink");
+  teepad = gst_pad_get_peer (sinkpad);
+  gst_pad_unlink (teepad, sinkpad);
+  gst_element_release_request_pad (chain->tee, teepad);
+  gst_object_unref (teepad);
+  gst_object_unref (sinkpad);
+
+  gst_element_set_state (branch, GST_STATE_NULL);
+  gst_bin_remove (GST_BIN_CAST (self), branch);
+}
+
+/* Takes playsink and all the other tracks out of the pipeline while the
+ * thumbnail branch runs, so that the seeks are neither displayed nor heard.
+ * Returns the tracks which were deactivated. */
+static GList *
+isolate_thumbnail_chain (GESTimelinePipeline * self, OutputChain * chain)
+{
+  GList *tmp, *tracks, *deactivated = NULL;
+  GstPad *teepad;
+
+  if (chain->playsinkpad) {
+    teepad = gst_pad_get_peer (chain->playsinkpad);
+    gst_pad_unlink (teepad, chain->playsinkpad);
+    gst_element_release_request_pad (chain->tee, teepad);
+    gst_object_unref (teepad);
+  }
+
+  /* playsink won't wait for a frame that never comes */
+  if (self->priv->mode & TIMELINE_MODE_PREVIEW) {
+    gst_element_set_locked_state (self->priv->playsink, TRUE);
+    gst_element_set_state (self->priv->playsink, GST_STATE_READY);
+  }
+
+  tracks = ges_timeline_get_tracks (self->priv->timeline);
+  for (tmp = tracks; tmp; tmp = tmp->next) {
+    GESTrack *track = (GESTrack *) tmp->data;
+
+    if (track != chain->track && ges_track_get_active (track)) {
+      ges_track_set_active (track, FALSE);
+      deactivated = g_list_prepend (deactivated, track);
+    } else
+      g_object_unref (track);
+  }
+  g_list_free (tracks);
+
+  return deactivated;
+}
+
+static void
+restore_thumbnail_chain (GESTimelinePipeline * self, OutputChain * chain,
+    GList * deactivated)
+{
+  GList *tmp;
+  GstPad *teepad;
+
+  if (chain->playsinkpad) {
+    teepad = gst_element_get_request_pad (chain->tee, "src%d");
+    gst_pad_link_full (teepad, chain->playsinkpad, GST_PAD_LINK_CHECK_NOTHING);
+    gst_object_unref (teepad);
+  }
+
+  if (self->priv->mode & TIMELINE_MODE_PREVIEW) {
+    gst_element_set_locked_state (self->priv->playsink, FALSE);
+    gst_element_sync_state_with_parent (self->priv->playsink);
+  }
+
+  for (tmp = deactivated; tmp; tmp = tmp->next) {
+    ges_track_set_active ((GESTrack *) tmp->data, TRUE);
+    g_object_unref (tmp->data);
+  }
+  g_list_free (deactivated);
+}
+
+/**
+ * ges_timeline_pipeline_get_thumbnails:
+ * @self: a #GESTimelinePipeline in %GST_STATE_PLAYING or %GST_STATE_PAUSED
+ * @positions: (array length=n_positions): the positions (in nanoseconds) to
+ * get thumbnails at
+ * @n_positions: the number of positions
+ * @caps: (allow-none): the raw video #GstCaps to convert the frames to, for
+ * example 'video/x-raw-rgb,width=160', or %NULL for the format of the video
+ * track
+ * @accurate: %TRUE to get the exact frame at each position, %FALSE to get
+ * the closest keyframe, which is much faster
+ *
+ * Gets the frames of the video track at all the @positions at once, for
+ * example to draw a filmstrip. The frames are converted to @caps on their
+ * way through a dedicated branch of the pipeline, and @positions are visited
+ * in increasing order whatever their order in the array.
+ *
+ * The pipeline is paused while getting the thumbnails, after which its
+ * previous state and position are restored. Meanwhile, nothing is displayed
+ * and the other tracks, audio included, are deactivated. Thumbnails can't be
+ * taken while rendering.
+ *
+ * Returns: (transfer full) (array length=n_positions): a newly allocated
+ * array of @n_positions #GstBuffer, in the order of @positions, a buffer
+ * being %NULL if no frame could be obtained at its position. Free the
+ * buffers with gst_buffer_unref() and the array with g_free().
+ */
+GstBuffer **
+ges_timeline_pipeline_get_thumbnails (GESTimelinePipeline * self,
+    const GstClockTime * positions, guint n_positions, GstCaps * caps,
+    gboolean accurate)
+{
+  GstElement *pipeline = (GstElement *) self;
+  GstElement *branch, *sink;
+  GstBuffer **buffers, *buffer = NULL;
+  ThumbnailRequest *requests;
+  OutputChain *chain = NULL;
+  GList *deactivated;
+  GstState state;
+  GstFormat format = GST_FORMAT_TIME;
+  gint64 position = -1;
+  GstSeekFlags flags;
+  GList *tmp;
+  guint i;
+
+  g_return_val_if_fail (GES_IS_TIMELINE_PIPELINE (self), NULL);
+  g_return_val_if_fail (positions != NULL || n_positions == 0, NULL);
+
+  /* Only teed tracks can get another branch */
+  for (tmp = self->priv->chains; tmp; tmp = tmp->next)
+    if (((OutputChain *) tmp->data)->track->type == GES_TRACK_TYPE_VIDEO &&
+        ((OutputChain *) tmp->data)->tee)
+      chain = (OutputChain *) tmp->data;
+
+  if (gst_element_get_state (pipeline, &state, NULL, THUMBNAIL_TIMEOUT) ==
+      GST_STATE_CHANGE_FAILURE || state < GST_STATE_PAUSED || chain == NULL) {
+    GST_WARNING_OBJECT (self, "thumbnailing needs a paused video track");
+    return NULL;
+  }
+
+  /* Seeking around would end up in the output file */
+  if (self->priv->mode & (TIMELINE_MODE_RENDER | TIMELINE_MODE_SMART_RENDER)) {
+    GST_WARNING_OBJECT (self, "can't get thumbnails while rendering");
+    return NULL;
+  }
+
+  gst_element_query_position (pipeline, &format, &position);
+  if (state == GST_STATE_PLAYING)
+    gst_element_set_state (pipeline, GST_STATE_PAUSED);
+
+  deactivated = isolate_thumbnail_chain (self, chain);
+  if (!(branch = add_thumbnail_branch (self, chain, caps))) {
+    restore_thumbnail_chain (self, chain, deactivated);
+    gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+        GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE, MAX (position, 0));
+    if (state == GST_STATE_PLAYING)
+      gst_element_set_state (pipeline, GST_STATE_PLAYING);
+    return NULL;
+  }
+  sink = gst_bin_get_by_name (GST_BIN (branch), "sink");
+
+  requests = g_new (ThumbnailRequest, n_positions);
+  for (i = 0; i < n_positions; i++) {
+    requests[i].position = positions[i];
+    requests[i].index = i;
+  }
+  qsort (requests, n_positions, sizeof (ThumbnailRequest),
+      compare_thumbnail_request);
+
+  flags = GST_SEEK_FLAG_FLUSH |
+      (accurate ? GST_SEEK_FLAG_ACCURATE : GST_SEEK_FLAG_KEY_UNIT);
+  buffers = g_new0 (GstBuffer *, n_positions);
+
+  for (i = 0; i < n_positions; i++) {
+    /* Positions asked several times only need one seek */
+    if (i == 0 || requests[i].position != requests[i - 1].position) {
+      buffer = NULL;
+
+      GST_DEBUG_OBJECT (self, "thumbnail at %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (requests[i].position));
+
+      if (gst_element_seek_simple (pipeline, GST_FORMAT_TIME, flags,
+              requests[i].position) &&
+          gst_element_get_state (pipeline, NULL, NULL, THUMBNAIL_TIMEOUT) ==
+          GST_STATE_CHANGE_SUCCESS)
+        g_object_get (sink, "last-buffer", &buffer, NULL);
+      else
+        GST_WARNING_OBJECT (self, "couldn't preroll at %" GST_TIME_FORMAT,
+            GST_TIME_ARGS (requests[i].position));
+    } else if (buffer)
+      gst_buffer_ref (buffer);
+
+    buffers[requests[i].index] = buffer;
+  }
+  g_free (requests);
+
+  gst_object_unref (sink);
+  remove_thumbnail_branch (self, chain, branch);
+  restore_thumbnail_chain (self, chain, deactivated);
+
+  /* Prerolls playsink again, even if the position is unknown */
+  gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+      GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE, MAX (position, 0));
+  if (state == GST_STATE_PLAYING)
+    gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  return buffers;
+}
+
+/* Called from the main context once a seek sent while scrubbing might have
+ * prerolled */
 static gboolean
-play_sink_multiple_seeks_send_event (GstElement * element, GstEvent * event)
+scrub_idle_cb (GESTimelinePipeline * self)
 {
-  GstElementClass *klass = GST_ELEMENT_GET_CLASS (element);
+  GstEvent *pending;
+
+  /* Still prerolling, we'll be called again on the next ASYNC_DONE */
+  if (gst_element_get_state ((GstElement *) self, NULL, NULL, 0) ==
+      GST_STATE_CHANGE_ASYNC) {
+    GST_OBJECT_LOCK (self);
+    self->priv->scrub_idle = 0;
+    GST_OBJECT_UNLOCK (self);
+    return FALSE;
+  }
+
+  GST_OBJECT_LOCK (self);
+  self->priv->scrub_idle = 0;
+  self->priv->seek_in_flight = FALSE;
+  pending = self->priv->pending_seek;
+  self->priv->pending_seek = NULL;
+  GST_OBJECT_UNLOCK (self);
+
+  if (pending) {
+    GST_DEBUG_OBJECT (self, "Sending the latest scrubbing seek");
+    gst_element_send_event ((GstElement *) self, pending);
+  }
+
+  return FALSE;
+}
+
+static void
+ges_timeline_pipeline_handle_message (GstBin * bin, GstMessage * message)
+{
+  GESTimelinePipeline *self = GES_TIMELINE_PIPELINE (bin);
+
+  GST_BIN_CLASS (ges_timeline_pipeline_parent_class)->handle_message (bin,
+      message);
 
-  GST_DEBUG ("%s", GST_EVENT_TYPE_NAME (event));
+  /* This comes from a streaming thread, where we can't seek */
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ASYNC_DONE) {
+    GST_OBJECT_LOCK (self);
+    if (self->priv->seek_in_flight && !self->priv->scrub_idle)
+      self->priv->scrub_idle = g_idle_add ((GSourceFunc) scrub_idle_cb, self);
+    GST_OBJECT_UNLOCK (self);
+  }
+}
+
+/* Returns: (transfer full): @event seeking to the keyframe before its
+ * position instead of the exact position */
+static GstEvent *
+make_snapped_seek (GstEvent * event)
+{
+  GstFormat format;
+  GstSeekFlags flags;
+  GstSeekType start_type, stop_type;
+  gint64 start, stop;
+  gdouble rate;
+
+  gst_event_parse_seek (event, &rate, &format, &flags, &start_type, &start,
+      &stop_type, &stop);
+  gst_event_unref (event);
+
+  flags = (flags & ~GST_SEEK_FLAG_ACCURATE) | GST_SEEK_FLAG_KEY_UNIT;
+
+  return gst_event_new_seek (rate, format, flags, start_type, start,
+      stop_type, stop);
+}
+
+/* While scrubbing, flushing seeks sent while another one is prerolling are
+ * not sent right away: only the latest of them is, once the previous one
+ * prerolled. Returns %TRUE if @event was taken care of */
+static gboolean
+coalesce_seek (GESTimelinePipeline * self, GstEvent ** event)
+{
+  GstFormat format;
+  GstSeekFlags flags;
+  GstSeekType start_type;
+  gint64 start;
 
-  return
-      GST_ELEMENT_CLASS (g_type_class_peek_parent (klass))->send_event (element,
-      event);
+  gst_event_parse_seek (*event, NULL, &format, &flags, &start_type, &start,
+      NULL, NULL);
+
+  if (!(flags & GST_SEEK_FLAG_FLUSH) || GST_STATE (self) < GST_STATE_PAUSED)
+    return FALSE;
+
+  GST_OBJECT_LOCK (self);
+  if (!self->priv->scrubbing) {
+    GST_OBJECT_UNLOCK (self);
+    return FALSE;
+  }
+
+  if (format == GST_FORMAT_TIME && start_type == GST_SEEK_TYPE_SET)
+    self->priv->scrub_position = start;
+
+  if (self->priv->seek_in_flight) {
+    GST_LOG_OBJECT (self, "Delaying seek to %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (start));
+    gst_event_replace (&self->priv->pending_seek, NULL);
+    self->priv->pending_seek = *event;
+    GST_OBJECT_UNLOCK (self);
+    return TRUE;
+  }
+
+  self->priv->seek_in_flight = TRUE;
+  if (self->priv->scrub_snap)
+    *event = make_snapped_seek (*event);
+  GST_OBJECT_UNLOCK (self);
+
+  return FALSE;
+}
+
+static gboolean
+ges_timeline_pipeline_send_event (GstElement * element, GstEvent * event)
+{
+  GESTimelinePipeline *self = GES_TIMELINE_PIPELINE (element);
+  gboolean ret;
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_SEEK && coalesce_seek (self, &event))
+    return TRUE;
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_SEEK && self->priv->timeline) {
+    GstFormat format;
+    GstSeekType start_type;
+    gint64 start;
+
+    gst_event_parse_seek (event, NULL, &format, NULL, &start_type, &start,
+        NULL, NULL);
+
+    /* Make sure the objects we are seeking to have their contents */
+    if (format == GST_FORMAT_TIME && start_type == GST_SEEK_TYPE_SET &&
+        start >= 0)
+      ges_timeline_move_window (self->priv->timeline, start);
+  }
+
+  ret = GST_ELEMENT_CLASS (ges_timeline_pipeline_parent_class)->send_event
+      (element, event);
+
+  if (!ret) {
+    GST_OBJECT_LOCK (self);
+    self->priv->seek_in_flight = FALSE;
+    GST_OBJECT_UNLOCK (self);
+  }
+
+  return ret;
+}
+
+/**
+ * ges_timeline_pipeline_start_scrubbing:
+ * @pipeline: a #GESTimelinePipeline in %GST_STATE_PAUSED or
+ * %GST_STATE_PLAYING
+ * @snap_to_keyframes: whether to seek to the keyframe before each requested
+ * position instead of the exact position
+ *
+ * Puts @pipeline in scrubbing mode, typically while the user drags the
+ * playhead. In this mode, flushing seeks sent to @pipeline while the
+ * previous one is still prerolling are not sent right away. Only the latest
+ * of them is sent once that seek completed, so that the pipeline keeps up
+ * with the playhead instead of going through every position it passed by.
+ *
+ * Snapping to keyframes makes each seek much faster, and the exact position
+ * is only seeked to by ges_timeline_pipeline_stop_scrubbing().
+ *
+ * The latest seek is never dropped. This requires the default #GMainContext
+ * to be iterated.
+ */
+void
+ges_timeline_pipeline_start_scrubbing (GESTimelinePipeline * pipeline,
+    gboolean snap_to_keyframes)
+{
+  g_return_if_fail (GES_IS_TIMELINE_PIPELINE (pipeline));
+
+  GST_DEBUG_OBJECT (pipeline, "snap:%d", snap_to_keyframes);
+
+  GST_OBJECT_LOCK (pipeline);
+  pipeline->priv->scrubbing = TRUE;
+  pipeline->priv->scrub_snap = snap_to_keyframes;
+  pipeline->priv->scrub_position = -1;
+  GST_OBJECT_UNLOCK (pipeline);
+}
+
+/**
+ * ges_timeline_pipeline_stop_scrubbing:
+ * @pipeline: a #GESTimelinePipeline
+ *
+ * Leaves the scrubbing mode entered with
+ * ges_timeline_pipeline_start_scrubbing(), typically when the user releases
+ * the playhead. If some seek was delayed or snapped to a keyframe, an
+ * accurate seek to the latest requested position is sent.
+ */
+void
+ges_timeline_pipeline_stop_scrubbing (GESTimelinePipeline * pipeline)
+{
+  GstEvent *pending;
+  gint64 position;
+  gboolean snapped;
+
+  g_return_if_fail (GES_IS_TIMELINE_PIPELINE (pipeline));
+
+  GST_OBJECT_LOCK (pipeline);
+  pending = pipeline->priv->pending_seek;
+  pipeline->priv->pending_seek = NULL;
+  position = pipeline->priv->scrub_position;
+  snapped = pipeline->priv->scrub_snap;
+  pipeline->priv->scrubbing = FALSE;
+  pipeline->priv->seek_in_flight = FALSE;
+  GST_OBJECT_UNLOCK (pipeline);
+
+  GST_DEBUG_OBJECT (pipeline, "position:%" GST_TIME_FORMAT,
+      GST_TIME_ARGS (position));
+
+  /* Flushing interrupts the seek that might still be prerolling */
+  if (snapped && position >= 0) {
+    if (pending)
+      gst_event_unref (pending);
+    gst_element_seek_simple ((GstElement *) pipeline, GST_FORMAT_TIME,
+        GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE, position);
+  } else if (pending)
+    gst_element_send_event ((GstElement *) pipeline, pending);
 }
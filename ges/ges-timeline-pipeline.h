@@ -96,6 +96,7 @@ struct _GESTimelinePipelineClass {
 GType ges_timeline_pipeline_get_type (void);
 
 GESTimelinePipeline* ges_timeline_pipeline_new (void);
+GESTimelinePipeline* ges_timeline_pipeline_new_for_render (void);
 
 gboolean ges_timeline_pipeline_add_timeline (GESTimelinePipeline * pipeline,
 					     GESTimeline * timeline);
@@ -103,8 +104,20 @@ gboolean ges_timeline_pipeline_add_timeline (GESTimelinePipeline * pipeline,
 gboolean ges_timeline_pipeline_set_render_settings (GESTimelinePipeline *pipeline,
 						    gchar * output_uri,
 						    GstEncodingProfile *profile);
+void ges_timeline_pipeline_set_render_queue (GESTimelinePipeline *pipeline,
+					     GESTrack *track,
+					     guint max_buffers,
+					     guint max_bytes,
+					     guint64 max_time);
 gboolean ges_timeline_pipeline_set_mode (GESTimelinePipeline *pipeline,
 					 GESPipelineFlags mode);
+void ges_timeline_pipeline_set_preview_caps (GESTimelinePipeline *pipeline,
+					     const GstCaps *caps);
+void ges_timeline_pipeline_set_use_proxies (GESTimelinePipeline *pipeline,
+					    gboolean use_proxies);
+void ges_timeline_pipeline_start_scrubbing (GESTimelinePipeline *pipeline,
+					    gboolean snap_to_keyframes);
+void ges_timeline_pipeline_stop_scrubbing (GESTimelinePipeline *pipeline);
 
 GstBuffer *
 ges_timeline_pipeline_get_thumbnail_buffer(GESTimelinePipeline *self, GstCaps *caps);
@@ -113,10 +126,20 @@ GstBuffer *
 ges_timeline_pipeline_get_thumbnail_rgb24(GESTimelinePipeline *self,
     gint width, gint height);
 
+GstBuffer **
+ges_timeline_pipeline_get_thumbnails (GESTimelinePipeline *self,
+    const GstClockTime *positions, guint n_positions, GstCaps *caps,
+    gboolean accurate);
+
 gboolean
 ges_timeline_pipeline_save_thumbnail(GESTimelinePipeline *self,
     int width, int height, const gchar *format, const gchar *location);
 
+gboolean
+ges_timeline_pipeline_save_thumbnail_at (GESTimelinePipeline *self,
+    GstClockTime position, int width, int height, const gchar *format,
+    const gchar *location);
+
 G_END_DECLS
 
 #endif /* _GES_TIMELINE_PIPELINE */
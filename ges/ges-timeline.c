@@ -51,14 +51,46 @@ struct _GESTimelinePrivate
   GList *layers;                /* A list of GESTimelineLayer sorted by priority */
   GList *tracks;                /* A list of private track data */
 
-  /* discoverer used for virgin sources */
-  GstDiscoverer *discoverer;
-  /* Objects that are being discovered FIXME : LOCK ! */
-  GList *pendingobjects;
+  /* Pool of DiscovererWorker used for virgin sources */
+  GPtrArray *discoverers;
+  /* Maximum number of uris being discovered concurrently */
+  guint max_concurrent_discoveries;
+  /* Time after which the discovery of a uri is considered failed */
+  GstClockTime discovery_timeout;
+  /* Objects that are being discovered, indexed by uri. Each uri maps to the
+   * GList of GESTimelineFileSource waiting for it. FIXME : LOCK ! */
+  GHashTable *pendingobjects;
   /* Whether we are changing state asynchronously or not */
   gboolean async_pending;
+
+  /* Whether discovery results are looked up in/stored to the on-disk cache */
+  gboolean use_discovery_cache;
+
+  /* Partial preroll: only wait for the objects overlapping
+   * [preroll_position - preroll_window, preroll_position + preroll_window] */
+  gboolean partial_preroll;
+  GstClockTime preroll_position;
+  GstClockTime preroll_window;
+
+  /* Number of nested ges_timeline_begin_update() calls not committed yet.
+   * The compositions of the tracks aren't updated while it is non-zero */
+  guint update_depth;
+
+  /* File sources discovered while the stack they overlap was playing, not
+   * added to the tracks yet. Protected by the object lock */
+  GList *deferred;
+  guint deferred_idle;
 };
 
+/* private structure for each discoverer of the pool */
+
+typedef struct
+{
+  GESTimeline *timeline;
+  GstDiscoverer *discoverer;
+  guint pending;                /* Number of uris queued on this discoverer */
+} DiscovererWorker;
+
 /* private structure to contain our track-related information */
 
 typedef struct
@@ -67,6 +99,12 @@ typedef struct
   GESTrack *track;
   GstPad *pad;                  /* Pad from the track */
   GstPad *ghostpad;
+
+  /* Segment of the stack the composition is playing, start being
+   * GST_CLOCK_TIME_NONE if there is none. Protected by the object lock of
+   * the timeline */
+  GstClockTime playing_start;
+  GstClockTime playing_stop;
 } TrackPrivate;
 
 enum
@@ -75,9 +113,27 @@ enum
   TRACK_REMOVED,
   LAYER_ADDED,
   LAYER_REMOVED,
+  DISCOVERY_ERROR,
   LAST_SIGNAL
 };
 
+enum
+{
+  PROP_0,
+  PROP_USE_DISCOVERY_CACHE,
+  PROP_MAX_CONCURRENT_DISCOVERIES,
+  PROP_DISCOVERY_TIMEOUT,
+  PROP_PARTIAL_PREROLL,
+  PROP_PREROLL_POSITION,
+  PROP_PREROLL_WINDOW,
+};
+
+#define DEFAULT_MAX_CONCURRENT_DISCOVERIES 1
+#define DEFAULT_DISCOVERY_TIMEOUT (15 * GST_SECOND)
+#define DEFAULT_PARTIAL_PREROLL FALSE
+#define DEFAULT_PREROLL_POSITION 0
+#define DEFAULT_PREROLL_WINDOW 0
+
 static GstBinClass *parent_class;
 
 static guint ges_timeline_signals[LAST_SIGNAL] = { 0 };
@@ -86,16 +142,34 @@ static gint custom_find_track (TrackPrivate * tr_priv, GESTrack * track);
 static GstStateChangeReturn
 ges_timeline_change_state (GstElement * element, GstStateChange transition);
 static void
-discoverer_finished_cb (GstDiscoverer * discoverer, GESTimeline * timeline);
-static void
 discoverer_discovered_cb (GstDiscoverer * discoverer,
-    GstDiscovererInfo * info, GError * err, GESTimeline * timeline);
+    GstDiscovererInfo * info, GError * err, DiscovererWorker * worker);
 
 static void
 ges_timeline_get_property (GObject * object, guint property_id,
     GValue * value, GParamSpec * pspec)
 {
+  GESTimeline *timeline = GES_TIMELINE (object);
+
   switch (property_id) {
+    case PROP_USE_DISCOVERY_CACHE:
+      g_value_set_boolean (value, timeline->priv->use_discovery_cache);
+      break;
+    case PROP_MAX_CONCURRENT_DISCOVERIES:
+      g_value_set_uint (value, timeline->priv->max_concurrent_discoveries);
+      break;
+    case PROP_DISCOVERY_TIMEOUT:
+      g_value_set_uint64 (value, timeline->priv->discovery_timeout);
+      break;
+    case PROP_PARTIAL_PREROLL:
+      g_value_set_boolean (value, timeline->priv->partial_preroll);
+      break;
+    case PROP_PREROLL_POSITION:
+      g_value_set_uint64 (value, timeline->priv->preroll_position);
+      break;
+    case PROP_PREROLL_WINDOW:
+      g_value_set_uint64 (value, timeline->priv->preroll_window);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -105,23 +179,87 @@ static void
 ges_timeline_set_property (GObject * object, guint property_id,
     const GValue * value, GParamSpec * pspec)
 {
+  GESTimeline *timeline = GES_TIMELINE (object);
+
   switch (property_id) {
+    case PROP_USE_DISCOVERY_CACHE:
+      timeline->priv->use_discovery_cache = g_value_get_boolean (value);
+      break;
+    case PROP_MAX_CONCURRENT_DISCOVERIES:
+      timeline->priv->max_concurrent_discoveries = g_value_get_uint (value);
+      break;
+    case PROP_DISCOVERY_TIMEOUT:
+    {
+      guint i;
+
+      timeline->priv->discovery_timeout = g_value_get_uint64 (value);
+      for (i = 0; i < timeline->priv->discoverers->len; i++) {
+        DiscovererWorker *worker =
+            g_ptr_array_index (timeline->priv->discoverers, i);
+        g_object_set (worker->discoverer, "timeout",
+            timeline->priv->discovery_timeout, NULL);
+      }
+      break;
+    }
+    case PROP_PARTIAL_PREROLL:
+      timeline->priv->partial_preroll = g_value_get_boolean (value);
+      break;
+    case PROP_PREROLL_POSITION:
+      timeline->priv->preroll_position = g_value_get_uint64 (value);
+      break;
+    case PROP_PREROLL_WINDOW:
+      timeline->priv->preroll_window = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
 }
 
+static void
+free_pending_list (gpointer uri, GList * sources, gpointer unused)
+{
+  g_list_free (sources);
+}
+
 static void
 ges_timeline_dispose (GObject * object)
 {
   GESTimelinePrivate *priv = GES_TIMELINE (object)->priv;
 
-  if (priv->discoverer) {
-    gst_discoverer_stop (priv->discoverer);
-    g_object_unref (priv->discoverer);
-    priv->discoverer = NULL;
+  if (priv->discoverers) {
+    guint i;
+
+    for (i = 0; i < priv->discoverers->len; i++) {
+      DiscovererWorker *worker = g_ptr_array_index (priv->discoverers, i);
+
+      g_signal_handlers_disconnect_by_func (worker->discoverer,
+          discoverer_discovered_cb, worker);
+      gst_discoverer_stop (worker->discoverer);
+      g_object_unref (worker->discoverer);
+      g_slice_free (DiscovererWorker, worker);
+    }
+    g_ptr_array_free (priv->discoverers, TRUE);
+    priv->discoverers = NULL;
+  }
+
+  if (priv->pendingobjects) {
+    g_hash_table_foreach (priv->pendingobjects, (GHFunc) free_pending_list,
+        NULL);
+    g_hash_table_destroy (priv->pendingobjects);
+    priv->pendingobjects = NULL;
   }
 
+  if (priv->use_discovery_cache)
+    ges_discovery_cache_save ();
+
+  if (priv->deferred_idle) {
+    g_source_remove (priv->deferred_idle);
+    priv->deferred_idle = 0;
+  }
+  g_list_foreach (priv->deferred, (GFunc) g_object_unref, NULL);
+  g_list_free (priv->deferred);
+  priv->deferred = NULL;
+
   while (priv->layers) {
     GESTimelineLayer *layer = (GESTimelineLayer *) priv->layers->data;
     ges_timeline_remove_layer (GES_TIMELINE (object), layer);
@@ -163,6 +301,88 @@ ges_timeline_class_init (GESTimelineClass * klass)
   object_class->dispose = ges_timeline_dispose;
   object_class->finalize = ges_timeline_finalize;
 
+  /**
+   * GESTimeline:use-discovery-cache
+   *
+   * Whether the results of discovering #GESTimelineFileSource uris should be
+   * cached on disk, and looked up before discovering them again. Entries are
+   * invalidated whenever the size or modification time of the file changes.
+   */
+  g_object_class_install_property (object_class, PROP_USE_DISCOVERY_CACHE,
+      g_param_spec_boolean ("use-discovery-cache", "Use discovery cache",
+          "Whether to use the on-disk cache of discovery results", TRUE,
+          G_PARAM_READWRITE));
+
+  /**
+   * GESTimeline:max-concurrent-discoveries
+   *
+   * The maximum number of #GESTimelineFileSource uris that will be
+   * discovered in parallel. Each concurrent discovery uses its own
+   * #GstDiscoverer, which are created as needed.
+   */
+  g_object_class_install_property (object_class,
+      PROP_MAX_CONCURRENT_DISCOVERIES,
+      g_param_spec_uint ("max-concurrent-discoveries",
+          "Maximum concurrent discoveries",
+          "Maximum number of uris discovered in parallel", 1, G_MAXUINT,
+          DEFAULT_MAX_CONCURRENT_DISCOVERIES, G_PARAM_READWRITE));
+
+  /**
+   * GESTimeline:discovery-timeout
+   *
+   * The maximum time (in nanoseconds) the discovery of a single uri can
+   * take. Sources whose discovery times out are treated as failed, see
+   * #GESTimeline::discovery-error.
+   */
+  g_object_class_install_property (object_class, PROP_DISCOVERY_TIMEOUT,
+      g_param_spec_uint64 ("discovery-timeout", "Discovery timeout",
+          "Maximum time (in nanoseconds) to discover a uri", GST_SECOND,
+          3600 * GST_SECOND, DEFAULT_DISCOVERY_TIMEOUT, G_PARAM_READWRITE));
+
+  /**
+   * GESTimeline:partial-preroll
+   *
+   * If %TRUE, the timeline will only wait for the discovery of the
+   * #GESTimelineFileSource overlapping the preroll window (see
+   * #GESTimeline:preroll-position and #GESTimeline:preroll-window) before
+   * completing the READY to PAUSED state change. The other sources are added
+   * to the tracks once they have been discovered. If the playback already
+   * reached the part of the timeline a source is in by then, adding it
+   * would make the tracks flush, so it is only added once the playback
+   * leaves that part, or on the next seek.
+   *
+   * Note that sources whose duration is not known yet are considered to
+   * extend until the end of the timeline.
+   */
+  g_object_class_install_property (object_class, PROP_PARTIAL_PREROLL,
+      g_param_spec_boolean ("partial-preroll", "Partial preroll",
+          "Only wait for the sources in the preroll window when prerolling",
+          DEFAULT_PARTIAL_PREROLL, G_PARAM_READWRITE));
+
+  /**
+   * GESTimeline:preroll-position
+   *
+   * The position (in nanoseconds) around which sources have to be discovered
+   * before prerolling when #GESTimeline:partial-preroll is %TRUE.
+   */
+  g_object_class_install_property (object_class, PROP_PREROLL_POSITION,
+      g_param_spec_uint64 ("preroll-position", "Preroll position",
+          "The position around which sources are needed to preroll", 0,
+          G_MAXUINT64, DEFAULT_PREROLL_POSITION, G_PARAM_READWRITE));
+
+  /**
+   * GESTimeline:preroll-window
+   *
+   * The time (in nanoseconds) before and after #GESTimeline:preroll-position
+   * in which sources have to be discovered before prerolling when
+   * #GESTimeline:partial-preroll is %TRUE.
+   */
+  g_object_class_install_property (object_class, PROP_PREROLL_WINDOW,
+      g_param_spec_uint64 ("preroll-window", "Preroll window",
+          "The time around the preroll position in which sources are needed "
+          "to preroll", 0, G_MAXUINT64, DEFAULT_PREROLL_WINDOW,
+          G_PARAM_READWRITE));
+
   /**
    * GESTimeline::track-added
    * @timeline: the #GESTimeline
@@ -211,6 +431,25 @@ ges_timeline_class_init (GESTimelineClass * klass)
       G_SIGNAL_RUN_FIRST, G_STRUCT_OFFSET (GESTimelineClass, layer_removed),
       NULL, NULL, ges_marshal_VOID__OBJECT, G_TYPE_NONE, 1,
       GES_TYPE_TIMELINE_LAYER);
+
+  /**
+   * GESTimeline::discovery-error
+   * @timeline: the #GESTimeline
+   * @source: the #GESTimelineFileSource that could not be discovered
+   * @error: (allow-none): the #GError reported by the discoverer, or %NULL
+   *
+   * Will be emitted when the uri of a #GESTimelineFileSource could not be
+   * discovered, either because of an error or because it took longer than
+   * #GESTimeline:discovery-timeout. No track objects will be created for
+   * @source, and the rest of the timeline is still prerolled.
+   *
+   * A "ges-discovery-error" element message containing the "uri" and a
+   * "message" describing the error is also posted on the bus.
+   */
+  ges_timeline_signals[DISCOVERY_ERROR] =
+      g_signal_new ("discovery-error", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, 0, NULL, NULL, ges_marshal_VOID__OBJECT_POINTER,
+      G_TYPE_NONE, 2, GES_TYPE_TIMELINE_FILE_SOURCE, G_TYPE_POINTER);
 }
 
 static void
@@ -222,14 +461,17 @@ ges_timeline_init (GESTimeline * self)
 
   self->priv->layers = NULL;
   self->priv->tracks = NULL;
-
-  /* New discoverer with a 15s timeout */
-  self->priv->discoverer = gst_discoverer_new (15 * GST_SECOND, NULL);
-  g_signal_connect (self->priv->discoverer, "finished",
-      G_CALLBACK (discoverer_finished_cb), self);
-  g_signal_connect (self->priv->discoverer, "discovered",
-      G_CALLBACK (discoverer_discovered_cb), self);
-  gst_discoverer_start (self->priv->discoverer);
+  self->priv->use_discovery_cache = TRUE;
+  self->priv->max_concurrent_discoveries = DEFAULT_MAX_CONCURRENT_DISCOVERIES;
+  self->priv->discovery_timeout = DEFAULT_DISCOVERY_TIMEOUT;
+  self->priv->partial_preroll = DEFAULT_PARTIAL_PREROLL;
+  self->priv->preroll_position = DEFAULT_PREROLL_POSITION;
+  self->priv->preroll_window = DEFAULT_PREROLL_WINDOW;
+
+  /* Discoverers are created on demand */
+  self->priv->discoverers = g_ptr_array_new ();
+  self->priv->pendingobjects = g_hash_table_new_full (g_str_hash,
+      g_str_equal, g_free, NULL);
 }
 
 /**
@@ -302,10 +544,14 @@ ges_timeline_load_from_uri (GESTimeline * timeline, gchar * uri)
     goto fail;
   }
 
+  /* Only rebuild the compositions once the whole project is loaded */
+  ges_timeline_begin_update (timeline);
   if (!ges_formatter_load_from_uri (p, timeline, uri)) {
     GST_ERROR ("error deserializing formatter");
+    ges_timeline_commit (timeline);
     goto fail;
   }
+  ges_timeline_commit (timeline);
 
   ret = TRUE;
 
@@ -383,6 +629,140 @@ add_object_to_tracks (GESTimeline * timeline, GESTimelineObject * object)
   }
 }
 
+/* Whether adding @object to the tracks would change the stack one of the
+ * compositions is playing, which they can only do by flushing. Must be
+ * called with the object lock taken */
+static gboolean
+touches_playing_stack (GESTimeline * timeline, GESTimelineObject * object)
+{
+  GstClockTime start = GES_TIMELINE_OBJECT_START (object);
+  GstClockTime duration = GES_TIMELINE_OBJECT_DURATION (object);
+  GstClockTime stop = G_MAXUINT64;
+  GList *tmp;
+
+  if (duration != 0 && GST_CLOCK_TIME_IS_VALID (duration))
+    stop = start + duration;
+
+  for (tmp = timeline->priv->tracks; tmp; tmp = tmp->next) {
+    TrackPrivate *tr_priv = (TrackPrivate *) tmp->data;
+
+    if (GST_CLOCK_TIME_IS_VALID (tr_priv->playing_start) &&
+        start < tr_priv->playing_stop && stop > tr_priv->playing_start)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+static void
+reset_playing_stacks (GESTimeline * timeline)
+{
+  GList *tmp;
+
+  GST_OBJECT_LOCK (timeline);
+  for (tmp = timeline->priv->tracks; tmp; tmp = tmp->next)
+    ((TrackPrivate *) tmp->data)->playing_start = GST_CLOCK_TIME_NONE;
+  GST_OBJECT_UNLOCK (timeline);
+}
+
+/* Adds the deferred objects to the tracks in one transaction. If @all is
+ * FALSE, the ones still touching the playing stacks stay deferred */
+static void
+add_deferred_objects (GESTimeline * timeline, gboolean all)
+{
+  GESTimelinePrivate *priv = timeline->priv;
+  GList *tmp, *next, *ready = NULL;
+
+  GST_OBJECT_LOCK (timeline);
+  for (tmp = priv->deferred; tmp; tmp = next) {
+    next = tmp->next;
+    if (all || !touches_playing_stack (timeline, tmp->data)) {
+      ready = g_list_append (ready, tmp->data);
+      priv->deferred = g_list_delete_link (priv->deferred, tmp);
+    }
+  }
+  GST_OBJECT_UNLOCK (timeline);
+
+  if (ready == NULL)
+    return;
+
+  GST_DEBUG_OBJECT (timeline, "Adding %u deferred objects",
+      g_list_length (ready));
+
+  ges_timeline_begin_update (timeline);
+  for (tmp = ready; tmp; tmp = tmp->next) {
+    add_object_to_tracks (timeline, (GESTimelineObject *) tmp->data);
+    g_object_unref (tmp->data);
+  }
+  ges_timeline_commit (timeline);
+  g_list_free (ready);
+}
+
+static gboolean
+add_deferred_objects_idle (GESTimeline * timeline)
+{
+  GST_OBJECT_LOCK (timeline);
+  timeline->priv->deferred_idle = 0;
+  GST_OBJECT_UNLOCK (timeline);
+
+  add_deferred_objects (timeline, FALSE);
+
+  return FALSE;
+}
+
+/* Follows the stacks the compositions play. Called from the streaming
+ * threads */
+static gboolean
+track_event_probe (GstPad * pad, GstEvent * event, TrackPrivate * tr_priv)
+{
+  GESTimeline *timeline = tr_priv->timeline;
+  GstFormat format;
+  gint64 start, stop;
+
+  if (GST_EVENT_TYPE (event) != GST_EVENT_NEWSEGMENT)
+    return TRUE;
+
+  gst_event_parse_new_segment (event, NULL, NULL, &format, &start, &stop,
+      NULL);
+  if (format != GST_FORMAT_TIME)
+    return TRUE;
+
+  GST_OBJECT_LOCK (timeline);
+  tr_priv->playing_start = start;
+  tr_priv->playing_stop = stop;
+
+  /* The playback might have left the stacks of some deferred objects */
+  if (timeline->priv->deferred && !timeline->priv->deferred_idle)
+    timeline->priv->deferred_idle = g_idle_add_full (G_PRIORITY_DEFAULT,
+        (GSourceFunc) add_deferred_objects_idle, g_object_ref (timeline),
+        g_object_unref);
+  GST_OBJECT_UNLOCK (timeline);
+
+  return TRUE;
+}
+
+/* Adds a source whose discovery just completed. If the playback already
+ * started in the stack it would be part of, it is deferred until the
+ * playback leaves that stack or the next seek, so that discovering it
+ * doesn't make the compositions flush */
+static void
+add_discovered_object (GESTimeline * timeline, GESTimelineObject * object)
+{
+  gboolean defer;
+
+  GST_OBJECT_LOCK (timeline);
+  defer = touches_playing_stack (timeline, object);
+  if (defer)
+    timeline->priv->deferred = g_list_append (timeline->priv->deferred,
+        g_object_ref (object));
+  GST_OBJECT_UNLOCK (timeline);
+
+  if (defer)
+    GST_DEBUG_OBJECT (timeline, "Deferring %p, its stack is playing", object);
+  else
+    add_object_to_tracks (timeline, object);
+}
+
 
 static void
 do_async_start (GESTimeline * timeline)
@@ -409,9 +789,11 @@ do_async_done (GESTimeline * timeline)
 
   if (timeline->priv->async_pending) {
     GList *tmp;
-    /* Unfreeze state of tracks */
+    /* Unfreeze state of tracks, inactive ones staying shut down */
     for (tmp = timeline->priv->tracks; tmp; tmp = tmp->next) {
       TrackPrivate *tr_priv = (TrackPrivate *) tmp->data;
+      if (!ges_track_get_active (tr_priv->track))
+        continue;
       gst_element_set_locked_state ((GstElement *) tr_priv->track, FALSE);
       gst_element_sync_state_with_parent ((GstElement *) tr_priv->track);
     }
@@ -424,65 +806,248 @@ do_async_done (GESTimeline * timeline)
   }
 }
 
+static DiscovererWorker *
+discoverer_worker_new (GESTimeline * timeline)
+{
+  DiscovererWorker *worker;
+  GstDiscoverer *discoverer;
+  GError *err = NULL;
+
+  discoverer = gst_discoverer_new (timeline->priv->discovery_timeout, &err);
+  if (G_UNLIKELY (discoverer == NULL)) {
+    GST_WARNING ("Could not create discoverer: %s",
+        err ? err->message : "unknown error");
+    if (err)
+      g_error_free (err);
+    return NULL;
+  }
+
+  worker = g_slice_new0 (DiscovererWorker);
+  worker->timeline = timeline;
+  worker->discoverer = discoverer;
+
+  g_signal_connect (discoverer, "discovered",
+      G_CALLBACK (discoverer_discovered_cb), worker);
+  gst_discoverer_start (discoverer);
+
+  g_ptr_array_add (timeline->priv->discoverers, worker);
+
+  return worker;
+}
+
+/* Returns the least busy worker among the ones we are allowed to use,
+ * creating a new one if all existing workers are busy */
+static DiscovererWorker *
+get_discoverer_worker (GESTimeline * timeline)
+{
+  GESTimelinePrivate *priv = timeline->priv;
+  DiscovererWorker *best = NULL, *worker;
+  guint i, n;
+
+  n = MIN (priv->discoverers->len, priv->max_concurrent_discoveries);
+  for (i = 0; i < n; i++) {
+    worker = g_ptr_array_index (priv->discoverers, i);
+
+    if (!best || worker->pending < best->pending)
+      best = worker;
+  }
+
+  if ((!best || best->pending) && n < priv->max_concurrent_discoveries) {
+    if ((worker = discoverer_worker_new (timeline)))
+      best = worker;
+  }
+
+  return best;
+}
+
+static gboolean
+discover_uri (GESTimeline * timeline, const gchar * uri)
+{
+  DiscovererWorker *worker = get_discoverer_worker (timeline);
+
+  if (G_UNLIKELY (worker == NULL)) {
+    GST_ERROR ("No discoverer available to discover %s", uri);
+    return FALSE;
+  }
+
+  GST_DEBUG ("Discovering %s using discoverer %p (%u pending)", uri,
+      worker->discoverer, worker->pending);
+
+  if (!gst_discoverer_discover_uri_async (worker->discoverer, uri)) {
+    GST_WARNING ("Could not queue %s for discovery", uri);
+    return FALSE;
+  }
+
+  worker->pending++;
+
+  return TRUE;
+}
+
+static gboolean
+find_source_in_window (gpointer uri, GList * sources, GstClockTime * window)
+{
+  GList *tmp;
+
+  for (tmp = sources; tmp; tmp = tmp->next) {
+    GESTimelineObject *object = (GESTimelineObject *) tmp->data;
+    GstClockTime start = GES_TIMELINE_OBJECT_START (object);
+    GstClockTime duration = GES_TIMELINE_OBJECT_DURATION (object);
+
+    /* Sources with an unknown duration might cover anything after them */
+    if (start <= window[1] && (duration == 0
+            || duration == GST_CLOCK_TIME_NONE
+            || start + duration > window[0]))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/* Returns TRUE if some of the objects being discovered are needed in order
+ * to preroll */
+static gboolean
+pending_objects_block_preroll (GESTimeline * timeline)
+{
+  GESTimelinePrivate *priv = timeline->priv;
+  GstClockTime window[2];
+
+  if (!priv->partial_preroll)
+    return g_hash_table_size (priv->pendingobjects) != 0;
+
+  window[0] = priv->preroll_position > priv->preroll_window ?
+      priv->preroll_position - priv->preroll_window : 0;
+  window[1] = priv->preroll_position + MIN (priv->preroll_window,
+      G_MAXUINT64 - priv->preroll_position);
+
+  return g_hash_table_find (priv->pendingobjects,
+      (GHRFunc) find_source_in_window, window) != NULL;
+}
+
+/* Completes the asynchronous state change once all discoverers are idle,
+ * or as soon as the objects in the preroll window are discovered if
+ * partial prerolling is enabled */
 static void
-discoverer_finished_cb (GstDiscoverer * discoverer, GESTimeline * timeline)
+check_discovery_done (GESTimeline * timeline)
 {
+  GESTimelinePrivate *priv = timeline->priv;
+  guint i;
+
+  if (priv->partial_preroll && priv->async_pending &&
+      !pending_objects_block_preroll (timeline)) {
+    GST_DEBUG_OBJECT (timeline, "Preroll window discovered");
+    do_async_done (timeline);
+  }
+
+  for (i = 0; i < priv->discoverers->len; i++) {
+    DiscovererWorker *worker = g_ptr_array_index (priv->discoverers, i);
+
+    if (worker->pending)
+      return;
+  }
+
+  GST_DEBUG_OBJECT (timeline, "All discoveries are done");
+
+  if (priv->use_discovery_cache)
+    ges_discovery_cache_save ();
+
   do_async_done (timeline);
 }
 
+/* Reports a source whose uri could not be discovered. No track objects are
+ * created for it */
 static void
-discoverer_discovered_cb (GstDiscoverer * discoverer,
-    GstDiscovererInfo * info, GError * err, GESTimeline * timeline)
+discovery_failed (GESTimeline * timeline, const gchar * uri, GList * sources,
+    GstDiscovererResult result, GError * err)
 {
   GList *tmp;
-  gboolean found = FALSE;
+  const gchar *message;
+
+  switch (result) {
+    case GST_DISCOVERER_URI_INVALID:
+      message = "Invalid uri";
+      break;
+    case GST_DISCOVERER_TIMEOUT:
+      message = "Discovery timed out";
+      break;
+    case GST_DISCOVERER_MISSING_PLUGINS:
+      message = "Missing plugins";
+      break;
+    default:
+      message = err ? err->message : "No usable streams";
+      break;
+  }
+
+  GST_WARNING_OBJECT (timeline, "Could not discover %s: %s", uri, message);
+
+  gst_element_post_message (GST_ELEMENT_CAST (timeline),
+      gst_message_new_element (GST_OBJECT_CAST (timeline),
+          gst_structure_new ("ges-discovery-error",
+              "uri", G_TYPE_STRING, uri,
+              "message", G_TYPE_STRING, message, NULL)));
+
+  for (tmp = sources; tmp; tmp = tmp->next)
+    g_signal_emit (timeline, ges_timeline_signals[DISCOVERY_ERROR], 0,
+        tmp->data, err);
+}
+
+/* Applies the discovered (or cached) properties of a file source */
+static void
+apply_discovery_result (GESTimeline * timeline, GESTimelineFileSource * tfs,
+    GESTrackType formats, guint64 duration, gboolean is_image)
+{
+  ges_timeline_filesource_set_supported_formats (tfs,
+      ges_timeline_filesource_get_supported_formats (tfs) | formats);
+
+  if (is_image) {
+    /* don't set max-duration on still images */
+    g_object_set (tfs, "is_image", (gboolean) TRUE, NULL);
+  }
+
+  else {
+    g_object_set (tfs, "max-duration", duration, NULL);
+  }
+}
+
+static void
+discoverer_discovered_cb (GstDiscoverer * discoverer,
+    GstDiscovererInfo * info, GError * err, DiscovererWorker * worker)
+{
+  GESTimeline *timeline = worker->timeline;
+  GList *tmp, *sources = NULL;
+  gpointer key;
   gboolean is_image = FALSE;
-  GESTimelineFileSource *tfs = NULL;
   GESTimelinePrivate *priv = timeline->priv;
   const gchar *uri = gst_discoverer_info_get_uri (info);
+  GstDiscovererResult result = gst_discoverer_info_get_result (info);
 
   GST_DEBUG ("Discovered uri %s", uri);
 
-  /* Find corresponding TimelineFileSource in the sources */
-  for (tmp = priv->pendingobjects; tmp; tmp = tmp->next) {
-    tfs = (GESTimelineFileSource *) tmp->data;
+  if (worker->pending)
+    worker->pending--;
 
-    if (!g_strcmp0 (ges_timeline_filesource_get_uri (tfs), uri)) {
-      found = TRUE;
-      break;
-    }
-  }
-
-  if (found) {
+  /* Take all the TimelineFileSource waiting for that uri */
+  if (g_hash_table_lookup_extended (priv->pendingobjects, uri, &key,
+          (gpointer *) & sources)) {
     GList *stream_list;
-    GESTrackType tfs_supportedformats;
+    GESTrackType formats = 0;
+    guint64 duration = gst_discoverer_info_get_duration (info);
 
-    /* Remove object from list */
-    priv->pendingobjects = g_list_delete_link (priv->pendingobjects, tmp);
+    g_hash_table_steal (priv->pendingobjects, uri);
+    g_free (key);
 
-    /* FIXME : Handle errors in discovery */
     stream_list = gst_discoverer_info_get_stream_list (info);
 
     /* Update timelinefilesource properties based on info */
     for (tmp = stream_list; tmp; tmp = tmp->next) {
       GstDiscovererStreamInfo *sinf = (GstDiscovererStreamInfo *) tmp->data;
 
-      tfs_supportedformats =
-          ges_timeline_filesource_get_supported_formats (tfs);
-
       if (GST_IS_DISCOVERER_AUDIO_INFO (sinf)) {
-        tfs_supportedformats |= GES_TRACK_TYPE_AUDIO;
-        ges_timeline_filesource_set_supported_formats (tfs,
-            tfs_supportedformats);
+        formats |= GES_TRACK_TYPE_AUDIO;
       } else if (GST_IS_DISCOVERER_VIDEO_INFO (sinf)) {
-        tfs_supportedformats |= GES_TRACK_TYPE_VIDEO;
-        ges_timeline_filesource_set_supported_formats (tfs,
-            tfs_supportedformats);
+        formats |= GES_TRACK_TYPE_VIDEO;
         if (gst_discoverer_video_info_is_image ((GstDiscovererVideoInfo *)
                 sinf)) {
-          tfs_supportedformats |= GES_TRACK_TYPE_AUDIO;
-          ges_timeline_filesource_set_supported_formats (tfs,
-              tfs_supportedformats);
+          formats |= GES_TRACK_TYPE_AUDIO;
           is_image = TRUE;
         }
       }
@@ -491,19 +1056,26 @@ discoverer_discovered_cb (GstDiscoverer * discoverer,
     if (stream_list)
       gst_discoverer_stream_info_list_free (stream_list);
 
-    if (is_image) {
-      /* don't set max-duration on still images */
-      g_object_set (tfs, "is_image", (gboolean) TRUE, NULL);
-    }
+    /* Sources were prepended as they were added */
+    sources = g_list_reverse (sources);
 
-    else {
-      g_object_set (tfs, "max-duration",
-          gst_discoverer_info_get_duration (info), NULL);
-    }
+    if (result != GST_DISCOVERER_OK || formats == 0) {
+      discovery_failed (timeline, uri, sources, result, err);
+    } else {
+      /* Only remember successful discoveries */
+      if (priv->use_discovery_cache)
+        ges_discovery_cache_store (uri, formats, duration, is_image);
 
-    /* Continue the processing on tfs */
-    add_object_to_tracks (timeline, GES_TIMELINE_OBJECT (tfs));
+      for (tmp = sources; tmp; tmp = tmp->next) {
+        apply_discovery_result (timeline,
+            GES_TIMELINE_FILE_SOURCE (tmp->data), formats, duration, is_image);
+        add_discovered_object (timeline, (GESTimelineObject *) tmp->data);
+      }
+    }
+    g_list_free (sources);
   }
+
+  check_discovery_done (timeline);
 }
 
 static GstStateChangeReturn
@@ -514,7 +1086,7 @@ ges_timeline_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_READY_TO_PAUSED:
-      if (timeline->priv->pendingobjects) {
+      if (pending_objects_block_preroll (timeline)) {
         do_async_start (timeline);
         ret = GST_STATE_CHANGE_ASYNC;
       }
@@ -536,6 +1108,8 @@ ges_timeline_change_state (GstElement * element, GstStateChange transition)
   switch (transition) {
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       do_async_done (timeline);
+      reset_playing_stacks (timeline);
+      add_deferred_objects (timeline, TRUE);
       break;
     default:
       break;
@@ -557,6 +1131,10 @@ layer_object_added_cb (GESTimelineLayer * layer, GESTimelineObject * object,
         ges_timeline_filesource_get_supported_formats (tfs);
     guint64 tfs_maxdur = ges_timeline_filesource_get_max_duration (tfs);
     const gchar *tfs_uri;
+    GESTrackType formats;
+    guint64 duration;
+    gboolean is_image;
+    GList *sources;
 
     /* Send the filesource to the discoverer if:
      * * it doesn't have specified supported formats
@@ -565,17 +1143,39 @@ layer_object_added_cb (GESTimelineLayer * layer, GESTimelineObject * object,
 
     if (tfs_supportedformats == GES_TRACK_TYPE_UNKNOWN ||
         tfs_maxdur == GST_CLOCK_TIME_NONE || object->duration == 0) {
-      GST_LOG ("Incomplete TimelineFileSource, discovering it");
       tfs_uri = ges_timeline_filesource_get_uri (tfs);
-      timeline->priv->pendingobjects =
-          g_list_append (timeline->priv->pendingobjects, object);
-      gst_discoverer_discover_uri_async (timeline->priv->discoverer, tfs_uri);
+
+      if (timeline->priv->use_discovery_cache &&
+          ges_discovery_cache_lookup (tfs_uri, &formats, &duration,
+              &is_image)) {
+        GST_LOG ("Incomplete TimelineFileSource, using cached discovery");
+        apply_discovery_result (timeline, tfs, formats, duration, is_image);
+        add_object_to_tracks (timeline, object);
+        goto done;
+      }
+
+      if (g_hash_table_lookup_extended (timeline->priv->pendingobjects,
+              tfs_uri, NULL, (gpointer *) & sources)) {
+        /* Already being discovered, just wait for the result */
+        GST_LOG ("Incomplete TimelineFileSource, uri already being discovered");
+        g_hash_table_insert (timeline->priv->pendingobjects,
+            g_strdup (tfs_uri), g_list_prepend (sources, object));
+        goto done;
+      }
+
+      GST_LOG ("Incomplete TimelineFileSource, discovering it");
+      if (discover_uri (timeline, tfs_uri))
+        g_hash_table_insert (timeline->priv->pendingobjects,
+            g_strdup (tfs_uri), g_list_prepend (NULL, object));
+      else
+        add_object_to_tracks (timeline, object);
     } else
       add_object_to_tracks (timeline, object);
   } else {
     add_object_to_tracks (timeline, object);
   }
 
+done:
   GST_DEBUG ("done");
 }
 
@@ -588,6 +1188,27 @@ layer_object_removed_cb (GESTimelineLayer * layer, GESTimelineObject * object,
 
   GST_DEBUG ("TimelineObject %p removed from layer %p", object, layer);
 
+  if (GES_IS_TIMELINE_FILE_SOURCE (object)) {
+    const gchar *uri =
+        ges_timeline_filesource_get_uri (GES_TIMELINE_FILE_SOURCE (object));
+    GList *sources;
+
+    /* Stop waiting for its discovery. The uri stays in the table until the
+     * discoverer is done with it, so it won't be queued again meanwhile */
+    if (g_hash_table_lookup_extended (timeline->priv->pendingobjects, uri,
+            NULL, (gpointer *) & sources))
+      g_hash_table_insert (timeline->priv->pendingobjects, g_strdup (uri),
+          g_list_remove (sources, object));
+
+    GST_OBJECT_LOCK (timeline);
+    if ((tmp = g_list_find (timeline->priv->deferred, object))) {
+      timeline->priv->deferred =
+          g_list_delete_link (timeline->priv->deferred, tmp);
+      g_object_unref (object);
+    }
+    GST_OBJECT_UNLOCK (timeline);
+  }
+
   /* Go over the object's track objects and figure out which one belongs to
    * the list of tracks we control */
 
@@ -744,6 +1365,8 @@ pad_added_cb (GESTrack * track, GstPad * pad, TrackPrivate * tr_priv)
   tr_priv->ghostpad = gst_ghost_pad_new (padname, pad);
   g_free (padname);
   gst_pad_set_active (tr_priv->ghostpad, TRUE);
+  gst_pad_add_event_probe (tr_priv->ghostpad, G_CALLBACK (track_event_probe),
+      tr_priv);
   gst_element_add_pad (GST_ELEMENT (tr_priv->timeline), tr_priv->ghostpad);
 }
 
@@ -767,6 +1390,10 @@ pad_removed_cb (GESTrack * track, GstPad * pad, TrackPrivate * tr_priv)
   gst_element_remove_pad (GST_ELEMENT (tr_priv->timeline), tr_priv->ghostpad);
   tr_priv->ghostpad = NULL;
   tr_priv->pad = NULL;
+
+  GST_OBJECT_LOCK (tr_priv->timeline);
+  tr_priv->playing_start = GST_CLOCK_TIME_NONE;
+  GST_OBJECT_UNLOCK (tr_priv->timeline);
 }
 
 static gint
@@ -818,6 +1445,7 @@ ges_timeline_add_track (GESTimeline * timeline, GESTrack * track)
   tr_priv = g_new0 (TrackPrivate, 1);
   tr_priv->timeline = timeline;
   tr_priv->track = track;
+  tr_priv->playing_start = GST_CLOCK_TIME_NONE;
 
   /* Add the track to the list of tracks we track */
   priv->tracks = g_list_append (priv->tracks, tr_priv);
@@ -829,6 +1457,10 @@ ges_timeline_add_track (GESTimeline * timeline, GESTrack * track)
   /* Inform the track that it's currently being used by ourself */
   ges_track_set_timeline (track, timeline);
 
+  /* The track joins any pending transaction */
+  if (priv->update_depth)
+    ges_track_enable_update (track, FALSE);
+
   GST_DEBUG ("Done adding track, emitting 'track-added' signal");
 
   /* emit 'track-added' */
@@ -890,6 +1522,10 @@ ges_timeline_remove_track (GESTimeline * timeline, GESTrack * track)
 
   ges_track_set_timeline (track, NULL);
 
+  /* Don't leave the track frozen by our pending transaction */
+  if (priv->update_depth)
+    ges_track_enable_update (track, TRUE);
+
   /* Remove ghost pad */
   if (tr_priv->ghostpad) {
     GST_DEBUG ("Removing ghostpad");
@@ -992,3 +1628,86 @@ ges_timeline_get_layers (GESTimeline * timeline)
 
   return res;
 }
+
+static void
+set_tracks_update (GESTimeline * timeline, gboolean enabled)
+{
+  GList *tmp;
+
+  for (tmp = timeline->priv->tracks; tmp; tmp = tmp->next)
+    ges_track_enable_update (((TrackPrivate *) tmp->data)->track, enabled);
+}
+
+/**
+ * ges_timeline_begin_update:
+ * @timeline: a #GESTimeline
+ *
+ * Opens an edit transaction on @timeline. Until the matching
+ * ges_timeline_commit(), changes made to the timeline objects are recorded
+ * but the compositions of the tracks are not updated, so that moving,
+ * trimming or adding many objects only costs one update per #GESTrack.
+ *
+ * Transactions can be nested, the compositions are only updated when the
+ * outermost one is committed.
+ */
+void
+ges_timeline_begin_update (GESTimeline * timeline)
+{
+  g_return_if_fail (GES_IS_TIMELINE (timeline));
+
+  GST_DEBUG ("timeline:%p, depth:%u", timeline, timeline->priv->update_depth);
+
+  if (timeline->priv->update_depth++ == 0)
+    set_tracks_update (timeline, FALSE);
+}
+
+/**
+ * ges_timeline_commit:
+ * @timeline: a #GESTimeline
+ *
+ * Closes the edit transaction opened by the last call to
+ * ges_timeline_begin_update(). If it was the outermost one, the composition
+ * of each #GESTrack is updated once with all the recorded changes.
+ *
+ * Returns: TRUE if a transaction was closed, FALSE if none was open.
+ */
+gboolean
+ges_timeline_commit (GESTimeline * timeline)
+{
+  g_return_val_if_fail (GES_IS_TIMELINE (timeline), FALSE);
+  g_return_val_if_fail (timeline->priv->update_depth > 0, FALSE);
+
+  GST_DEBUG ("timeline:%p, depth:%u", timeline, timeline->priv->update_depth);
+
+  if (--timeline->priv->update_depth == 0)
+    set_tracks_update (timeline, TRUE);
+
+  return TRUE;
+}
+
+/**
+ * ges_timeline_move_window:
+ * @timeline: a #GESTimeline
+ * @position: the new position (in nanoseconds)
+ *
+ * Calls ges_track_move_window() on all the tracks of @timeline, so that the
+ * objects around @position have their contents in the tracks having a
+ * #GESTrack:lookahead. The sources whose discovery completed while their
+ * part of the timeline was playing are added to the tracks first.
+ */
+void
+ges_timeline_move_window (GESTimeline * timeline, GstClockTime position)
+{
+  GList *tmp;
+
+  g_return_if_fail (GES_IS_TIMELINE (timeline));
+
+  GST_DEBUG ("timeline:%p, position:%" GST_TIME_FORMAT, timeline,
+      GST_TIME_ARGS (position));
+
+  /* The seek that follows flushes anyway */
+  add_deferred_objects (timeline, TRUE);
+
+  for (tmp = timeline->priv->tracks; tmp; tmp = tmp->next)
+    ges_track_move_window (((TrackPrivate *) tmp->data)->track, position);
+}
@@ -98,6 +98,11 @@ gboolean ges_timeline_remove_track (GESTimeline *timeline, GESTrack *track);
 GESTrack * ges_timeline_get_track_for_pad (GESTimeline *timeline, GstPad *pad);
 GList *ges_timeline_get_tracks (GESTimeline *timeline);
 
+void ges_timeline_begin_update (GESTimeline *timeline);
+gboolean ges_timeline_commit (GESTimeline *timeline);
+
+void ges_timeline_move_window (GESTimeline *timeline, GstClockTime position);
+
 G_END_DECLS
 
 #endif /* _GES_TIMELINE */
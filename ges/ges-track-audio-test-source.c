@@ -53,6 +53,9 @@ static void ges_track_audio_test_source_set_property (GObject * object, guint
 
 static GstElement *ges_track_audio_test_source_create_element (GESTrackObject *
     self);
+static gchar *ges_track_audio_test_source_recycle_key (GESTrackObject * self);
+static void ges_track_audio_test_source_reuse (GESTrackObject * self,
+    GstElement * element);
 
 static void
 ges_track_audio_test_source_class_init (GESTrackAudioTestSourceClass * klass)
@@ -66,6 +69,9 @@ ges_track_audio_test_source_class_init (GESTrackAudioTestSourceClass * klass)
   object_class->set_property = ges_track_audio_test_source_set_property;
 
   bg_class->create_element = ges_track_audio_test_source_create_element;
+  ges_track_object_class_set_recycle_funcs (bg_class,
+      ges_track_audio_test_source_recycle_key,
+      ges_track_audio_test_source_reuse);
 }
 
 static void
@@ -112,6 +118,24 @@ ges_track_audio_test_source_create_element (GESTrackObject * trksrc)
   return ret;
 }
 
+/* Any audiotestsrc can be reused, we set our frequency and volume on it */
+static gchar *
+ges_track_audio_test_source_recycle_key (GESTrackObject * trksrc)
+{
+  return g_strdup ("");
+}
+
+static void
+ges_track_audio_test_source_reuse (GESTrackObject * trksrc,
+    GstElement * element)
+{
+  GESTrackAudioTestSource *self = (GESTrackAudioTestSource *) trksrc;
+
+  if (element)
+    g_object_set (element, "volume", (gdouble) self->priv->volume, "freq",
+        (gdouble) self->priv->freq, NULL);
+}
+
 /**
  * ges_track_audio_test_source_set_freq:
  * @self: a #GESTrackAudioTestSource
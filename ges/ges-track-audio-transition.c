@@ -103,12 +103,8 @@ ges_track_audio_transition_init (GESTrackAudioTransition * self)
 }
 
 static void
-ges_track_audio_transition_dispose (GObject * object)
+release_controllers (GESTrackAudioTransition * self)
 {
-  GESTrackAudioTransition *self;
-
-  self = GES_TRACK_AUDIO_TRANSITION (object);
-
   if (self->priv->a_controller) {
     g_object_unref (self->priv->a_controller);
     self->priv->a_controller = NULL;
@@ -124,6 +120,16 @@ ges_track_audio_transition_dispose (GObject * object)
       gst_object_unref (self->priv->b_control_source);
     self->priv->b_control_source = NULL;
   }
+}
+
+static void
+ges_track_audio_transition_dispose (GObject * object)
+{
+  GESTrackAudioTransition *self;
+
+  self = GES_TRACK_AUDIO_TRANSITION (object);
+
+  release_controllers (self);
 
   G_OBJECT_CLASS (ges_track_audio_transition_parent_class)->dispose (object);
 }
@@ -183,6 +189,7 @@ ges_track_audio_transition_create_element (GESTrackObject * object)
 
   self = GES_TRACK_AUDIO_TRANSITION (object);
 
+  release_controllers (self);
 
   GST_LOG ("creating an audio bin");
 
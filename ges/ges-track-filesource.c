@@ -29,6 +29,8 @@
 #include "ges-internal.h"
 #include "ges-track-object.h"
 #include "ges-track-filesource.h"
+#include "ges-track.h"
+#include "ges-utils.h"
 
 G_DEFINE_TYPE (GESTrackFileSource, ges_track_filesource, GES_TYPE_TRACK_SOURCE);
 
@@ -85,15 +87,112 @@ ges_track_filesource_dispose (GObject * object)
   G_OBJECT_CLASS (ges_track_filesource_parent_class)->dispose (object);
 }
 
+static void
+pad_added_cb (GstElement * decodebin, GstPad * pad, GstElement * filter)
+{
+  GstPad *sinkpad = gst_element_get_static_pad (filter, "sink");
+
+  if (gst_pad_is_linked (sinkpad) ||
+      GST_PAD_LINK_FAILED (gst_pad_link (pad, sinkpad)))
+    GST_DEBUG ("Couldn't link %" GST_PTR_FORMAT, pad);
+
+  gst_object_unref (sinkpad);
+}
+
+/* The uri to decode: the proxy of our uri when the track uses proxies and
+ * it is ready. If it isn't and @request is set, it gets created so that we
+ * can switch to it later on. */
+static gchar *
+get_decoding_uri (GESTrackObject * object, gboolean request)
+{
+  GESTrack *track = ges_track_object_get_track (object);
+  const gchar *uri = ((GESTrackFileSource *) object)->uri;
+  gchar *proxy = NULL;
+
+  if (track && ges_track_get_use_proxies (track)) {
+    if (request)
+      proxy = ges_proxy_cache_request (uri);
+    else
+      proxy = ges_proxy_cache_get_proxy_uri (uri);
+  }
+
+  return proxy ? proxy : g_strdup (uri);
+}
+
+/* This is what gnlurisource does internally, but having the decoder as our
+ * element lets the track only create it when the object is about to be
+ * used, and decide whether the stream can be passed through compressed.
+ * It is used even when the track has no lookahead, since the proxies, the
+ * restriction filter and the recycling of decoders all rely on it. */
 static GstElement *
-ges_track_filesource_create_gnl_object (GESTrackObject * object)
+ges_track_filesource_create_element (GESTrackObject * object)
 {
-  GstElement *gnlobject;
+  GstElement *decodebin, *filter = NULL, *bin;
+  GESTrack *track = ges_track_object_get_track (object);
+  GstPad *target;
+  gchar *uri;
+
+  decodebin = gst_element_factory_make ("uridecodebin", NULL);
+  if (G_UNLIKELY (decodebin == NULL))
+    return NULL;
+
+  uri = get_decoding_uri (object, TRUE);
+  g_object_set (decodebin, "uri", uri, NULL);
+  g_free (uri);
 
-  gnlobject = gst_element_factory_make ("gnlurisource", NULL);
-  g_object_set (gnlobject, "uri", ((GESTrackFileSource *) object)->uri, NULL);
+  if (track) {
+    GstCaps *caps = ges_track_get_decoding_caps (track, object);
 
-  return gnlobject;
+    g_object_set (decodebin, "caps", caps, NULL);
+    gst_caps_unref (caps);
+    filter = ges_track_create_restriction_filter (track);
+  }
+
+  if (g_object_class_find_property (G_OBJECT_GET_CLASS (decodebin),
+          "expose-all-streams"))
+    g_object_set (decodebin, "expose-all-streams", FALSE, NULL);
+
+  if (filter == NULL)
+    return decodebin;
+
+  /* Convert the stream right after decoding, so that everything downstream
+   * in the track works on the restricted format */
+  bin = gst_bin_new ("filesource-bin");
+  gst_bin_add_many (GST_BIN (bin), decodebin, filter, NULL);
+  g_signal_connect (decodebin, "pad-added", G_CALLBACK (pad_added_cb),
+      filter);
+
+  target = gst_element_get_static_pad (filter, "src");
+  gst_element_add_pad (bin, gst_ghost_pad_new ("src", target));
+  gst_object_unref (target);
+
+  return bin;
+}
+
+static gchar *
+ges_track_filesource_recycle_key (GESTrackObject * object)
+{
+  GESTrack *track = ges_track_object_get_track (object);
+  const GstCaps *restriction = NULL;
+  gchar *caps = NULL, *rcaps = NULL, *uri, *key;
+
+  if (track) {
+    GstCaps *decoding = ges_track_get_decoding_caps (track, object);
+
+    caps = gst_caps_to_string (decoding);
+    gst_caps_unref (decoding);
+    if ((restriction = ges_track_get_restriction_caps (track)))
+      rcaps = gst_caps_to_string (restriction);
+  }
+  /* Sources switch to the proxy of their uri once it's ready */
+  uri = get_decoding_uri (object, FALSE);
+  key = g_strdup_printf ("%s %s %s", uri, caps ? caps : "",
+      rcaps ? rcaps : "");
+  g_free (uri);
+  g_free (caps);
+  g_free (rcaps);
+
+  return key;
 }
 
 static void
@@ -116,7 +215,9 @@ ges_track_filesource_class_init (GESTrackFileSourceClass * klass)
   g_object_class_install_property (object_class, PROP_URI,
       g_param_spec_string ("uri", "URI", "uri of the resource",
           NULL, G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
-  track_class->create_gnl_object = ges_track_filesource_create_gnl_object;
+  track_class->create_element = ges_track_filesource_create_element;
+  ges_track_object_class_set_recycle_funcs (track_class,
+      ges_track_filesource_recycle_key, NULL);
 }
 
 static void
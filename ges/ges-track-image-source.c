@@ -31,6 +31,7 @@
 #include "ges-internal.h"
 #include "ges-track-object.h"
 #include "ges-track-image-source.h"
+#include "ges-track.h"
 
 G_DEFINE_TYPE (GESTrackImageSource, ges_track_image_source,
     GES_TYPE_TRACK_SOURCE);
@@ -113,7 +114,8 @@ pad_added_cb (GstElement * timeline, GstPad * pad, GstElement * scale)
 static GstElement *
 ges_track_image_source_create_element (GESTrackObject * object)
 {
-  GstElement *bin, *source, *scale, *freeze, *iconv;
+  GstElement *bin, *source, *scale, *freeze, *iconv, *filter = NULL;
+  GESTrack *track = ges_track_object_get_track (object);
   GstPad *src, *target;
 
   bin = GST_ELEMENT (gst_bin_new ("still-image-bin"));
@@ -128,11 +130,20 @@ ges_track_image_source_create_element (GESTrackObject * object)
 
   gst_element_link_pads_full (scale, "src", iconv, "sink",
       GST_PAD_LINK_CHECK_NOTHING);
-  gst_element_link_pads_full (iconv, "src", freeze, "sink",
-      GST_PAD_LINK_CHECK_NOTHING);
 
   /* FIXME: add capsfilter here with sink caps (see 626518) */
 
+  /* Only scaled down once, before being repeated */
+  if (track && (filter = ges_track_create_restriction_filter (track))) {
+    gst_bin_add (GST_BIN (bin), filter);
+    gst_element_link_pads_full (iconv, "src", filter, "sink",
+        GST_PAD_LINK_CHECK_NOTHING);
+    gst_element_link_pads_full (filter, "src", freeze, "sink",
+        GST_PAD_LINK_CHECK_NOTHING);
+  } else
+    gst_element_link_pads_full (iconv, "src", freeze, "sink",
+        GST_PAD_LINK_CHECK_NOTHING);
+
   target = gst_element_get_static_pad (freeze, "src");
 
   src = gst_ghost_pad_new ("src", target);
@@ -147,6 +158,25 @@ ges_track_image_source_create_element (GESTrackObject * object)
   return bin;
 }
 
+static gchar *
+ges_track_image_source_recycle_key (GESTrackObject * object)
+{
+  GESTrack *track = ges_track_object_get_track (object);
+  const GstCaps *restriction = NULL;
+  gchar *caps, *key;
+
+  if (track)
+    restriction = ges_track_get_restriction_caps (track);
+  if (restriction == NULL)
+    return g_strdup (((GESTrackImageSource *) object)->uri);
+
+  caps = gst_caps_to_string (restriction);
+  key = g_strdup_printf ("%s %s", ((GESTrackImageSource *) object)->uri, caps);
+  g_free (caps);
+
+  return key;
+}
+
 static void
 ges_track_image_source_class_init (GESTrackImageSourceClass * klass)
 {
@@ -168,6 +198,8 @@ ges_track_image_source_class_init (GESTrackImageSourceClass * klass)
       g_param_spec_string ("uri", "URI", "uri of the resource",
           NULL, G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
   gesobj_class->create_element = ges_track_image_source_create_element;
+  ges_track_object_class_set_recycle_funcs (gesobj_class,
+      ges_track_image_source_recycle_key, NULL);
 }
 
 static void
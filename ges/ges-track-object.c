@@ -54,6 +54,13 @@ struct _GESTrackObjectPrivate
 
   gboolean valid;
 
+  gboolean materialized;        /* TRUE once the contents of the gnlobject were
+                                 * created, else the gnlobject is an inactive
+                                 * placeholder */
+  gchar *recycle_key;           /* Configuration @element was created for */
+  gint covered;                 /* Whether an operation plays over us, as
+                                 * cached by the track, -1 if unknown */
+
   gboolean locked;              /* If TRUE, then moves in sync with its controlling
                                  * GESTimelineObject */
 };
@@ -71,6 +78,14 @@ enum
 
 static GParamSpec *properties[PROP_LAST];
 
+typedef struct
+{
+  GESRecycleKeyFunc get_key;
+  GESRecycleFunc reuse;
+} RecycleFuncs;
+
+static GQuark recycle_quark;
+
 static GstElement *ges_track_object_create_gnl_object_func (GESTrackObject *
     object);
 
@@ -162,6 +177,8 @@ ges_track_object_dispose (GObject * object)
 static void
 ges_track_object_finalize (GObject * object)
 {
+  g_free (((GESTrackObject *) object)->priv->recycle_key);
+
   G_OBJECT_CLASS (ges_track_object_parent_class)->finalize (object);
 }
 
@@ -244,6 +261,8 @@ ges_track_object_class_init (GESTrackObjectClass * klass)
       properties[PROP_ACTIVE]);
 
   klass->create_gnl_object = ges_track_object_create_gnl_object_func;
+
+  recycle_quark = g_quark_from_static_string ("ges-track-object-recycle");
 }
 
 static void
@@ -259,6 +278,7 @@ ges_track_object_init (GESTrackObject * self)
   self->priv->pending_priority = 1;
   self->priv->pending_active = TRUE;
   self->priv->locked = TRUE;
+  self->priv->covered = -1;
 }
 
 static inline gboolean
@@ -425,16 +445,80 @@ ges_track_object_set_active (GESTrackObject * object, gboolean active)
 {
   GST_DEBUG ("object:%p, active:%d", object, active);
 
-  if (object->priv->gnlobject != NULL) {
+  if (object->priv->gnlobject != NULL && object->priv->materialized) {
     if (G_UNLIKELY (active == object->active))
       return FALSE;
 
     g_object_set (object->priv->gnlobject, "active", active, NULL);
-  } else
+  } else {
     object->priv->pending_active = active;
+    /* Placeholders stay inactive, the value is applied once materialized */
+    if (object->priv->gnlobject != NULL)
+      object->active = active;
+  }
   return TRUE;
 }
 
+static inline void
+notify_property (GESTrackObject * object, guint property_id)
+{
+#if GLIB_CHECK_VERSION(2,26,0)
+  g_object_notify_by_pspec (G_OBJECT (object), properties[property_id]);
+#else
+  g_object_notify (G_OBJECT (object), properties[property_id]->name);
+#endif
+}
+
+/* INTERNAL USAGE
+ *
+ * Sets the start, in-point, duration and priority of @object at once. The
+ * gnlobject gets all of them in a single g_object_set() and the resulting
+ * notifications of @object are only emitted once everything was applied. */
+void
+ges_track_object_set_timing (GESTrackObject * object, guint64 start,
+    guint64 inpoint, guint64 duration, guint32 priority)
+{
+  GESTrackObjectPrivate *priv = object->priv;
+  guint64 old_start = object->start, old_inpoint = object->inpoint;
+  guint64 old_duration = object->duration;
+  guint32 old_priority = object->priority;
+
+  GST_DEBUG ("object:%p, start:%" GST_TIME_FORMAT ", inpoint:%"
+      GST_TIME_FORMAT ", duration:%" GST_TIME_FORMAT ", priority:%d", object,
+      GST_TIME_ARGS (start), GST_TIME_ARGS (inpoint), GST_TIME_ARGS (duration),
+      priority);
+
+  g_object_freeze_notify (G_OBJECT (object));
+
+  if (priv->gnlobject != NULL) {
+    g_object_set (priv->gnlobject, "start", start, "media-start", inpoint,
+        "duration", duration, "media-duration", duration, "priority", priority,
+        NULL);
+
+    /* The gnlobject callbacks updated our fields, only notify what changed */
+    if (object->start != old_start)
+      notify_property (object, PROP_START);
+    if (object->inpoint != old_inpoint)
+      notify_property (object, PROP_INPOINT);
+    if (object->duration != old_duration)
+      notify_property (object, PROP_DURATION);
+    if (object->priority != old_priority)
+      notify_property (object, PROP_PRIORITY);
+  } else {
+    priv->pending_start = start;
+    priv->pending_inpoint = inpoint;
+    priv->pending_duration = duration;
+    priv->pending_priority = priority;
+
+    notify_property (object, PROP_START);
+    notify_property (object, PROP_INPOINT);
+    notify_property (object, PROP_DURATION);
+    notify_property (object, PROP_PRIORITY);
+  }
+
+  g_object_thaw_notify (G_OBJECT (object));
+}
+
 /* Callbacks from the GNonLin object */
 static void
 gnlobject_start_cb (GstElement * gnlobject, GParamSpec * arg G_GNUC_UNUSED,
@@ -454,6 +538,8 @@ gnlobject_start_cb (GstElement * gnlobject, GParamSpec * arg G_GNUC_UNUSED,
     obj->start = start;
     if (klass->start_changed)
       klass->start_changed (obj, start);
+    if (obj->priv->track && obj->priv->valid)
+      ges_track_object_moved (obj->priv->track, obj);
   }
 }
 
@@ -517,6 +603,8 @@ gnlobject_duration_cb (GstElement * gnlobject, GParamSpec * arg G_GNUC_UNUSED,
     obj->duration = duration;
     if (klass->duration_changed)
       klass->duration_changed (obj, duration);
+    if (obj->priv->track && obj->priv->valid)
+      ges_track_object_moved (obj->priv->track, obj);
   }
 }
 
@@ -527,6 +615,11 @@ gnlobject_active_cb (GstElement * gnlobject, GParamSpec * arg G_GNUC_UNUSED,
   gboolean active;
   GESTrackObjectClass *klass;
 
+  /* Placeholders are kept inactive on purpose, that isn't a change of
+   * our active property */
+  if (!obj->priv->materialized)
+    return;
+
   klass = GES_TRACK_OBJECT_GET_CLASS (obj);
 
   g_object_get (gnlobject, "active", &active, NULL);
@@ -546,7 +639,6 @@ static GstElement *
 ges_track_object_create_gnl_object_func (GESTrackObject * self)
 {
   GESTrackObjectClass *klass = NULL;
-  GstElement *child = NULL;
   GstElement *gnlobject;
 
   klass = GES_TRACK_OBJECT_GET_CLASS (self);
@@ -565,20 +657,6 @@ ges_track_object_create_gnl_object_func (GESTrackObject * self)
   if (G_UNLIKELY (gnlobject == NULL))
     goto no_gnlobject;
 
-  if (klass->create_element) {
-    GST_DEBUG ("Calling subclass 'create_element' vmethod");
-    child = klass->create_element (self);
-
-    if (G_UNLIKELY (!child))
-      goto child_failure;
-
-    if (!gst_bin_add (GST_BIN (gnlobject), child))
-      goto add_failure;
-
-    GST_DEBUG ("Succesfully got the element to put in the gnlobject");
-    self->priv->element = child;
-  }
-
   GST_DEBUG ("done");
   return gnlobject;
 
@@ -604,21 +682,210 @@ no_gnlobject:
         klass->gnlobject_factorytype);
     return NULL;
   }
+}
 
-child_failure:
-  {
-    GST_ERROR ("create_element returned NULL");
-    gst_object_unref (gnlobject);
-    return NULL;
+/* Removes all the contents of @gnlobject */
+static void
+empty_gnlobject (GstElement * gnlobject)
+{
+  GList *children;
+
+  while ((children = GST_BIN_CHILDREN (gnlobject))) {
+    GstElement *child = (GstElement *) children->data;
+
+    gst_element_set_state (child, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (gnlobject), child);
   }
+}
 
-add_failure:
-  {
-    GST_ERROR ("Error adding the contents to the gnlobject");
+/* INTERNAL USAGE
+ *
+ * Creates the contents of the gnlobject of @object, that is the element
+ * returned by the 'create_element' vmethod and whatever the controlling
+ * timeline object fills in, and activates it.
+ *
+ * Returns: TRUE if @object has its contents, else FALSE. */
+gboolean
+ges_track_object_materialize (GESTrackObject * object)
+{
+  GESTrackObjectClass *klass = GES_TRACK_OBJECT_GET_CLASS (object);
+  GESTrackObjectPrivate *priv = object->priv;
+  RecycleFuncs *recycle;
+  GstElement *child = NULL;
+
+  if (priv->materialized)
+    return TRUE;
+
+  if (G_UNLIKELY (priv->gnlobject == NULL))
+    return FALSE;
+
+  GST_DEBUG ("object:%p", object);
+
+  if (klass->create_element) {
+    recycle = g_type_get_qdata (G_OBJECT_TYPE (object), recycle_quark);
+
+    if (recycle) {
+      g_free (priv->recycle_key);
+      priv->recycle_key = recycle->get_key (object);
+
+      child = ges_element_pool_acquire (G_OBJECT_TYPE (object),
+          priv->recycle_key);
+    }
+
+    if (child) {
+      GST_DEBUG ("Reusing recycled element %" GST_PTR_FORMAT, child);
+      if (recycle->reuse)
+        recycle->reuse (object, child);
+    } else {
+      /* This is called again after ges_track_object_release_contents(),
+       * the subclasses drop what they kept from the previous call */
+      GST_DEBUG ("Calling subclass 'create_element' vmethod");
+      child = klass->create_element (object);
+
+      if (G_UNLIKELY (!child)) {
+        GST_ERROR ("create_element returned NULL");
+        return FALSE;
+      }
+
+      /* Recycled elements aren't floating, make them look like new ones */
+      gst_object_ref_sink (child);
+    }
+
+    if (G_UNLIKELY (!gst_bin_add (GST_BIN (priv->gnlobject), child))) {
+      GST_ERROR ("Error adding the contents to the gnlobject");
+      gst_object_unref (child);
+      return FALSE;
+    }
     gst_object_unref (child);
-    gst_object_unref (gnlobject);
-    return NULL;
+
+    GST_DEBUG ("Succesfully got the element to put in the gnlobject");
+    priv->element = child;
   }
+
+  if (G_UNLIKELY (!ges_timeline_object_fill_track_object (priv->timelineobj,
+              object, priv->gnlobject))) {
+    GST_WARNING ("Couldn't fill the gnlobject");
+    empty_gnlobject (priv->gnlobject);
+    priv->element = NULL;
+    return FALSE;
+  }
+
+  priv->materialized = TRUE;
+
+  /* The contents were created after the gnlobject got its duration, let the
+   * subclasses configure them */
+  if (klass->duration_changed)
+    klass->duration_changed (object, object->duration);
+
+  g_object_set (priv->gnlobject, "active", priv->pending_active, NULL);
+
+  return TRUE;
+}
+
+/* INTERNAL USAGE
+ *
+ * Drops the contents of the gnlobject of @object, turning it back into an
+ * inactive placeholder. The timing of @object is left untouched and the
+ * contents get created again by ges_track_object_materialize(). */
+void
+ges_track_object_release_contents (GESTrackObject * object)
+{
+  GESTrackObjectPrivate *priv = object->priv;
+  RecycleFuncs *recycle;
+
+  if (!priv->materialized)
+    return;
+
+  GST_DEBUG ("object:%p", object);
+
+  priv->materialized = FALSE;
+  priv->pending_active = object->active;
+
+  g_object_set (priv->gnlobject, "active", FALSE, NULL);
+
+  /* The element goes back to the pool under the configuration it was
+   * created for, which might not be the current one of @object anymore */
+  recycle = g_type_get_qdata (G_OBJECT_TYPE (object), recycle_quark);
+  if (priv->element && recycle) {
+    GstElement *element = gst_object_ref (priv->element);
+
+    if (recycle->reuse)
+      recycle->reuse (object, NULL);
+
+    gst_element_set_state (element, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (priv->gnlobject), element);
+    ges_element_pool_release (G_OBJECT_TYPE (object), priv->recycle_key,
+        element);
+  }
+
+  empty_gnlobject (priv->gnlobject);
+  priv->element = NULL;
+}
+
+/* INTERNAL USAGE
+ *
+ * Returns: TRUE if the contents of @object were created for another
+ * configuration than its current one, and need to be created again */
+gboolean
+ges_track_object_contents_outdated (GESTrackObject * object)
+{
+  RecycleFuncs *recycle;
+  gchar *key;
+  gboolean ret;
+
+  if (!object->priv->materialized || object->priv->element == NULL)
+    return FALSE;
+
+  recycle = g_type_get_qdata (G_OBJECT_TYPE (object), recycle_quark);
+  if (recycle == NULL)
+    return FALSE;
+
+  key = recycle->get_key (object);
+  ret = g_strcmp0 (key, object->priv->recycle_key) != 0;
+  g_free (key);
+
+  return ret;
+}
+
+/* INTERNAL USAGE
+ *
+ * Returns: whether an operation plays over @object, as last set by its
+ * track, or -1 if that isn't known */
+gint
+ges_track_object_get_covered (GESTrackObject * object)
+{
+  return object->priv->covered;
+}
+
+/* INTERNAL USAGE
+ *
+ * Caches whether an operation plays over @object, -1 to have the track
+ * check it again */
+void
+ges_track_object_set_covered (GESTrackObject * object, gint covered)
+{
+  object->priv->covered = covered;
+}
+
+/* INTERNAL USAGE
+ *
+ * Lets the elements created by the 'create_element' vmethod of @klass be
+ * handed to the next object of the same type and configuration once they
+ * are released, see ges-element-pool.c */
+void
+ges_track_object_class_set_recycle_funcs (GESTrackObjectClass * klass,
+    GESRecycleKeyFunc get_key, GESRecycleFunc reuse)
+{
+  RecycleFuncs *funcs;
+
+  g_return_if_fail (get_key != NULL);
+
+  /* Lives as long as the class */
+  funcs = g_new0 (RecycleFuncs, 1);
+  funcs->get_key = get_key;
+  funcs->reuse = reuse;
+
+  g_type_set_qdata (G_TYPE_FROM_CLASS (klass), recycle_quark, funcs);
 }
 
 static gboolean
@@ -654,39 +921,38 @@ ensure_gnl_object (GESTrackObject * object)
 
   object->priv->gnlobject = gnlobject;
 
-  /* 2. Fill in the GnlObject */
-  if (gnlobject) {
-    GST_DEBUG ("Got a valid GnlObject, now filling it in");
-
-    res =
-        ges_timeline_object_fill_track_object (object->priv->timelineobj,
-        object, object->priv->gnlobject);
-    if (res) {
-      /* Connect to property notifications */
-      /* FIXME : remember the signalids so we can remove them later on !!! */
-      g_signal_connect (G_OBJECT (object->priv->gnlobject), "notify::start",
-          G_CALLBACK (gnlobject_start_cb), object);
-      g_signal_connect (G_OBJECT (object->priv->gnlobject),
-          "notify::media-start", G_CALLBACK (gnlobject_media_start_cb), object);
-      g_signal_connect (G_OBJECT (object->priv->gnlobject), "notify::duration",
-          G_CALLBACK (gnlobject_duration_cb), object);
-      g_signal_connect (G_OBJECT (object->priv->gnlobject), "notify::priority",
-          G_CALLBACK (gnlobject_priority_cb), object);
-      g_signal_connect (G_OBJECT (object->priv->gnlobject), "notify::active",
-          G_CALLBACK (gnlobject_active_cb), object);
-
-      /* Set some properties on the GnlObject */
-      g_object_set (object->priv->gnlobject,
-          "caps", ges_track_get_caps (object->priv->track),
-          "duration", object->priv->pending_duration,
-          "media-duration", object->priv->pending_duration,
-          "start", object->priv->pending_start,
-          "media-start", object->priv->pending_inpoint,
-          "priority", object->priv->pending_priority,
-          "active", object->priv->pending_active, NULL);
-
-    }
-  }
+  /* 2. Set it up as an inactive placeholder */
+  GST_DEBUG ("Got a valid GnlObject, now setting it up");
+
+  /* Connect to property notifications */
+  /* FIXME : remember the signalids so we can remove them later on !!! */
+  g_signal_connect (G_OBJECT (object->priv->gnlobject), "notify::start",
+      G_CALLBACK (gnlobject_start_cb), object);
+  g_signal_connect (G_OBJECT (object->priv->gnlobject),
+      "notify::media-start", G_CALLBACK (gnlobject_media_start_cb), object);
+  g_signal_connect (G_OBJECT (object->priv->gnlobject), "notify::duration",
+      G_CALLBACK (gnlobject_duration_cb), object);
+  g_signal_connect (G_OBJECT (object->priv->gnlobject), "notify::priority",
+      G_CALLBACK (gnlobject_priority_cb), object);
+  g_signal_connect (G_OBJECT (object->priv->gnlobject), "notify::active",
+      G_CALLBACK (gnlobject_active_cb), object);
+
+  /* Set some properties on the GnlObject */
+  object->active = object->priv->pending_active;
+  g_object_set (object->priv->gnlobject,
+      "caps", ges_track_get_caps (object->priv->track),
+      "duration", object->priv->pending_duration,
+      "media-duration", object->priv->pending_duration,
+      "start", object->priv->pending_start,
+      "media-start", object->priv->pending_inpoint,
+      "priority", object->priv->pending_priority, "active", FALSE, NULL);
+
+  /* 3. Fill it in, unless the track only wants that once the object gets
+   * close to the current position */
+  if (ges_track_is_in_window (object->priv->track, object))
+    res = ges_track_object_materialize (object);
+  else
+    res = TRUE;
 
 done:
   object->priv->valid = res;
@@ -703,6 +969,7 @@ ges_track_object_set_track (GESTrackObject * object, GESTrack * track)
   GST_DEBUG ("object:%p, track:%p", object, track);
 
   object->priv->track = track;
+  object->priv->covered = -1;
 
   if (object->priv->track)
     return ensure_gnl_object (object);
@@ -97,9 +97,12 @@ struct _GESTrackObject {
  * GESTrackObjectClass:
  * @gnlobject_factorytype: name of the GNonLin GStElementFactory type to use.
  * @create_gnl_object: method to create the GNonLin container object.
- * The default implementation will create an object of type @gnlobject_factorytype
- * and call @create_element.
+ * The default implementation will create an object of type @gnlobject_factorytype.
  * @create_element: method to return the GstElement to put in the gnlobject.
+ * It is called once the object needs its contents, and may be called again
+ * after they were released, for example by a #GESTrack with a
+ * #GESTrack:lookahead window. Implementations must then drop whatever they
+ * kept from the previous call.
  * @start_changed: start property of gnlobject has changed
  * @media_start_changed: media-start property of gnlobject has changed
  * @duration_changed: duration property glnobject has changed
@@ -59,6 +59,9 @@ static void ges_track_text_overlay_set_property (GObject * object, guint
 
 static GstElement *ges_track_text_overlay_create_element (GESTrackObject
     * self);
+static gchar *ges_track_text_overlay_recycle_key (GESTrackObject * self);
+static void ges_track_text_overlay_reuse (GESTrackObject * self,
+    GstElement * element);
 
 static void
 ges_track_text_overlay_class_init (GESTrackTextOverlayClass * klass)
@@ -74,6 +77,8 @@ ges_track_text_overlay_class_init (GESTrackTextOverlayClass * klass)
   object_class->finalize = ges_track_text_overlay_finalize;
 
   bg_class->create_element = ges_track_text_overlay_create_element;
+  ges_track_object_class_set_recycle_funcs (bg_class,
+      ges_track_text_overlay_recycle_key, ges_track_text_overlay_reuse);
 }
 
 static void
@@ -143,9 +148,12 @@ ges_track_text_overlay_create_element (GESTrackObject * object)
   GstPad *src, *sink;
   GESTrackTextOverlay *self = GES_TRACK_TEXT_OVERLAY (object);
 
-  text = gst_element_factory_make ("textoverlay", NULL);
+  text = gst_element_factory_make ("textoverlay", "overlay-text");
   iconv = gst_element_factory_make ("ffmpegcolorspace", NULL);
   oconv = gst_element_factory_make ("ffmpegcolorspace", NULL);
+
+  if (self->priv->text_el)
+    g_object_unref (self->priv->text_el);
   self->priv->text_el = text;
   g_object_ref (text);
 
@@ -175,6 +183,61 @@ ges_track_text_overlay_create_element (GESTrackObject * object)
   return ret;
 }
 
+/* INTERNAL USAGE
+ *
+ * textoverlay doesn't handle a NULL font-desc, so only bins created with
+ * the same one are reused, the other settings are applied on reuse by
+ * ges_text_overlay_reuse().
+ *
+ * Returns: the recycling key of a bin whose textoverlay uses @font_desc */
+gchar *
+ges_text_overlay_recycle_key (const gchar * font_desc)
+{
+  return g_strdup (font_desc ? font_desc : "");
+}
+
+/* INTERNAL USAGE
+ *
+ * Applies the settings which aren't part of the recycling key to the
+ * textoverlay called @name in the recycled @bin.
+ *
+ * Returns: (transfer full): the textoverlay */
+GstElement *
+ges_text_overlay_reuse (GstElement * bin, const gchar * name,
+    const gchar * text, GESTextHAlign halign, GESTextVAlign valign)
+{
+  GstElement *text_el = gst_bin_get_by_name (GST_BIN (bin), name);
+
+  g_object_set (text_el, "text", text ? text : "", "halignment",
+      (gint) halign, "valignment", (gint) valign, NULL);
+
+  return text_el;
+}
+
+static gchar *
+ges_track_text_overlay_recycle_key (GESTrackObject * object)
+{
+  return ges_text_overlay_recycle_key (GES_TRACK_TEXT_OVERLAY (object)->
+      priv->font_desc);
+}
+
+static void
+ges_track_text_overlay_reuse (GESTrackObject * object, GstElement * element)
+{
+  GESTrackTextOverlayPrivate *priv = GES_TRACK_TEXT_OVERLAY (object)->priv;
+
+  if (priv->text_el) {
+    g_object_unref (priv->text_el);
+    priv->text_el = NULL;
+  }
+
+  if (element == NULL)
+    return;
+
+  priv->text_el = ges_text_overlay_reuse (element, "overlay-text", priv->text,
+      priv->halign, priv->valign);
+}
+
 /**
  * ges_track_text_overlay_set_text:
  * @self: the #GESTrackTextOverlay* to set text on
@@ -57,6 +57,9 @@ static void ges_track_title_source_set_property (GObject * object, guint
 
 static GstElement *ges_track_title_source_create_element (GESTrackObject *
     self);
+static gchar *ges_track_title_source_recycle_key (GESTrackObject * self);
+static void ges_track_title_source_reuse (GESTrackObject * self,
+    GstElement * element);
 
 static void
 ges_track_title_source_class_init (GESTrackTitleSourceClass * klass)
@@ -71,6 +74,8 @@ ges_track_title_source_class_init (GESTrackTitleSourceClass * klass)
   object_class->dispose = ges_track_title_source_dispose;
 
   bg_class->create_element = ges_track_title_source_create_element;
+  ges_track_object_class_set_recycle_funcs (bg_class,
+      ges_track_title_source_recycle_key, ges_track_title_source_reuse);
 }
 
 static void
@@ -167,12 +172,49 @@ ges_track_title_source_create_element (GESTrackObject * object)
   g_object_ref (text);
   g_object_ref (background);
 
+  if (priv->text_el)
+    g_object_unref (priv->text_el);
+  if (priv->background_el)
+    g_object_unref (priv->background_el);
+
   priv->text_el = text;
   priv->background_el = background;
 
   return topbin;
 }
 
+/* Recycled like the bins of GESTrackTextOverlay, see
+ * ges_text_overlay_recycle_key() */
+static gchar *
+ges_track_title_source_recycle_key (GESTrackObject * object)
+{
+  return ges_text_overlay_recycle_key (GES_TRACK_TITLE_SOURCE (object)->
+      priv->font_desc);
+}
+
+static void
+ges_track_title_source_reuse (GESTrackObject * object, GstElement * element)
+{
+  GESTrackTitleSourcePrivate *priv = GES_TRACK_TITLE_SOURCE (object)->priv;
+
+  if (priv->text_el) {
+    g_object_unref (priv->text_el);
+    priv->text_el = NULL;
+  }
+  if (priv->background_el) {
+    g_object_unref (priv->background_el);
+    priv->background_el = NULL;
+  }
+
+  if (element == NULL)
+    return;
+
+  priv->text_el = ges_text_overlay_reuse (element, "titlsrc-text", priv->text,
+      priv->halign, priv->valign);
+  priv->background_el = gst_bin_get_by_name (GST_BIN (element),
+      "titlesrc-bg");
+}
+
 /**
  * ges_track_title_source_set_text:
  * @self: the #GESTrackTitleSource* to set text on
@@ -37,6 +37,9 @@ struct _GESTrackVideoTestSourcePrivate
 
 static GstElement *ges_track_video_test_source_create_element (GESTrackObject *
     self);
+static gchar *ges_track_video_test_source_recycle_key (GESTrackObject * self);
+static void ges_track_video_test_source_reuse (GESTrackObject * self,
+    GstElement * element);
 
 static void
 ges_track_video_test_source_class_init (GESTrackVideoTestSourceClass * klass)
@@ -47,6 +50,9 @@ ges_track_video_test_source_class_init (GESTrackVideoTestSourceClass * klass)
 
   track_object_class->create_element =
       ges_track_video_test_source_create_element;
+  ges_track_object_class_set_recycle_funcs (track_object_class,
+      ges_track_video_test_source_recycle_key,
+      ges_track_video_test_source_reuse);
 }
 
 static void
@@ -72,6 +78,21 @@ ges_track_video_test_source_create_element (GESTrackObject * self)
   return ret;
 }
 
+/* Any videotestsrc can be reused, we set our pattern on it */
+static gchar *
+ges_track_video_test_source_recycle_key (GESTrackObject * self)
+{
+  return g_strdup ("");
+}
+
+static void
+ges_track_video_test_source_reuse (GESTrackObject * self, GstElement * element)
+{
+  if (element)
+    g_object_set (element, "pattern",
+        (gint) ((GESTrackVideoTestSource *) self)->priv->pattern, NULL);
+}
+
 /**
  * ges_track_video_test_source_set_pattern:
  * @self: a #GESTrackVideoTestSource
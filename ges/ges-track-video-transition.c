@@ -118,12 +118,10 @@ ges_track_video_transition_init (GESTrackVideoTransition * self)
 }
 
 static void
-ges_track_video_transition_dispose (GObject * object)
+release_elements (GESTrackVideoTransition * self)
 {
-  GESTrackVideoTransition *self = GES_TRACK_VIDEO_TRANSITION (object);
   GESTrackVideoTransitionPrivate *priv = self->priv;
 
-  GST_DEBUG ("disposing");
   GST_LOG ("mixer: %p smpte: %p sinka: %p sinkb: %p",
       priv->mixer, priv->smpte, priv->sinka, priv->sinkb);
 
@@ -151,6 +149,21 @@ ges_track_video_transition_dispose (GObject * object)
     priv->mixer = NULL;
   }
 
+  if (priv->smpte) {
+    gst_object_unref (priv->smpte);
+    priv->smpte = NULL;
+  }
+}
+
+static void
+ges_track_video_transition_dispose (GObject * object)
+{
+  GESTrackVideoTransition *self = GES_TRACK_VIDEO_TRANSITION (object);
+
+  GST_DEBUG ("disposing");
+
+  release_elements (self);
+
   G_OBJECT_CLASS (ges_track_video_transition_parent_class)->dispose (object);
 }
 
@@ -196,6 +209,8 @@ ges_track_video_transition_create_element (GESTrackObject * object)
   self = GES_TRACK_VIDEO_TRANSITION (object);
   priv = self->priv;
 
+  release_elements (self);
+
   GST_LOG ("creating a video bin");
 
   topbin = gst_bin_new ("transition-bin");
@@ -296,7 +311,7 @@ link_element_to_mixer_with_smpte (GstBin * bin, GstElement * element,
 
   /* crack */
   if (smpteref) {
-    *smpteref = smptealpha;
+    *smpteref = gst_object_ref (smptealpha);
   }
 
   srcpad = gst_element_get_static_pad (smptealpha, "src");
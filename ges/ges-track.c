@@ -27,11 +27,41 @@
  * Contains the compatible TrackObject(s).
  *
  * Wraps GNonLin's 'gnlcomposition' element.
+ *
+ * By default every #GESTrackObject gets its contents (decoders, effects,
+ * transition bins, ...) as soon as it is added to the track. When the
+ * #GESTrack:lookahead property is set, only the objects that are at most
+ * that far from the current position of the track have contents, the others
+ * are kept as empty placeholders. See ges_track_move_window().
+ *
+ * Audio and video tracks output silence or black frames in the gaps between
+ * their objects, thanks to a single background source spanning all of them.
+ *
+ * Setting #GESTrack:restriction-caps makes the sources convert their output
+ * right after decoding, so that previewing a timeline in a small window
+ * doesn't process full resolution frames all the way down to the sink.
+ *
+ * Setting #GESTrack:use-proxies makes the file sources decode small proxy
+ * files, created in the background, instead of the original media once they
+ * are ready.
+ *
+ * A track whose output isn't consumed can be deactivated with
+ * #GESTrack:active. Its objects then release their contents, and its
+ * composition is kept in %GST_STATE_NULL, so that nothing gets decoded for
+ * it.
+ *
+ * If #GESTrack:caps contain a compressed format, as set by a
+ * #GESTimelinePipeline in %TIMELINE_MODE_SMART_RENDER, the file sources
+ * which no #GESTrackOperation plays over output that format as is, without
+ * decoding it. The others are still decoded for the operations to work on
+ * raw data.
  */
 
 #include "ges-internal.h"
 #include "ges-track.h"
 #include "ges-track-object.h"
+#include "ges-track-operation.h"
+#include "ges-track-filesource.h"
 
 G_DEFINE_TYPE (GESTrack, ges_track, GST_TYPE_BIN);
 
@@ -42,23 +72,64 @@ struct _GESTrackPrivate
   GList *trackobjects;
 
   GstCaps *caps;
+  GstCaps *restriction_caps;    /* Format the sources are converted to */
+  gboolean passthrough;         /* Whether @caps allow compressed streams */
+  gboolean use_proxies;
+  gboolean active;              /* Whether the track outputs anything */
 
   GstElement *composition;      /* The composition associated with this track */
   GstPad *srcpad;               /* The source GhostPad */
+
+  GstElement *background;       /* Lowest priority gnlsource filling the gaps */
+  GstElement *background_filter;        /* Restricts the background */
+  guint64 duration;             /* End of the last object */
+  GESTrackObject *last_object;  /* The object ending at @duration */
+
+  /* Window of objects having their contents, protected by the object lock
+   * since the position is also looked at from the streaming thread */
+  GstClockTime lookahead;
+  GstClockTime position;
+  GstClockTime pending_position;
+  guint window_idle;
+
+  GESIntervalTree *index;       /* The TrackObjects indexed by the time
+                                 * they play at, to move the window */
 };
 
 enum
 {
   ARG_0,
   ARG_CAPS,
-  ARG_TYPE
+  ARG_TYPE,
+  ARG_LOOKAHEAD,
+  ARG_RESTRICTION_CAPS,
+  ARG_USE_PROXIES,
+  ARG_ACTIVE
 };
 
 static void pad_added_cb (GstElement * element, GstPad * pad, GESTrack * track);
 
+static gboolean
+buffer_probe_cb (GstPad * pad, GstBuffer * buffer, GESTrack * track);
+
+static void update_duration (GESTrack * track, GESTrackObject * object);
+static void update_object_window (GESTrack * track, GESTrackObject * object);
+static void refresh_object (GESTrack * track, GESTrackObject * object);
+static void refresh_contents (GESTrack * track);
+static void refresh_range (GESTrack * track, guint64 start, guint64 end);
+
 static void
 pad_removed_cb (GstElement * element, GstPad * pad, GESTrack * track);
 
+static inline guint64
+object_end (GESTrackObject * object)
+{
+  guint64 start = GES_TRACK_OBJECT_START (object);
+  guint64 duration = GES_TRACK_OBJECT_DURATION (object);
+
+  return duration > G_MAXUINT64 - start ? G_MAXUINT64 : start + duration;
+}
+
 static void
 ges_track_get_property (GObject * object, guint property_id,
     GValue * value, GParamSpec * pspec)
@@ -72,6 +143,18 @@ ges_track_get_property (GObject * object, guint property_id,
     case ARG_TYPE:
       g_value_set_flags (value, track->type);
       break;
+    case ARG_LOOKAHEAD:
+      g_value_set_uint64 (value, track->priv->lookahead);
+      break;
+    case ARG_RESTRICTION_CAPS:
+      gst_value_set_caps (value, track->priv->restriction_caps);
+      break;
+    case ARG_USE_PROXIES:
+      g_value_set_boolean (value, track->priv->use_proxies);
+      break;
+    case ARG_ACTIVE:
+      g_value_set_boolean (value, track->priv->active);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -90,11 +173,77 @@ ges_track_set_property (GObject * object, guint property_id,
     case ARG_TYPE:
       track->type = g_value_get_flags (value);
       break;
+    case ARG_LOOKAHEAD:
+      ges_track_set_lookahead (track, g_value_get_uint64 (value));
+      break;
+    case ARG_RESTRICTION_CAPS:
+      ges_track_set_restriction_caps (track, gst_value_get_caps (value));
+      break;
+    case ARG_USE_PROXIES:
+      ges_track_set_use_proxies (track, g_value_get_boolean (value));
+      break;
+    case ARG_ACTIVE:
+      ges_track_set_active (track, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
 }
 
+static void
+ges_track_constructed (GObject * object)
+{
+  GESTrack *track = (GESTrack *) object;
+  GESTrackPrivate *priv = track->priv;
+  GstElement *src = NULL;
+
+  switch (track->type) {
+    case GES_TRACK_TYPE_VIDEO:
+      if ((src = gst_element_factory_make ("videotestsrc", NULL)))
+        g_object_set (src, "pattern", (gint) GES_VIDEO_TEST_PATTERN_BLACK,
+            NULL);
+      break;
+    case GES_TRACK_TYPE_AUDIO:
+      /* 4 is the 'silence' wave */
+      if ((src = gst_element_factory_make ("audiotestsrc", NULL)))
+        g_object_set (src, "wave", 4, NULL);
+      break;
+    default:
+      break;
+  }
+
+  if (src) {
+    GstElement *bin = gst_bin_new (NULL);
+    GstPad *target;
+
+    /* The background is generated directly in the restricted format */
+    priv->background_filter = gst_element_factory_make ("capsfilter", NULL);
+    gst_bin_add_many (GST_BIN (bin), src, priv->background_filter, NULL);
+    gst_element_link (src, priv->background_filter);
+    target = gst_element_get_static_pad (priv->background_filter, "src");
+    gst_element_add_pad (bin, gst_ghost_pad_new ("src", target));
+    gst_object_unref (target);
+
+    priv->background = gst_element_factory_make ("gnlsource", "background");
+    gst_bin_add (GST_BIN (priv->background), bin);
+
+    /* Lowest possible priority, so that it only shows up in the gaps */
+    g_object_set (priv->background, "caps", priv->caps,
+        "priority", (guint) G_MAXUINT32, "start", (guint64) 0,
+        "duration", (guint64) 0, "media-start", (guint64) 0,
+        "media-duration", (guint64) 0, NULL);
+
+    if (!gst_bin_add (GST_BIN (priv->composition), priv->background)) {
+      GST_ERROR ("Couldn't add the background to the composition");
+      priv->background = NULL;
+      priv->background_filter = NULL;
+    }
+  }
+
+  if (G_OBJECT_CLASS (ges_track_parent_class)->constructed)
+    G_OBJECT_CLASS (ges_track_parent_class)->constructed (object);
+}
+
 static void
 ges_track_dispose (GObject * object)
 {
@@ -118,12 +267,26 @@ ges_track_dispose (GObject * object)
     priv->caps = NULL;
   }
 
+  if (priv->restriction_caps) {
+    gst_caps_unref (priv->restriction_caps);
+    priv->restriction_caps = NULL;
+  }
+
+  if (priv->use_proxies) {
+    ges_proxy_cache_unwatch (track);
+    priv->use_proxies = FALSE;
+  }
+
   G_OBJECT_CLASS (ges_track_parent_class)->dispose (object);
 }
 
 static void
 ges_track_finalize (GObject * object)
 {
+  GESTrack *track = (GESTrack *) object;
+
+  ges_interval_tree_free (track->priv->index);
+
   G_OBJECT_CLASS (ges_track_parent_class)->finalize (object);
 }
 
@@ -136,6 +299,7 @@ ges_track_class_init (GESTrackClass * klass)
 
   object_class->get_property = ges_track_get_property;
   object_class->set_property = ges_track_set_property;
+  object_class->constructed = ges_track_constructed;
   object_class->dispose = ges_track_dispose;
   object_class->finalize = ges_track_finalize;
 
@@ -167,6 +331,66 @@ ges_track_class_init (GESTrackClass * klass)
           "Type of stream the track outputs",
           GES_TYPE_TRACK_TYPE, GES_TRACK_TYPE_CUSTOM,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+
+  /**
+   * GESTrack:lookahead
+   *
+   * How far (in nanoseconds) before and after the current position of the
+   * track a #GESTrackObject has to be for its contents to be created. The
+   * contents of the objects leaving that window are released.
+   *
+   * Default value: 0, which means all the objects always have their contents.
+   */
+  g_object_class_install_property (object_class, ARG_LOOKAHEAD,
+      g_param_spec_uint64 ("lookahead", "Lookahead",
+          "Window around the position in which objects have their contents",
+          0, G_MAXUINT64, 0, G_PARAM_READWRITE));
+
+  /**
+   * GESTrack:restriction-caps
+   *
+   * Format the sources of the track are converted to right after being
+   * decoded, for example 'video/x-raw-yuv,width=640,height=360' to preview
+   * a timeline in a small window. The name of the caps is not taken into
+   * account, only their fields are. Setting it to %NULL lets the sources
+   * output their native format.
+   *
+   * Default value: %NULL.
+   */
+  g_object_class_install_property (object_class, ARG_RESTRICTION_CAPS,
+      g_param_spec_boxed ("restriction-caps", "Restriction caps",
+          "Format the sources are converted to after decoding",
+          GST_TYPE_CAPS, G_PARAM_READWRITE));
+
+  /**
+   * GESTrack:use-proxies
+   *
+   * Whether file sources decode low resolution proxies of their media
+   * instead of the original files. Proxies are created in the background
+   * the first time a source needs them, and the sources switch to them once
+   * they are ready. They are stored in the user cache directory, see
+   * ges_proxy_cache_set_directory().
+   *
+   * Default value: %FALSE.
+   */
+  g_object_class_install_property (object_class, ARG_USE_PROXIES,
+      g_param_spec_boolean ("use-proxies", "Use proxies",
+          "Whether file sources decode proxies of their media", FALSE,
+          G_PARAM_READWRITE));
+
+  /**
+   * GESTrack:active
+   *
+   * Whether the track outputs anything. The objects of an inactive track
+   * don't have any contents, and the track stays in %GST_STATE_NULL
+   * whatever the state of its parent, so that it doesn't expose any pad.
+   * A #GESTimelinePipeline deactivates the tracks its mode doesn't use.
+   *
+   * Default value: %TRUE.
+   */
+  g_object_class_install_property (object_class, ARG_ACTIVE,
+      g_param_spec_boolean ("active", "Active",
+          "Whether the track outputs anything", TRUE, G_PARAM_READWRITE));
 }
 
 static void
@@ -175,6 +399,9 @@ ges_track_init (GESTrack * self)
   self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
       GES_TYPE_TRACK, GESTrackPrivate);
 
+  self->priv->active = TRUE;
+  self->priv->index = ges_interval_tree_new ();
+
   self->priv->composition = gst_element_factory_make ("gnlcomposition", NULL);
 
   g_signal_connect (self->priv->composition, "pad-added",
@@ -262,6 +489,15 @@ ges_track_set_timeline (GESTrack * track, GESTimeline * timeline)
   track->priv->timeline = timeline;
 }
 
+static inline gboolean
+is_raw (const GstStructure * structure)
+{
+  const gchar *name = gst_structure_get_name (structure);
+
+  return g_str_has_prefix (name, "video/x-raw") ||
+      g_str_has_prefix (name, "audio/x-raw");
+}
+
 /**
  * ges_track_set_caps:
  * @track: a #GESTrack
@@ -273,6 +509,7 @@ void
 ges_track_set_caps (GESTrack * track, const GstCaps * caps)
 {
   GESTrackPrivate *priv;
+  guint i;
 
   g_return_if_fail (GES_IS_TRACK (track));
   g_return_if_fail (GST_IS_CAPS (caps));
@@ -285,8 +522,294 @@ ges_track_set_caps (GESTrack * track, const GstCaps * caps)
     gst_caps_unref (priv->caps);
   priv->caps = gst_caps_copy (caps);
 
+  priv->passthrough = FALSE;
+  for (i = 0; i < gst_caps_get_size (caps); i++)
+    if (!is_raw (gst_caps_get_structure (caps, i)))
+      priv->passthrough = TRUE;
+
   g_object_set (priv->composition, "caps", caps, NULL);
-  /* FIXME : update all trackobjects ? */
+  if (priv->background)
+    g_object_set (priv->background, "caps", caps, NULL);
+
+  /* Sources created for the previous caps */
+  refresh_contents (track);
+}
+
+/* The caps of @track with the fields of the restriction caps applied to each
+ * of their structures */
+static GstCaps *
+make_restriction_caps (GESTrackPrivate * priv)
+{
+  GstCaps *caps;
+  const GstStructure *restriction;
+  guint i, j, n;
+
+  if (priv->restriction_caps == NULL ||
+      gst_caps_is_empty (priv->restriction_caps) ||
+      gst_caps_is_any (priv->restriction_caps))
+    return gst_caps_new_any ();
+
+  restriction = gst_caps_get_structure (priv->restriction_caps, 0);
+  n = gst_structure_n_fields (restriction);
+
+  caps = gst_caps_copy (priv->caps);
+  for (i = 0; i < gst_caps_get_size (caps); i++) {
+    GstStructure *structure = gst_caps_get_structure (caps, i);
+
+    for (j = 0; j < n; j++) {
+      const gchar *field = gst_structure_nth_field_name (restriction, j);
+
+      gst_structure_set_value (structure, field,
+          gst_structure_get_value (restriction, field));
+    }
+  }
+
+  return caps;
+}
+
+/**
+ * ges_track_set_restriction_caps:
+ * @track: a #GESTrack
+ * @caps: (allow-none): the #GstCaps to restrict the sources to, or %NULL
+ *
+ * Sets the #GESTrack:restriction-caps of @track. The contents of the objects
+ * of @track are recreated to take them into account.
+ */
+void
+ges_track_set_restriction_caps (GESTrack * track, const GstCaps * caps)
+{
+  GESTrackPrivate *priv;
+  GstCaps *filter;
+  GList *tmp;
+
+  g_return_if_fail (GES_IS_TRACK (track));
+
+  GST_DEBUG ("track:%p, caps:%" GST_PTR_FORMAT, track, caps);
+
+  priv = track->priv;
+
+  if (caps == priv->restriction_caps || (caps && priv->restriction_caps &&
+          gst_caps_is_equal (caps, priv->restriction_caps)))
+    return;
+
+  /* Release before changing the caps, so the elements get recycled under
+   * the configuration they were created for */
+  for (tmp = priv->trackobjects; tmp; tmp = tmp->next)
+    ges_track_object_release_contents ((GESTrackObject *) tmp->data);
+
+  if (priv->restriction_caps)
+    gst_caps_unref (priv->restriction_caps);
+  priv->restriction_caps = caps ? gst_caps_copy (caps) : NULL;
+
+  if (priv->background_filter) {
+    filter = make_restriction_caps (priv);
+    g_object_set (priv->background_filter, "caps", filter, NULL);
+    gst_caps_unref (filter);
+  }
+
+  for (tmp = priv->trackobjects; tmp; tmp = tmp->next)
+    update_object_window (track, (GESTrackObject *) tmp->data);
+
+  g_object_notify ((GObject *) track, "restriction-caps");
+}
+
+/**
+ * ges_track_get_restriction_caps:
+ * @track: a #GESTrack
+ *
+ * Get the #GESTrack:restriction-caps of @track.
+ *
+ * Returns: (transfer none): the #GstCaps the sources of @track are
+ * converted to, or %NULL if they output their native format.
+ */
+const GstCaps *
+ges_track_get_restriction_caps (GESTrack * track)
+{
+  g_return_val_if_fail (GES_IS_TRACK (track), NULL);
+
+  return track->priv->restriction_caps;
+}
+
+/**
+ * ges_track_set_use_proxies:
+ * @track: a #GESTrack
+ * @use_proxies: whether file sources should decode proxies of their media
+ *
+ * Sets the #GESTrack:use-proxies property of @track. The contents of the
+ * file sources of @track are recreated to take it into account.
+ */
+void
+ges_track_set_use_proxies (GESTrack * track, gboolean use_proxies)
+{
+  GESTrackPrivate *priv;
+
+  g_return_if_fail (GES_IS_TRACK (track));
+
+  GST_DEBUG ("track:%p, use_proxies:%d", track, use_proxies);
+
+  priv = track->priv;
+
+  if (priv->use_proxies == use_proxies)
+    return;
+
+  priv->use_proxies = use_proxies;
+  if (use_proxies) {
+    GList *tmp;
+
+    ges_proxy_cache_watch (track);
+
+    /* Sources which already have their contents won't ask for their proxy,
+     * their contents only get recreated once it is ready */
+    for (tmp = priv->trackobjects; tmp; tmp = tmp->next)
+      if (GES_IS_TRACK_FILESOURCE (tmp->data))
+        g_free (ges_proxy_cache_request (((GESTrackFileSource *)
+                    tmp->data)->uri));
+  } else
+    ges_proxy_cache_unwatch (track);
+
+  refresh_contents (track);
+
+  g_object_notify ((GObject *) track, "use-proxies");
+}
+
+/**
+ * ges_track_get_use_proxies:
+ * @track: a #GESTrack
+ *
+ * Get the #GESTrack:use-proxies property of @track.
+ *
+ * Returns: %TRUE if the file sources of @track decode proxies of their
+ * media, else %FALSE.
+ */
+gboolean
+ges_track_get_use_proxies (GESTrack * track)
+{
+  g_return_val_if_fail (GES_IS_TRACK (track), FALSE);
+
+  return track->priv->use_proxies;
+}
+
+/**
+ * ges_track_set_active:
+ * @track: a #GESTrack
+ * @active: whether @track should output anything
+ *
+ * Sets the #GESTrack:active property of @track. Deactivating @track
+ * releases the contents of all its objects and shuts its composition down,
+ * activating it recreates them and brings it back to the state of its
+ * parent.
+ */
+void
+ges_track_set_active (GESTrack * track, gboolean active)
+{
+  GESTrackPrivate *priv;
+  GList *tmp;
+
+  g_return_if_fail (GES_IS_TRACK (track));
+
+  GST_DEBUG ("track:%p, active:%d", track, active);
+
+  priv = track->priv;
+
+  if (priv->active == active)
+    return;
+
+  GST_OBJECT_LOCK (track);
+  priv->active = active;
+  GST_OBJECT_UNLOCK (track);
+
+  if (!active) {
+    /* Removes the pads, and thus the output chains of the pipeline, before
+     * the contents go away */
+    gst_element_set_locked_state ((GstElement *) track, TRUE);
+    gst_element_set_state ((GstElement *) track, GST_STATE_NULL);
+  }
+
+  for (tmp = priv->trackobjects; tmp; tmp = tmp->next)
+    update_object_window (track, (GESTrackObject *) tmp->data);
+
+  if (active) {
+    gst_element_set_locked_state ((GstElement *) track, FALSE);
+    gst_element_sync_state_with_parent ((GstElement *) track);
+  }
+
+  g_object_notify ((GObject *) track, "active");
+}
+
+/**
+ * ges_track_get_active:
+ * @track: a #GESTrack
+ *
+ * Get the #GESTrack:active property of @track.
+ *
+ * Returns: %TRUE if @track outputs anything, else %FALSE.
+ */
+gboolean
+ges_track_get_active (GESTrack * track)
+{
+  g_return_val_if_fail (GES_IS_TRACK (track), FALSE);
+
+  return track->priv->active;
+}
+
+/* INTERNAL USAGE
+ *
+ * Called when the proxy of @uri got ready, for the sources of @track to
+ * switch to it */
+void
+ges_track_proxy_ready (GESTrack * track, const gchar * uri)
+{
+  GST_DEBUG ("track:%p, uri:%s", track, uri);
+
+  if (track->priv->use_proxies)
+    refresh_contents (track);
+}
+
+/* INTERNAL USAGE
+ *
+ * Returns: (transfer floating): a bin converting raw streams to the
+ * restriction caps of @track, to be plugged right after a decoder, or %NULL
+ * if @track has no restriction caps */
+GstElement *
+ges_track_create_restriction_filter (GESTrack * track)
+{
+  GstElement *bin, *scale, *rate, *filter;
+  GstCaps *caps;
+  GstPad *pad;
+
+  if (track->priv->restriction_caps == NULL)
+    return NULL;
+
+  switch (track->type) {
+    case GES_TRACK_TYPE_VIDEO:
+      scale = gst_element_factory_make ("videoscale", NULL);
+      rate = gst_element_factory_make ("videorate", NULL);
+      break;
+    case GES_TRACK_TYPE_AUDIO:
+      scale = gst_element_factory_make ("audioconvert", NULL);
+      rate = gst_element_factory_make ("audioresample", NULL);
+      break;
+    default:
+      return NULL;
+  }
+
+  bin = gst_bin_new ("restriction-bin");
+  filter = gst_element_factory_make ("capsfilter", NULL);
+  gst_bin_add_many (GST_BIN (bin), scale, rate, filter, NULL);
+  gst_element_link_many (scale, rate, filter, NULL);
+
+  caps = make_restriction_caps (track->priv);
+  g_object_set (filter, "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  pad = gst_element_get_static_pad (scale, "sink");
+  gst_element_add_pad (bin, gst_ghost_pad_new ("sink", pad));
+  gst_object_unref (pad);
+  pad = gst_element_get_static_pad (filter, "src");
+  gst_element_add_pad (bin, gst_ghost_pad_new ("src", pad));
+  gst_object_unref (pad);
+
+  return bin;
 }
 
 /**
@@ -338,7 +861,16 @@ ges_track_add_object (GESTrack * track, GESTrackObject * object)
 
   g_object_ref_sink (object);
 
-  track->priv->trackobjects = g_list_append (track->priv->trackobjects, object);
+  track->priv->trackobjects =
+      g_list_prepend (track->priv->trackobjects, object);
+  ges_interval_tree_insert (track->priv->index, object,
+      GES_TRACK_OBJECT_START (object), GES_TRACK_OBJECT_DURATION (object));
+
+  update_duration (track, object);
+
+  if (track->priv->passthrough && GES_IS_TRACK_OPERATION (object))
+    refresh_range (track, GES_TRACK_OBJECT_START (object),
+        object_end (object));
 
   return TRUE;
 }
@@ -375,6 +907,9 @@ ges_track_remove_object (GESTrack * track, GESTrackObject * object)
   }
 
   if ((gnlobject = ges_track_object_get_gnlobject (object))) {
+    /* Give the contents a chance to be recycled by another object */
+    ges_track_object_release_contents (object);
+
     GST_DEBUG ("Removing GnlObject from composition");
     if (!gst_bin_remove (GST_BIN (priv->composition), gnlobject)) {
       GST_WARNING ("Failed to remove gnlobject from composition");
@@ -384,6 +919,14 @@ ges_track_remove_object (GESTrack * track, GESTrackObject * object)
 
   ges_track_object_set_track (object, NULL);
   priv->trackobjects = g_list_remove (priv->trackobjects, object);
+  ges_interval_tree_remove (priv->index, object);
+
+  if (object == priv->last_object)
+    update_duration (track, NULL);
+
+  if (priv->passthrough && GES_IS_TRACK_OPERATION (object))
+    refresh_range (track, GES_TRACK_OBJECT_START (object),
+        object_end (object));
 
   g_object_unref (object);
 
@@ -404,6 +947,9 @@ pad_added_cb (GstElement * element, GstPad * pad, GESTrack * track)
 
   gst_element_add_pad (GST_ELEMENT (track), priv->srcpad);
 
+  /* Follow the position to move the window of objects having contents */
+  gst_pad_add_buffer_probe (pad, G_CALLBACK (buffer_probe_cb), track);
+
   GST_DEBUG ("done");
 }
 
@@ -423,6 +969,52 @@ pad_removed_cb (GstElement * element, GstPad * pad, GESTrack * track)
   GST_DEBUG ("done");
 }
 
+/**
+ * ges_track_enable_update:
+ * @track: a #GESTrack
+ * @enabled: Whether the track should update its composition on every change
+ *
+ * Sets whether the underlying composition of @track should be updated each
+ * time one of its #GESTrackObject is added, removed or modified. When
+ * doing several modifications at once, disabling updates beforehand and
+ * enabling them afterwards ensures the composition is only updated once, when
+ * updates get enabled again.
+ *
+ * Returns: TRUE if the setting could be applied, else FALSE.
+ */
+gboolean
+ges_track_enable_update (GESTrack * track, gboolean enabled)
+{
+  g_return_val_if_fail (GES_IS_TRACK (track), FALSE);
+
+  GST_DEBUG ("track:%p, enabled:%d", track, enabled);
+
+  g_object_set (track->priv->composition, "update", enabled, NULL);
+
+  return TRUE;
+}
+
+/**
+ * ges_track_is_updating:
+ * @track: a #GESTrack
+ *
+ * Get whether the underlying composition of @track is updated on every
+ * change. See ges_track_enable_update().
+ *
+ * Returns: TRUE if the composition is updated on every change, else FALSE.
+ */
+gboolean
+ges_track_is_updating (GESTrack * track)
+{
+  gboolean update;
+
+  g_return_val_if_fail (GES_IS_TRACK (track), FALSE);
+
+  g_object_get (track->priv->composition, "update", &update, NULL);
+
+  return update;
+}
+
 /**
  * ges_track_get_caps:
  * @track: a #GESTrack
@@ -454,3 +1046,391 @@ ges_track_get_timeline (GESTrack * track)
 
   return track->priv->timeline;
 }
+
+/* The window spans @lookahead before and after @position */
+static inline void
+window_bounds (GstClockTime position, GstClockTime lookahead,
+    guint64 * wstart, guint64 * wend)
+{
+  *wstart = position > lookahead ? position - lookahead : 0;
+  *wend = lookahead > G_MAXUINT64 - position ?
+      G_MAXUINT64 : position + lookahead;
+}
+
+static inline gboolean
+in_window (GESTrackPrivate * priv, GESTrackObject * object)
+{
+  guint64 wstart, wend;
+
+  if (!priv->active)
+    return FALSE;
+
+  if (priv->lookahead == 0)
+    return TRUE;
+
+  window_bounds (priv->position, priv->lookahead, &wstart, &wend);
+
+  return GES_TRACK_OBJECT_START (object) <= wend &&
+      object_end (object) >= wstart;
+}
+
+/* Returns the objects of @priv which are in the window around @position.
+ * The index only returns the objects ending strictly after the start of
+ * the range, so it is queried from just before the window. */
+static GList *
+query_window (GESTrackPrivate * priv, GstClockTime position,
+    GstClockTime lookahead)
+{
+  guint64 wstart, wend;
+
+  window_bounds (position, lookahead, &wstart, &wend);
+
+  return ges_interval_tree_query (priv->index, wstart ? wstart - 1 : 0, wend);
+}
+
+/* INTERNAL USAGE
+ *
+ * Returns: TRUE if @object should have its contents in @track */
+gboolean
+ges_track_is_in_window (GESTrack * track, GESTrackObject * object)
+{
+  gboolean ret;
+
+  GST_OBJECT_LOCK (track);
+  ret = in_window (track->priv, object);
+  GST_OBJECT_UNLOCK (track);
+
+  return ret;
+}
+
+/* Creates or releases the contents of @object depending on whether it is
+ * in the window of @track */
+static void
+update_object_window (GESTrack * track, GESTrackObject * object)
+{
+  if (ges_track_is_in_window (track, object))
+    ges_track_object_materialize (object);
+  else
+    ges_track_object_release_contents (object);
+}
+
+/* Makes the background span up to the end of the last object. @object is
+ * the object that just moved, or %NULL if the last one was removed. */
+static void
+update_duration (GESTrack * track, GESTrackObject * object)
+{
+  GESTrackPrivate *priv = track->priv;
+  guint64 duration;
+  GList *tmp;
+
+  if (object && object_end (object) >= priv->duration) {
+    duration = object_end (object);
+    priv->last_object = object;
+  } else if (object == NULL || object == priv->last_object) {
+    /* The end of the track moved back, look for the new last object */
+    duration = 0;
+    priv->last_object = NULL;
+    for (tmp = priv->trackobjects; tmp; tmp = tmp->next) {
+      GESTrackObject *trobj = (GESTrackObject *) tmp->data;
+
+      if (priv->last_object == NULL || object_end (trobj) > duration) {
+        duration = object_end (trobj);
+        priv->last_object = trobj;
+      }
+    }
+  } else
+    return;
+
+  if (duration == priv->duration)
+    return;
+
+  GST_DEBUG ("track:%p, duration:%" GST_TIME_FORMAT, track,
+      GST_TIME_ARGS (duration));
+
+  priv->duration = duration;
+  if (priv->background)
+    g_object_set (priv->background, "duration", duration,
+        "media-duration", duration, NULL);
+}
+
+/* INTERNAL USAGE
+ *
+ * Called when @object moved or got resized within @track. */
+void
+ges_track_object_moved (GESTrack * track, GESTrackObject * object)
+{
+  GESTrackPrivate *priv = track->priv;
+  guint64 start, end;
+  gboolean indexed;
+
+  /* Where @object played until now, for the sources it left */
+  indexed = ges_interval_tree_lookup (priv->index, object, &start, &end);
+  ges_interval_tree_update (priv->index, object,
+      GES_TRACK_OBJECT_START (object), GES_TRACK_OBJECT_DURATION (object));
+
+  update_object_window (track, object);
+  update_duration (track, object);
+
+  if (!priv->passthrough)
+    return;
+
+  if (GES_IS_TRACK_OPERATION (object)) {
+    if (indexed)
+      refresh_range (track, start, end);
+    refresh_range (track, GES_TRACK_OBJECT_START (object),
+        object_end (object));
+  } else {
+    ges_track_object_set_covered (object, -1);
+    refresh_object (track, object);
+  }
+}
+
+/* Recreates the contents of @object if they were created for another
+ * configuration */
+static void
+refresh_object (GESTrack * track, GESTrackObject * object)
+{
+  if (ges_track_object_contents_outdated (object)) {
+    GST_DEBUG ("Refreshing %p", object);
+    ges_track_object_release_contents (object);
+    update_object_window (track, object);
+  }
+}
+
+/* Recreates the contents of all the objects that were created for another
+ * configuration, for example for other track caps */
+static void
+refresh_contents (GESTrack * track)
+{
+  GList *tmp;
+
+  for (tmp = track->priv->trackobjects; tmp; tmp = tmp->next) {
+    GESTrackObject *object = (GESTrackObject *) tmp->data;
+
+    ges_track_object_set_covered (object, -1);
+    refresh_object (track, object);
+  }
+}
+
+/* Recreates the contents of the sources playing between @start and @end
+ * (excluded), which an operation started or stopped playing over */
+static void
+refresh_range (GESTrack * track, guint64 start, guint64 end)
+{
+  GList *objects, *tmp;
+
+  objects = ges_interval_tree_query (track->priv->index, start, end);
+  for (tmp = objects; tmp; tmp = tmp->next) {
+    GESTrackObject *object = (GESTrackObject *) tmp->data;
+
+    if (GES_IS_TRACK_OPERATION (object) ||
+        GES_TRACK_OBJECT_START (object) >= end)
+      continue;
+
+    ges_track_object_set_covered (object, -1);
+    refresh_object (track, object);
+  }
+  g_list_free (objects);
+}
+
+/* TRUE if an operation of @priv plays at some point over @object. The
+ * result is cached on @object until the track invalidates it. */
+static gboolean
+is_covered (GESTrackPrivate * priv, GESTrackObject * object)
+{
+  guint64 start = GES_TRACK_OBJECT_START (object);
+  guint64 end = object_end (object);
+  gint covered = ges_track_object_get_covered (object);
+  GList *objects, *tmp;
+
+  if (covered != -1)
+    return covered;
+
+  covered = FALSE;
+  objects = ges_interval_tree_query (priv->index, start, end);
+  for (tmp = objects; tmp; tmp = tmp->next) {
+    GESTrackObject *other = (GESTrackObject *) tmp->data;
+
+    if (other != object && GES_IS_TRACK_OPERATION (other) &&
+        GES_TRACK_OBJECT_START (other) < end) {
+      covered = TRUE;
+      break;
+    }
+  }
+  g_list_free (objects);
+
+  ges_track_object_set_covered (object, covered);
+
+  return covered;
+}
+
+/* INTERNAL USAGE
+ *
+ * Returns: (transfer full): the caps at which the decoder of @object should
+ * stop. They only allow the compressed formats of the track caps if no
+ * operation plays over @object, since operations only handle raw data.
+ *
+ * This is decided for the whole of @object: a source which an operation
+ * plays over, even briefly, gets entirely decoded and encoded again rather
+ * than only around the operation. */
+GstCaps *
+ges_track_get_decoding_caps (GESTrack * track, GESTrackObject * object)
+{
+  GESTrackPrivate *priv = track->priv;
+  GstCaps *caps;
+  guint i;
+
+  if (!priv->passthrough || !is_covered (priv, object))
+    return gst_caps_copy (priv->caps);
+
+  caps = gst_caps_new_empty ();
+  for (i = 0; i < gst_caps_get_size (priv->caps); i++) {
+    const GstStructure *structure = gst_caps_get_structure (priv->caps, i);
+
+    if (is_raw (structure))
+      gst_caps_append_structure (caps, gst_structure_copy (structure));
+  }
+
+  return caps;
+}
+
+static gboolean
+move_window_idle (GESTrack * track)
+{
+  GstClockTime position;
+
+  GST_OBJECT_LOCK (track);
+  position = track->priv->pending_position;
+  track->priv->window_idle = 0;
+  GST_OBJECT_UNLOCK (track);
+
+  ges_track_move_window (track, position);
+
+  return FALSE;
+}
+
+static gboolean
+buffer_probe_cb (GstPad * pad, GstBuffer * buffer, GESTrack * track)
+{
+  GESTrackPrivate *priv = track->priv;
+  GstClockTime ts = GST_BUFFER_TIMESTAMP (buffer);
+
+  if (!GST_CLOCK_TIME_IS_VALID (ts))
+    return TRUE;
+
+  GST_OBJECT_LOCK (track);
+  if (priv->lookahead == 0) {
+    GST_OBJECT_UNLOCK (track);
+    return TRUE;
+  }
+
+  /* Objects can't be created from the streaming thread, so the window is
+   * moved from the main context once half of the lookahead was played */
+  if (priv->window_idle) {
+    priv->pending_position = ts;
+  } else if (ts < priv->position || ts - priv->position > priv->lookahead / 2) {
+    priv->pending_position = ts;
+    priv->window_idle = g_idle_add_full (G_PRIORITY_DEFAULT,
+        (GSourceFunc) move_window_idle, gst_object_ref (track),
+        (GDestroyNotify) gst_object_unref);
+  }
+  GST_OBJECT_UNLOCK (track);
+
+  return TRUE;
+}
+
+/**
+ * ges_track_set_lookahead:
+ * @track: a #GESTrack
+ * @lookahead: the size of the window (in nanoseconds) before and after the
+ * current position, or 0 to disable it
+ *
+ * Sets the #GESTrack:lookahead of @track. Only the #GESTrackObject which are
+ * at most @lookahead away from the current position of @track will then have
+ * their contents, the others being kept as lightweight placeholders.
+ *
+ * The window follows the playback position of @track and gets moved on
+ * seeks done through a #GESTimelinePipeline, it can also be moved explicitly
+ * with ges_track_move_window(). @lookahead should therefore be big enough
+ * for the contents of upcoming objects to be ready before they are played.
+ */
+void
+ges_track_set_lookahead (GESTrack * track, GstClockTime lookahead)
+{
+  GList *tmp;
+
+  g_return_if_fail (GES_IS_TRACK (track));
+
+  GST_DEBUG ("track:%p, lookahead:%" GST_TIME_FORMAT, track,
+      GST_TIME_ARGS (lookahead));
+
+  GST_OBJECT_LOCK (track);
+  track->priv->lookahead = lookahead;
+  GST_OBJECT_UNLOCK (track);
+
+  /* Any object can enter or leave a window of a different size */
+  for (tmp = track->priv->trackobjects; tmp; tmp = tmp->next)
+    update_object_window (track, (GESTrackObject *) tmp->data);
+}
+
+/**
+ * ges_track_get_lookahead:
+ * @track: a #GESTrack
+ *
+ * Get the #GESTrack:lookahead of @track.
+ *
+ * Returns: the size of the window (in nanoseconds) around the current
+ * position in which objects have their contents, 0 if they always have them.
+ */
+GstClockTime
+ges_track_get_lookahead (GESTrack * track)
+{
+  g_return_val_if_fail (GES_IS_TRACK (track), 0);
+
+  return track->priv->lookahead;
+}
+
+/**
+ * ges_track_move_window:
+ * @track: a #GESTrack
+ * @position: the new position (in nanoseconds)
+ *
+ * Moves the window of objects having their contents around @position,
+ * creating the contents of the objects entering it and releasing those
+ * of the objects leaving it. Doesn't do anything but remembering @position
+ * if #GESTrack:lookahead is 0.
+ */
+void
+ges_track_move_window (GESTrack * track, GstClockTime position)
+{
+  GESTrackPrivate *priv;
+  GstClockTime previous, lookahead;
+  GList *objects, *tmp;
+
+  g_return_if_fail (GES_IS_TRACK (track));
+
+  GST_DEBUG ("track:%p, position:%" GST_TIME_FORMAT, track,
+      GST_TIME_ARGS (position));
+
+  priv = track->priv;
+
+  GST_OBJECT_LOCK (track);
+  previous = priv->position;
+  priv->position = position;
+  lookahead = priv->lookahead;
+  GST_OBJECT_UNLOCK (track);
+
+  /* Inactive tracks don't have any contents to update */
+  if (lookahead == 0 || !priv->active)
+    return;
+
+  /* Only the objects of the previous and of the new window can have to
+   * release or to create their contents */
+  objects = g_list_concat (query_window (priv, previous, lookahead),
+      query_window (priv, position, lookahead));
+
+  for (tmp = objects; tmp; tmp = tmp->next)
+    update_object_window (track, (GESTrackObject *) tmp->data);
+
+  g_list_free (objects);
+}
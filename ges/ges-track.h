@@ -88,6 +88,15 @@ void		ges_track_set_timeline (GESTrack * track,
 void		ges_track_set_caps     (GESTrack * track,
 					const GstCaps * caps);
 const GstCaps * ges_track_get_caps     (GESTrack *track);
+void		ges_track_set_restriction_caps (GESTrack * track,
+						const GstCaps * caps);
+const GstCaps * ges_track_get_restriction_caps (GESTrack * track);
+void		ges_track_set_use_proxies (GESTrack * track,
+					   gboolean use_proxies);
+gboolean	ges_track_get_use_proxies (GESTrack * track);
+void		ges_track_set_active (GESTrack * track,
+				      gboolean active);
+gboolean	ges_track_get_active (GESTrack * track);
 const GESTimeline *ges_track_get_timeline (GESTrack *track);
 
 gboolean ges_track_add_object    (GESTrack * track,
@@ -95,6 +104,16 @@ gboolean ges_track_add_object    (GESTrack * track,
 gboolean ges_track_remove_object (GESTrack * track,
 				  GESTrackObject * object);
 
+gboolean ges_track_enable_update (GESTrack * track,
+				  gboolean enabled);
+gboolean ges_track_is_updating   (GESTrack * track);
+
+void         ges_track_set_lookahead (GESTrack * track,
+				      GstClockTime lookahead);
+GstClockTime ges_track_get_lookahead (GESTrack * track);
+void         ges_track_move_window   (GESTrack * track,
+				      GstClockTime position);
+
 GESTrack *ges_track_video_raw_new (void);
 GESTrack *ges_track_audio_raw_new (void);
 
@@ -22,12 +22,47 @@
 
 #include <glib-object.h>
 #include <gst/gst.h>
+#include <gst/pbutils/encoding-profile.h>
 #include <ges/ges-types.h>
 
 G_BEGIN_DECLS
 
 GESTimeline * ges_timeline_new_audio_video (void);
 
+void  ges_element_pool_set_max_size (guint size);
+guint ges_element_pool_get_max_size (void);
+void  ges_element_pool_get_stats    (guint64 * n_hits, guint64 * n_misses,
+				     guint * n_idle);
+
+gchar * ges_proxy_cache_get_proxy_uri (const gchar * uri);
+void    ges_proxy_cache_set_directory (const gchar * path);
+
+void    ges_thumbnail_cache_set_directory (const gchar * path);
+void    ges_thumbnail_cache_set_max_size  (guint64 size);
+guint64 ges_thumbnail_cache_get_max_size  (void);
+
+/**
+ * GESRenderProgressFunc:
+ * @segment: the index of the segment
+ * @n_segments: the number of segments
+ * @position: how much of the segment was rendered (in nanoseconds)
+ * @duration: the duration of the segment (in nanoseconds)
+ * @user_data: the data given to ges_timeline_render_parallel()
+ *
+ * Reports the progress of one of the segments of a parallel rendering.
+ */
+typedef void (*GESRenderProgressFunc) (guint segment, guint n_segments,
+				       GstClockTime position,
+				       GstClockTime duration,
+				       gpointer user_data);
+
+gboolean ges_timeline_render_parallel (GESTimeline * timeline,
+				       const gchar * output_uri,
+				       GstEncodingProfile * profile,
+				       guint jobs,
+				       GESRenderProgressFunc progress,
+				       gpointer user_data);
+
 G_END_DECLS
 
 #endif /* _GES_UTILS */
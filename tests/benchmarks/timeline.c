@@ -0,0 +1,229 @@
+/* GStreamer Editing Services
+ * Copyright (C) 2011 The GStreamer Editing Services authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Micro-benchmarks of the timeline bookkeeping.
+ *
+ * Builds synthetic timelines out of GESTimelineTestSource (so that no media
+ * file is needed and nothing gets decoded) in a GESTimelineLayer or a
+ * GESSimpleTimelineLayer, and times adding, moving, changing the priority
+ * of and removing the objects. The timeline is never set to PLAYING, so
+ * this only measures the cost of the layer, object and track code.
+ *
+ * Each run happens in its own process, so that the peak memory usage
+ * reported for it isn't hidden by the bigger runs done before. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <ges/ges.h>
+
+static gint n_ops = 1000;
+
+static void
+report (const gchar * layer_type, guint n_objects, const gchar * workload,
+    guint n, GstClockTime elapsed)
+{
+  g_print ("%-7s %7u objects  %-9s %10.0f ns/op  (%u ops)\n", layer_type,
+      n_objects, workload, n ? (gdouble) elapsed / n : 0.0, n);
+}
+
+/* ru_maxrss is in kilobytes on Linux */
+static glong
+get_peak_rss (void)
+{
+  struct rusage usage;
+
+  if (getrusage (RUSAGE_SELF, &usage) != 0)
+    return 0;
+
+  return usage.ru_maxrss;
+}
+
+static GESTimelineObject *
+make_source (void)
+{
+  GESTimelineObject *object;
+
+  object = (GESTimelineObject *) ges_timeline_test_source_new ();
+  g_object_set (object, "duration", GST_SECOND, NULL);
+
+  return object;
+}
+
+static void
+run_benchmark (gboolean simple, guint n_objects)
+{
+  const gchar *name = simple ? "simple" : "layer";
+  GESTimeline *timeline;
+  GESTimelineLayer *layer;
+  GESTimelineObject **objects;
+  GstClockTime start;
+  guint i, ops = MIN ((guint) MAX (n_ops, 0), n_objects);
+  GRand *rand = g_rand_new_with_seed (42);
+  glong rss = get_peak_rss ();
+
+  timeline = ges_timeline_new ();
+  ges_timeline_add_track (timeline, ges_track_video_raw_new ());
+  ges_timeline_add_track (timeline, ges_track_audio_raw_new ());
+
+  if (simple)
+    layer = (GESTimelineLayer *) ges_simple_timeline_layer_new ();
+  else
+    layer = ges_timeline_layer_new ();
+  ges_timeline_add_layer (timeline, layer);
+
+  objects = g_new (GESTimelineObject *, n_objects);
+  for (i = 0; i < n_objects; i++)
+    objects[i] = make_source ();
+
+  /* Add: append every object at the end of the layer */
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < n_objects; i++) {
+    if (simple) {
+      ges_simple_timeline_layer_add_object ((GESSimpleTimelineLayer *) layer,
+          objects[i], -1);
+    } else {
+      g_object_set (objects[i], "start", (guint64) i * GST_SECOND, NULL);
+      ges_timeline_layer_add_object (layer, objects[i]);
+    }
+  }
+  report (name, n_objects, "add", n_objects,
+      gst_util_get_timestamp () - start);
+
+  /* Move: random objects to random positions */
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < ops; i++) {
+    GESTimelineObject *object = objects[g_rand_int_range (rand, 0, n_objects)];
+    gint position = g_rand_int_range (rand, 0, n_objects);
+
+    if (simple)
+      ges_simple_timeline_layer_move_object ((GESSimpleTimelineLayer *) layer,
+          object, position);
+    else
+      ges_timeline_object_set_start (object, (guint64) position * GST_SECOND);
+  }
+  report (name, n_objects, "move", ops, gst_util_get_timestamp () - start);
+
+  /* Priority: change the priority of random objects */
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < ops; i++) {
+    GESTimelineObject *object = objects[g_rand_int_range (rand, 0, n_objects)];
+
+    ges_timeline_object_set_priority (object, g_rand_int_range (rand, 0, 10));
+  }
+  report (name, n_objects, "priority", ops, gst_util_get_timestamp () - start);
+
+  /* Layer priority: resyncs every object of the layer */
+  start = gst_util_get_timestamp ();
+  ges_timeline_layer_set_priority (layer, 1);
+  report (name, n_objects, "resync", 1, gst_util_get_timestamp () - start);
+
+  /* Remove: every object, in insertion order */
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < n_objects; i++)
+    ges_timeline_layer_remove_object (layer, objects[i]);
+  report (name, n_objects, "remove", n_objects,
+      gst_util_get_timestamp () - start);
+
+  g_print ("peak RSS: +%ld kB\n\n", get_peak_rss () - rss);
+
+  g_free (objects);
+  g_rand_free (rand);
+  g_object_unref (timeline);
+}
+
+/* Runs the benchmark in a child process, the peak RSS of a process never
+ * going down */
+static void
+run_benchmark_process (gboolean simple, guint n_objects)
+{
+  pid_t pid;
+
+  /* Don't let the child print what is still buffered a second time */
+  fflush (stdout);
+
+  pid = fork ();
+  if (pid == 0) {
+    run_benchmark (simple, n_objects);
+    fflush (stdout);
+    _exit (0);
+  } else if (pid < 0) {
+    g_printerr ("Couldn't fork, running in the same process\n");
+    run_benchmark (simple, n_objects);
+  } else
+    waitpid (pid, NULL, 0);
+}
+
+int
+main (int argc, gchar ** argv)
+{
+  GError *err = NULL;
+  GOptionContext *ctx;
+  gchar *sizes = NULL, *layers = NULL, **sizev, **tmp;
+  gboolean do_layer, do_simple;
+  GOptionEntry options[] = {
+    {"sizes", 's', 0, G_OPTION_ARG_STRING, &sizes,
+        "Comma-separated numbers of objects (default:1000,10000,100000)",
+        "sizes"},
+    {"ops", 'o', 0, G_OPTION_ARG_INT, &n_ops,
+        "Number of move and priority operations per run (default:1000)",
+        "ops"},
+    {"layers", 'l', 0, G_OPTION_ARG_STRING, &layers,
+        "Layer types to benchmark: layer, simple or all (default:all)",
+        "type"},
+    {NULL}
+  };
+
+  if (!g_thread_supported ())
+    g_thread_init (NULL);
+
+  ctx = g_option_context_new ("- Benchmarks the GES timeline bookkeeping");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_print ("Error initializing: %s\n", err->message);
+    g_option_context_free (ctx);
+    exit (1);
+  }
+  g_option_context_free (ctx);
+
+  ges_init ();
+
+  do_layer = !layers || !strcmp (layers, "all") || !strcmp (layers, "layer");
+  do_simple = !layers || !strcmp (layers, "all") || !strcmp (layers, "simple");
+
+  sizev = g_strsplit (sizes ? sizes : "1000,10000,100000", ",", -1);
+  for (tmp = sizev; *tmp; tmp++) {
+    guint n_objects = (guint) g_ascii_strtoull (*tmp, NULL, 10);
+
+    if (n_objects == 0)
+      continue;
+
+    if (do_layer)
+      run_benchmark_process (FALSE, n_objects);
+    if (do_simple)
+      run_benchmark_process (TRUE, n_objects);
+  }
+  g_strfreev (sizev);
+
+  return 0;
+}
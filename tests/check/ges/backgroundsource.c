@@ -201,6 +201,88 @@ GST_START_TEST (test_test_source_in_layer)
 
 GST_END_TEST;
 
+static GESTrackObject *
+get_track_object (GESTimelineObject * object)
+{
+  GList *trackobjects;
+  GESTrackObject *trobj;
+
+  trackobjects = ges_timeline_object_get_track_objects (object);
+  fail_unless (trackobjects != NULL);
+  trobj = GES_TRACK_OBJECT (trackobjects->data);
+  g_list_foreach (trackobjects, (GFunc) g_object_unref, NULL);
+  g_list_free (trackobjects);
+
+  return trobj;
+}
+
+GST_START_TEST (test_test_source_recycling)
+{
+  GESTimeline *timeline;
+  GESTimelineLayer *layer;
+  GESTrack *v;
+  GESTimelineTestSource *first, *second;
+  GESTrackObject *trobj;
+  GstElement *element;
+  guint64 hits, misses, hits2, misses2;
+  guint idle;
+  gint pattern;
+
+  ges_init ();
+
+  timeline = ges_timeline_new ();
+  layer = ges_timeline_layer_new ();
+  v = ges_track_video_raw_new ();
+  fail_unless (ges_timeline_add_track (timeline, v));
+  fail_unless (ges_timeline_add_layer (timeline, layer));
+
+  first = ges_timeline_test_source_new ();
+  fail_unless (ges_timeline_layer_add_object (layer,
+          (GESTimelineObject *) first));
+  trobj = get_track_object ((GESTimelineObject *) first);
+  element = ges_track_object_get_element (trobj);
+  fail_unless (element != NULL);
+  gst_object_ref (element);
+
+  /* Removing the object hands its element to the pool */
+  ges_element_pool_get_stats (&hits, &misses, &idle);
+  fail_unless (ges_timeline_layer_remove_object (layer,
+          (GESTimelineObject *) first));
+  ges_element_pool_get_stats (NULL, NULL, &idle);
+  fail_unless (idle >= 1);
+  fail_unless (GST_OBJECT_PARENT (element) == NULL);
+
+  /* The next object of the same type gets it back, with its own settings */
+  second = ges_timeline_test_source_new ();
+  ges_timeline_test_source_set_vpattern (second,
+      GES_VIDEO_TEST_PATTERN_SNOW);
+  fail_unless (ges_timeline_layer_add_object (layer,
+          (GESTimelineObject *) second));
+  trobj = get_track_object ((GESTimelineObject *) second);
+  fail_unless (ges_track_object_get_element (trobj) == element);
+  g_object_get (element, "pattern", &pattern, NULL);
+  assert_equals_int (pattern, GES_VIDEO_TEST_PATTERN_SNOW);
+
+  ges_element_pool_get_stats (&hits2, &misses2, NULL);
+  assert_equals_uint64 (hits2, hits + 1);
+  assert_equals_uint64 (misses2, misses);
+
+  gst_object_unref (element);
+
+  /* A pool of size 0 doesn't keep anything */
+  ges_element_pool_set_max_size (0);
+  ges_element_pool_get_stats (NULL, NULL, &idle);
+  assert_equals_int (idle, 0);
+  fail_unless (ges_timeline_layer_remove_object (layer,
+          (GESTimelineObject *) second));
+  ges_element_pool_get_stats (NULL, NULL, &idle);
+  assert_equals_int (idle, 0);
+
+  g_object_unref (timeline);
+}
+
+GST_END_TEST;
+
 static Suite *
 ges_suite (void)
 {
@@ -212,6 +294,7 @@ ges_suite (void)
   tcase_add_test (tc_chain, test_test_source_basic);
   tcase_add_test (tc_chain, test_test_source_properties);
   tcase_add_test (tc_chain, test_test_source_in_layer);
+  tcase_add_test (tc_chain, test_test_source_recycling);
 
   return s;
 }
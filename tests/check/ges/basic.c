@@ -17,7 +17,10 @@
  * Boston, MA 02111-1307, USA.
  */
 
+#include <string.h>
+#include <glib/gstdio.h>
 #include <ges/ges.h>
+#include <ges/ges-screenshot.h>
 #include <gst/check/gstcheck.h>
 
 GST_START_TEST (test_ges_init)
@@ -553,6 +556,978 @@ GST_START_TEST (test_ges_timeline_remove_track)
 
 GST_END_TEST;
 
+GST_START_TEST (test_ges_timeline_transactions)
+{
+  GESTimeline *timeline;
+  GESTrack *track, *track2;
+
+  ges_init ();
+
+  timeline = ges_timeline_new ();
+  track = ges_track_new (GES_TRACK_TYPE_CUSTOM, GST_CAPS_ANY);
+  fail_unless (ges_timeline_add_track (timeline, track));
+  fail_unless (ges_track_is_updating (track));
+
+  /* Nothing to commit */
+  ASSERT_CRITICAL (fail_if (ges_timeline_commit (timeline)));
+
+  /* Transactions nest, updates resume with the outermost commit */
+  ges_timeline_begin_update (timeline);
+  fail_if (ges_track_is_updating (track));
+  ges_timeline_begin_update (timeline);
+
+  /* Tracks added meanwhile join the transaction */
+  track2 = ges_track_new (GES_TRACK_TYPE_CUSTOM, GST_CAPS_ANY);
+  fail_unless (ges_timeline_add_track (timeline, track2));
+  fail_if (ges_track_is_updating (track2));
+
+  fail_unless (ges_timeline_commit (timeline));
+  fail_if (ges_track_is_updating (track));
+  fail_if (ges_track_is_updating (track2));
+
+  fail_unless (ges_timeline_commit (timeline));
+  fail_unless (ges_track_is_updating (track));
+  fail_unless (ges_track_is_updating (track2));
+
+  g_object_unref (timeline);
+}
+
+GST_END_TEST;
+
+/* A timeline with the tracks of @types, playing @n_sources test sources of
+ * @duration one after the other. @video and @audio, if not %NULL, are set to
+ * its tracks */
+static GESTimeline *
+make_test_timeline (GESTrackType types, guint n_sources,
+    GstClockTime duration, GESTrack ** video, GESTrack ** audio)
+{
+  GESTimeline *timeline = ges_timeline_new ();
+  GESTimelineLayer *layer;
+  GESTimelineObject *source;
+  GESTrack *track;
+  guint i;
+
+  if (types & GES_TRACK_TYPE_VIDEO) {
+    track = ges_track_video_raw_new ();
+    fail_unless (ges_timeline_add_track (timeline, track));
+    if (video)
+      *video = track;
+  }
+  if (types & GES_TRACK_TYPE_AUDIO) {
+    track = ges_track_audio_raw_new ();
+    fail_unless (ges_timeline_add_track (timeline, track));
+    if (audio)
+      *audio = track;
+  }
+
+  layer = (GESTimelineLayer *) ges_simple_timeline_layer_new ();
+  fail_unless (ges_timeline_add_layer (timeline, layer));
+  for (i = 0; i < n_sources; i++) {
+    source = (GESTimelineObject *) ges_timeline_test_source_new ();
+    g_object_set (source, "duration", duration, NULL);
+    fail_unless (ges_timeline_layer_add_object (layer, source));
+  }
+
+  return timeline;
+}
+
+/* A profile muxing into @container a stream of @video and one of @audio,
+ * both being optional */
+static GstEncodingProfile *
+make_profile (const gchar * container, const gchar * video,
+    const gchar * audio)
+{
+  GstEncodingContainerProfile *profile;
+  GstCaps *caps;
+
+  caps = gst_caps_from_string (container);
+  profile = gst_encoding_container_profile_new ("profile", NULL, caps, NULL);
+  gst_caps_unref (caps);
+
+  if (video) {
+    caps = gst_caps_from_string (video);
+    gst_encoding_container_profile_add_profile (profile, (GstEncodingProfile *)
+        gst_encoding_video_profile_new (caps, NULL, NULL, 0));
+    gst_caps_unref (caps);
+  }
+
+  if (audio) {
+    caps = gst_caps_from_string (audio);
+    gst_encoding_container_profile_add_profile (profile, (GstEncodingProfile *)
+        gst_encoding_audio_profile_new (caps, NULL, NULL, 0));
+    gst_caps_unref (caps);
+  }
+
+  return (GstEncodingProfile *) profile;
+}
+
+/* Makes @pipeline render to nowhere with @profile, which is unreffed */
+static void
+render_to_null (GESTimelinePipeline * pipeline, GstEncodingProfile * profile)
+{
+  fail_unless (ges_timeline_pipeline_set_render_settings (pipeline,
+          (gchar *) "file:///dev/null", profile));
+  gst_encoding_profile_unref (profile);
+  fail_unless (ges_timeline_pipeline_set_mode (pipeline,
+          TIMELINE_MODE_RENDER));
+}
+
+/* Makes @pipeline preview into fakesinks */
+static void
+preview_to_fakesinks (GESTimelinePipeline * pipeline)
+{
+  GstElement *playsink;
+
+  fail_unless (ges_timeline_pipeline_set_mode (pipeline,
+          TIMELINE_MODE_PREVIEW));
+  playsink = gst_bin_get_by_name (GST_BIN (pipeline), "internal-sinks");
+  fail_unless (playsink != NULL);
+  g_object_set (playsink, "video-sink",
+      gst_element_factory_make ("fakesink", NULL), "audio-sink",
+      gst_element_factory_make ("fakesink", NULL), NULL);
+  gst_object_unref (playsink);
+}
+
+/* Plays @pipeline until its end */
+static void
+play_until_eos (GstElement * pipeline)
+{
+  GstMessage *message;
+  GstBus *bus;
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  bus = gst_element_get_bus (pipeline);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (GST_MESSAGE_TYPE (message) == GST_MESSAGE_EOS);
+  gst_message_unref (message);
+  gst_object_unref (bus);
+}
+
+/* Encodes a few frames to @filename */
+static void
+make_media_file (const gchar * filename)
+{
+  GstElement *pipeline, *sink;
+
+  pipeline = gst_parse_launch ("videotestsrc num-buffers=10 ! theoraenc ! "
+      "oggmux ! filesink name=sink", NULL);
+  fail_unless (pipeline != NULL);
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_object_set (sink, "location", filename, NULL);
+  gst_object_unref (sink);
+  play_until_eos (pipeline);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+typedef struct
+{
+  GstEventType type;
+  gint count;
+} EventCounter;
+
+/* Counts the events of a type going through a pad, in either direction */
+static gboolean
+count_events_probe (GstPad * pad, GstEvent * event, EventCounter * counter)
+{
+  if (GST_EVENT_TYPE (event) == counter->type)
+    g_atomic_int_inc (&counter->count);
+
+  return TRUE;
+}
+
+GST_START_TEST (test_ges_timeline_late_discovery)
+{
+  GESTimeline *timeline;
+  GESTimelineLayer *layer, *layer2;
+  GESTimelineObject *source;
+  GESTimelineFileSource *filesource;
+  GESTimelinePipeline *pipeline;
+  GstPad *pad;
+  GList *trackobjects;
+  gchar *filename, *uri;
+  EventCounter flushes = { GST_EVENT_FLUSH_START, 0 };
+  guint i;
+
+  ges_init ();
+
+  filename = g_build_filename (g_get_tmp_dir (), "ges-late-discovery.ogg",
+      NULL);
+  make_media_file (filename);
+  uri = g_filename_to_uri (filename, NULL, NULL);
+
+  /* Prerolling doesn't wait for the file source, which is in the same stack
+   * as the test source */
+  timeline = ges_timeline_new ();
+  g_object_set (timeline, "partial-preroll", TRUE, "use-discovery-cache",
+      FALSE, NULL);
+  fail_unless (ges_timeline_add_track (timeline, ges_track_video_raw_new ()));
+  layer = ges_timeline_layer_new ();
+  fail_unless (ges_timeline_add_layer (timeline, layer));
+  source = (GESTimelineObject *) ges_timeline_test_source_new ();
+  g_object_set (source, "duration", 2 * GST_SECOND, NULL);
+  fail_unless (ges_timeline_layer_add_object (layer, source));
+  layer2 = ges_timeline_layer_new ();
+  g_object_set (layer2, "priority", 1, NULL);
+  fail_unless (ges_timeline_add_layer (timeline, layer2));
+  filesource = ges_timeline_filesource_new (uri);
+  g_object_set (filesource, "start", GST_SECOND / 2, "duration",
+      GST_SECOND / 4, NULL);
+  fail_unless (ges_timeline_layer_add_object (layer2,
+          (GESTimelineObject *) filesource));
+
+  pipeline = ges_timeline_pipeline_new ();
+  fail_unless (ges_timeline_pipeline_add_timeline (pipeline, timeline));
+  preview_to_fakesinks (pipeline);
+
+  /* The discovery results are only dispatched from the main context, after
+   * the pipeline prerolled */
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PAUSED);
+  fail_unless (gst_element_get_state (GST_ELEMENT (pipeline), NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless (GST_ELEMENT (timeline)->srcpads != NULL);
+  pad = GST_ELEMENT (timeline)->srcpads->data;
+  gst_pad_add_event_probe (pad, G_CALLBACK (count_events_probe), &flushes);
+
+  for (i = 0; i < 1000 &&
+      ges_timeline_filesource_get_supported_formats (filesource) ==
+      GES_TRACK_TYPE_UNKNOWN; i++) {
+    while (g_main_context_iteration (NULL, FALSE));
+    g_usleep (10000);
+  }
+  fail_if (ges_timeline_filesource_get_supported_formats (filesource) ==
+      GES_TRACK_TYPE_UNKNOWN);
+  while (g_main_context_iteration (NULL, FALSE));
+
+  /* Adding it would change the paused stack: it waits for the next seek */
+  fail_unless (ges_timeline_object_get_track_objects ((GESTimelineObject *)
+          filesource) == NULL);
+  assert_equals_int (g_atomic_int_get (&flushes.count), 0);
+
+  fail_unless (gst_element_seek_simple (GST_ELEMENT (pipeline),
+          GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH, GST_SECOND / 2));
+  fail_unless (gst_element_get_state (GST_ELEMENT (pipeline), NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+  trackobjects = ges_timeline_object_get_track_objects ((GESTimelineObject *)
+      filesource);
+  fail_unless (trackobjects != NULL);
+  g_list_foreach (trackobjects, (GFunc) g_object_unref, NULL);
+  g_list_free (trackobjects);
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  g_unlink (filename);
+  g_free (filename);
+  g_free (uri);
+}
+
+GST_END_TEST;
+
+#define has_contents(trackobject) \
+  (GST_BIN_CHILDREN (ges_track_object_get_gnlobject (trackobject)) != NULL)
+
+GST_START_TEST (test_ges_track_lookahead)
+{
+  GESTimeline *timeline;
+  GESTimelineLayer *layer;
+  GESTrack *track;
+  GESCustomTimelineSource *near, *far;
+  GESTrackObject *tnear, *tfar;
+  GList *trackobjects;
+  gboolean active;
+
+  ges_init ();
+
+  timeline = ges_timeline_new ();
+  layer = ges_timeline_layer_new ();
+  fail_unless (ges_timeline_add_layer (timeline, layer));
+  track = ges_track_new (GES_TRACK_TYPE_CUSTOM, GST_CAPS_ANY);
+  fail_unless (ges_timeline_add_track (timeline, track));
+
+  ges_track_set_lookahead (track, 10 * GST_SECOND);
+  assert_equals_uint64 (ges_track_get_lookahead (track), 10 * GST_SECOND);
+
+  near = ges_custom_timeline_source_new (my_fill_track_func, NULL);
+  far = ges_custom_timeline_source_new (my_fill_track_func, NULL);
+  g_object_set (near, "start", (guint64) 0, "duration", GST_SECOND, NULL);
+  g_object_set (far, "start", 100 * GST_SECOND, "duration", GST_SECOND, NULL);
+  fail_unless (ges_timeline_layer_add_object (layer,
+          (GESTimelineObject *) near));
+  fail_unless (ges_timeline_layer_add_object (layer,
+          (GESTimelineObject *) far));
+
+  trackobjects =
+      ges_timeline_object_get_track_objects ((GESTimelineObject *) near);
+  tnear = GES_TRACK_OBJECT (trackobjects->data);
+  g_list_foreach (trackobjects, (GFunc) g_object_unref, NULL);
+  g_list_free (trackobjects);
+  trackobjects =
+      ges_timeline_object_get_track_objects ((GESTimelineObject *) far);
+  tfar = GES_TRACK_OBJECT (trackobjects->data);
+  g_list_foreach (trackobjects, (GFunc) g_object_unref, NULL);
+  g_list_free (trackobjects);
+
+  /* Only the object close to the position has its contents, the other one
+   * is an inactive placeholder but still looks active from the outside */
+  fail_unless (has_contents (tnear));
+  fail_if (has_contents (tfar));
+  fail_unless (tfar->active);
+  g_object_get (ges_track_object_get_gnlobject (tfar), "active", &active,
+      NULL);
+  fail_if (active);
+  assert_equals_uint64 (GES_TRACK_OBJECT_START (tfar), 100 * GST_SECOND);
+
+  /* Moving the window swaps them */
+  ges_timeline_move_window (timeline, 95 * GST_SECOND);
+  fail_if (has_contents (tnear));
+  fail_unless (has_contents (tfar));
+  g_object_get (ges_track_object_get_gnlobject (tfar), "active", &active,
+      NULL);
+  fail_unless (active);
+
+  /* So does moving the objects */
+  ges_timeline_object_set_start ((GESTimelineObject *) near, 90 * GST_SECOND);
+  ges_timeline_object_set_start ((GESTimelineObject *) far, 0);
+  fail_unless (has_contents (tnear));
+  fail_if (has_contents (tfar));
+
+  /* Disabling the window gives all the objects their contents */
+  ges_track_set_lookahead (track, 0);
+  fail_unless (has_contents (tnear));
+  fail_unless (has_contents (tfar));
+
+  g_object_unref (timeline);
+}
+
+GST_END_TEST;
+
+#define assert_background_duration(bg, value) {                 \
+    guint64 _duration;                                          \
+    g_object_get (bg, "duration", &_duration, NULL);            \
+    assert_equals_uint64 (_duration, value);                    \
+  }
+
+GST_START_TEST (test_ges_track_background)
+{
+  GESTimeline *timeline;
+  GESTimelineLayer *layer;
+  GESTrack *track;
+  GESTimelineObject *first, *last;
+  GstElement *background;
+  guint priority;
+
+  ges_init ();
+
+  timeline = ges_timeline_new ();
+  layer = ges_timeline_layer_new ();
+  fail_unless (ges_timeline_add_layer (timeline, layer));
+  track = ges_track_video_raw_new ();
+  fail_unless (ges_timeline_add_track (timeline, track));
+
+  /* Video tracks have a single background, below everything else */
+  background = gst_bin_get_by_name (GST_BIN (track), "background");
+  fail_unless (background != NULL);
+  g_object_get (background, "priority", &priority, NULL);
+  assert_equals_int (priority, G_MAXUINT32);
+  assert_background_duration (background, 0);
+
+  first = (GESTimelineObject *) ges_timeline_test_source_new ();
+  last = (GESTimelineObject *) ges_timeline_test_source_new ();
+  g_object_set (first, "start", (guint64) 0, "duration", GST_SECOND, NULL);
+  g_object_set (last, "start", 10 * GST_SECOND, "duration", GST_SECOND,
+      NULL);
+  fail_unless (ges_timeline_layer_add_object (layer, first));
+  fail_unless (ges_timeline_layer_add_object (layer, last));
+
+  /* It spans up to the end of the last object, gaps included */
+  assert_background_duration (background, 11 * GST_SECOND);
+
+  ges_timeline_object_set_duration (last, 5 * GST_SECOND);
+  assert_background_duration (background, 15 * GST_SECOND);
+
+  /* Shrinking or removing the last object moves the end back */
+  ges_timeline_object_set_start (last, 0);
+  assert_background_duration (background, 5 * GST_SECOND);
+  ges_timeline_object_set_start (first, 2 * GST_SECOND);
+  assert_background_duration (background, 5 * GST_SECOND);
+  fail_unless (ges_timeline_layer_remove_object (layer, last));
+  assert_background_duration (background, 3 * GST_SECOND);
+
+  gst_object_unref (background);
+  g_object_unref (timeline);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_ges_pipeline_preview_caps)
+{
+  GESTimeline *timeline;
+  GESTimelinePipeline *pipeline;
+  GESTrack *video, *audio;
+  GstCaps *caps, *tmp;
+
+  ges_init ();
+
+  timeline = make_test_timeline (GES_TRACK_TYPE_VIDEO | GES_TRACK_TYPE_AUDIO,
+      0, 0, &video, &audio);
+  fail_unless (ges_track_get_restriction_caps (video) == NULL);
+
+  pipeline = ges_timeline_pipeline_new ();
+  fail_unless (ges_timeline_pipeline_add_timeline (pipeline, timeline));
+
+  /* Previewing restricts the video tracks only */
+  caps = gst_caps_from_string ("video/x-raw-yuv,width=320,height=240");
+  ges_timeline_pipeline_set_preview_caps (pipeline, caps);
+  fail_unless (ges_track_get_restriction_caps (audio) == NULL);
+  g_object_get (video, "restriction-caps", &tmp, NULL);
+  fail_unless (tmp != NULL);
+  fail_unless (gst_caps_is_equal (caps, tmp));
+  gst_caps_unref (tmp);
+
+  /* Rendering goes back to full quality */
+  render_to_null (pipeline, make_profile ("application/ogg", NULL, NULL));
+  fail_unless (ges_track_get_restriction_caps (video) == NULL);
+  fail_unless (ges_timeline_pipeline_set_mode (pipeline,
+          TIMELINE_MODE_PREVIEW));
+  fail_unless (gst_caps_is_equal (caps,
+          ges_track_get_restriction_caps (video)));
+
+  ges_timeline_pipeline_set_preview_caps (pipeline, NULL);
+  fail_unless (ges_track_get_restriction_caps (video) == NULL);
+
+  gst_caps_unref (caps);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_ges_pipeline_thumbnails)
+{
+  GESTimeline *timeline;
+  GESTimelinePipeline *pipeline;
+  GESTrack *audio;
+  GstClockTime positions[] = { 3 * GST_SECOND / 2, 0, GST_SECOND / 2, 0 };
+  GstBuffer **buffers;
+  GstStructure *structure;
+  GstCaps *caps;
+  gint width;
+  guint i;
+
+  ges_init ();
+
+  timeline = make_test_timeline (GES_TRACK_TYPE_VIDEO | GES_TRACK_TYPE_AUDIO,
+      2, GST_SECOND, NULL, &audio);
+
+  pipeline = ges_timeline_pipeline_new ();
+  fail_unless (ges_timeline_pipeline_add_timeline (pipeline, timeline));
+  preview_to_fakesinks (pipeline);
+
+  /* Not possible before the pipeline is paused */
+  fail_unless (ges_timeline_pipeline_get_thumbnails (pipeline, positions, 4,
+          NULL, TRUE) == NULL);
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PAUSED);
+  fail_unless (gst_element_get_state (GST_ELEMENT (pipeline), NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+
+  caps = gst_caps_from_string ("video/x-raw-rgb,width=64,height=48");
+  buffers = ges_timeline_pipeline_get_thumbnails (pipeline, positions, 4,
+      caps, TRUE);
+  gst_caps_unref (caps);
+  fail_unless (buffers != NULL);
+
+  for (i = 0; i < 4; i++) {
+    fail_unless (buffers[i] != NULL);
+    structure = gst_caps_get_structure (GST_BUFFER_CAPS (buffers[i]), 0);
+    fail_unless (gst_structure_has_name (structure, "video/x-raw-rgb"));
+    fail_unless (gst_structure_get_int (structure, "width", &width));
+    assert_equals_int (width, 64);
+  }
+  /* Frames come back in the order of the positions */
+  assert_equals_uint64 (GST_BUFFER_TIMESTAMP (buffers[1]), 0);
+  fail_unless (GST_BUFFER_TIMESTAMP (buffers[2]) > 0);
+  fail_unless (GST_BUFFER_TIMESTAMP (buffers[2]) <= GST_SECOND / 2);
+  fail_unless (GST_BUFFER_TIMESTAMP (buffers[0]) > GST_SECOND);
+  fail_unless (GST_BUFFER_TIMESTAMP (buffers[0]) <= 3 * GST_SECOND / 2);
+  fail_unless (buffers[1] == buffers[3]);
+
+  for (i = 0; i < 4; i++)
+    gst_buffer_unref (buffers[i]);
+  g_free (buffers);
+
+  /* The audio track was only deactivated meanwhile, and the pipeline prerolls
+   * again with it */
+  fail_unless (ges_track_get_active (audio));
+  fail_unless (gst_element_get_state (GST_ELEMENT (pipeline), NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_ges_pipeline_scrubbing)
+{
+  GESTimeline *timeline;
+  GESTimelinePipeline *pipeline;
+  EventCounter seeks = { GST_EVENT_SEEK, 0 };
+  GstFormat format = GST_FORMAT_TIME;
+  GstPad *pad;
+  gint64 position;
+  guint i;
+
+  ges_init ();
+
+  timeline = make_test_timeline (GES_TRACK_TYPE_VIDEO, 1, 2 * GST_SECOND,
+      NULL, NULL);
+
+  pipeline = ges_timeline_pipeline_new ();
+  fail_unless (ges_timeline_pipeline_add_timeline (pipeline, timeline));
+  preview_to_fakesinks (pipeline);
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PAUSED);
+  fail_unless (gst_element_get_state (GST_ELEMENT (pipeline), NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless (GST_ELEMENT (timeline)->srcpads != NULL);
+  pad = GST_ELEMENT (timeline)->srcpads->data;
+  gst_pad_add_event_probe (pad, G_CALLBACK (count_events_probe), &seeks);
+
+  /* Seeks sent while one is in flight are all accepted, the latest one
+   * being sent once the pipeline prerolled */
+  ges_timeline_pipeline_start_scrubbing (pipeline, TRUE);
+  for (i = 1; i <= 20; i++)
+    fail_unless (gst_element_seek_simple (GST_ELEMENT (pipeline),
+            GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE,
+            i * GST_SECOND / 20));
+  for (i = 0; i < 50; i++) {
+    while (g_main_context_iteration (NULL, FALSE));
+    fail_unless (gst_element_get_state (GST_ELEMENT (pipeline), NULL, NULL,
+            GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+    g_usleep (G_USEC_PER_SEC / 100);
+  }
+
+  /* Only the first and the latest of them reached the timeline */
+  fail_unless (g_atomic_int_get (&seeks.count) > 0);
+  fail_unless (g_atomic_int_get (&seeks.count) <= 3, "%d seeks",
+      g_atomic_int_get (&seeks.count));
+
+  /* Releasing the playhead ends on the exact latest position */
+  ges_timeline_pipeline_stop_scrubbing (pipeline);
+  fail_unless (gst_element_get_state (GST_ELEMENT (pipeline), NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless (gst_element_query_position (GST_ELEMENT (pipeline), &format,
+          &position));
+  assert_equals_uint64 (position, GST_SECOND);
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_ges_frame_converter)
+{
+  GESFrameConverter *converter;
+  GstBuffer *frame, *result;
+  GstStructure *structure;
+  GstCaps *caps;
+  gint width, height;
+  guint i;
+
+  ges_init ();
+
+  frame = gst_buffer_new_and_alloc (320 * 240 * 4);
+  memset (GST_BUFFER_DATA (frame), 0x80, GST_BUFFER_SIZE (frame));
+  caps = gst_caps_from_string ("video/x-raw-rgb,bpp=32,depth=24,"
+      "endianness=4321,red_mask=65280,green_mask=16711680,"
+      "blue_mask=-16777216,width=320,height=240,framerate=25/1,"
+      "pixel-aspect-ratio=1/1");
+  gst_buffer_set_caps (frame, caps);
+  gst_caps_unref (caps);
+
+  caps = gst_caps_from_string ("video/x-raw-rgb,bpp=24,depth=24,width=32,"
+      "height=24");
+  converter = ges_frame_converter_new (caps);
+  gst_caps_unref (caps);
+  fail_unless (converter != NULL);
+
+  /* The same converter handles any number of frames */
+  for (i = 0; i < 3; i++) {
+    result = ges_frame_converter_convert (converter, frame);
+    fail_unless (result != NULL);
+    structure = gst_caps_get_structure (GST_BUFFER_CAPS (result), 0);
+    fail_unless (gst_structure_get_int (structure, "width", &width));
+    fail_unless (gst_structure_get_int (structure, "height", &height));
+    assert_equals_int (width, 32);
+    assert_equals_int (height, 24);
+    assert_equals_int (GST_BUFFER_SIZE (result), 32 * 24 * 3);
+    gst_buffer_unref (result);
+  }
+  ges_frame_converter_free (converter);
+
+  /* Image encoders keep encoding after the first frame */
+  caps = gst_caps_from_string ("image/png,width=32,height=24");
+  converter = ges_frame_converter_new (caps);
+  gst_caps_unref (caps);
+  fail_unless (converter != NULL);
+  for (i = 0; i < 3; i++) {
+    result = ges_frame_converter_convert (converter, frame);
+    fail_unless (result != NULL);
+    gst_buffer_unref (result);
+  }
+  ges_frame_converter_free (converter);
+
+  gst_buffer_unref (frame);
+}
+
+GST_END_TEST;
+
+static guint
+count_files (const gchar * path)
+{
+  GDir *dir = g_dir_open (path, 0, NULL);
+  guint n = 0;
+
+  if (dir) {
+    while (g_dir_read_name (dir))
+      n++;
+    g_dir_close (dir);
+  }
+
+  return n;
+}
+
+static void
+remove_files (const gchar * path)
+{
+  GDir *dir = g_dir_open (path, 0, NULL);
+  const gchar *name;
+
+  if (dir) {
+    while ((name = g_dir_read_name (dir))) {
+      gchar *filename = g_build_filename (path, name, NULL);
+
+      g_unlink (filename);
+      g_free (filename);
+    }
+    g_dir_close (dir);
+  }
+  g_rmdir (path);
+}
+
+GST_START_TEST (test_ges_thumbnail_cache)
+{
+  GESTimeline *timeline;
+  GESTimelineLayer *layer;
+  GESTimelineObject *source, *other;
+  GESTimelinePipeline *pipeline;
+  gchar *directory, *location;
+  const gchar *format = "video/x-raw-rgb,bpp=24,depth=24";
+
+  ges_init ();
+
+  directory = g_build_filename (g_get_tmp_dir (), "ges-thumbnail-test", NULL);
+  location = g_build_filename (g_get_tmp_dir (), "ges-thumbnail-test.raw",
+      NULL);
+  remove_files (directory);
+  ges_thumbnail_cache_set_directory (directory);
+
+  timeline = ges_timeline_new ();
+  fail_unless (ges_timeline_add_track (timeline, ges_track_video_raw_new ()));
+  layer = ges_timeline_layer_new ();
+  fail_unless (ges_timeline_add_layer (timeline, layer));
+  source = (GESTimelineObject *) ges_timeline_test_source_new ();
+  g_object_set (source, "duration", GST_SECOND, NULL);
+  fail_unless (ges_timeline_layer_add_object (layer, source));
+
+  pipeline = ges_timeline_pipeline_new ();
+  fail_unless (ges_timeline_pipeline_add_timeline (pipeline, timeline));
+  preview_to_fakesinks (pipeline);
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PAUSED);
+  fail_unless (gst_element_get_state (GST_ELEMENT (pipeline), NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+
+  /* The first time the frame is converted and stored */
+  fail_unless (ges_timeline_pipeline_save_thumbnail_at (pipeline,
+          GST_SECOND / 2, 32, 24, format, location));
+  assert_equals_int (count_files (directory), 1);
+
+  /* Frames grabbed while playing aren't exactly at the position, they are
+   * not stored */
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PLAYING);
+  fail_unless (gst_element_get_state (GST_ELEMENT (pipeline), NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless (ges_timeline_pipeline_save_thumbnail_at (pipeline,
+          GST_SECOND / 4, 32, 24, format, location));
+  assert_equals_int (count_files (directory), 1);
+
+  /* Then it doesn't even need a running pipeline */
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  g_unlink (location);
+  fail_unless (ges_timeline_pipeline_save_thumbnail_at (pipeline,
+          GST_SECOND / 2, 32, 24, format, location));
+  fail_unless (g_file_test (location, G_FILE_TEST_IS_REGULAR));
+
+  /* Edits elsewhere in the timeline keep it valid */
+  other = (GESTimelineObject *) ges_timeline_test_source_new ();
+  g_object_set (other, "start", 2 * GST_SECOND, "duration", GST_SECOND, NULL);
+  fail_unless (ges_timeline_layer_add_object (layer, other));
+  fail_unless (ges_timeline_pipeline_save_thumbnail_at (pipeline,
+          GST_SECOND / 2, 32, 24, format, location));
+
+  /* But not edits of what plays at that position, or another size */
+  g_object_set (source, "vpattern", GES_VIDEO_TEST_PATTERN_SMPTE, NULL);
+  fail_if (ges_timeline_pipeline_save_thumbnail_at (pipeline,
+          GST_SECOND / 2, 32, 24, format, location));
+  g_object_set (source, "vpattern", GES_VIDEO_TEST_PATTERN_BLACK, NULL);
+  fail_unless (ges_timeline_pipeline_save_thumbnail_at (pipeline,
+          GST_SECOND / 2, 32, 24, format, location));
+  fail_if (ges_timeline_pipeline_save_thumbnail_at (pipeline,
+          GST_SECOND / 2, 64, 48, format, location));
+
+  /* The least recently used thumbnails go away when the cache is too big */
+  ges_thumbnail_cache_set_max_size (1);
+  assert_equals_int (count_files (directory), 0);
+  ges_thumbnail_cache_set_max_size (64 * 1024 * 1024);
+
+  gst_object_unref (pipeline);
+  ges_thumbnail_cache_set_directory (NULL);
+  remove_files (directory);
+  g_unlink (location);
+  g_free (location);
+  g_free (directory);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_ges_pipeline_track_activation)
+{
+  GESTimeline *timeline;
+  GESTimelinePipeline *pipeline;
+  GESTrack *video, *audio;
+
+  ges_init ();
+
+  timeline = make_test_timeline (GES_TRACK_TYPE_VIDEO | GES_TRACK_TYPE_AUDIO,
+      1, GST_SECOND, &video, &audio);
+  fail_unless (ges_track_get_active (video));
+  fail_unless (ges_track_get_active (audio));
+
+  pipeline = ges_timeline_pipeline_new ();
+  fail_unless (ges_timeline_pipeline_add_timeline (pipeline, timeline));
+  preview_to_fakesinks (pipeline);
+
+  /* An audio only profile doesn't need the video track */
+  render_to_null (pipeline, make_profile ("application/ogg", NULL,
+          "audio/x-vorbis"));
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PAUSED);
+  fail_unless (gst_element_get_state (GST_ELEMENT (pipeline), NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+  fail_if (ges_track_get_active (video));
+  fail_unless (ges_track_get_active (audio));
+  assert_equals_int (GST_STATE (video), GST_STATE_NULL);
+  assert_equals_int (GST_STATE (audio), GST_STATE_PAUSED);
+  fail_if (GST_ELEMENT (video)->numsrcpads);
+
+  play_until_eos (GST_ELEMENT (pipeline));
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+
+  /* Previewing video only doesn't need the audio track */
+  fail_unless (ges_timeline_pipeline_set_mode (pipeline,
+          TIMELINE_MODE_PREVIEW_VIDEO));
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PAUSED);
+  fail_unless (gst_element_get_state (GST_ELEMENT (pipeline), NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless (ges_track_get_active (video));
+  fail_if (ges_track_get_active (audio));
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+static gboolean
+has_element_of_factory (GstBin * bin, const gchar * name)
+{
+  GstIterator *it = gst_bin_iterate_elements (bin);
+  gboolean done = FALSE, found = FALSE;
+  GstElementFactory *factory;
+  gpointer element;
+
+  while (!done) {
+    switch (gst_iterator_next (it, &element)) {
+      case GST_ITERATOR_OK:
+        /* The timeline has no factory */
+        factory = gst_element_get_factory (element);
+        if (factory && !strcmp (GST_PLUGIN_FEATURE_NAME (factory), name))
+          found = TRUE;
+        gst_object_unref (element);
+        break;
+      case GST_ITERATOR_RESYNC:
+        gst_iterator_resync (it);
+        found = FALSE;
+        break;
+      default:
+        done = TRUE;
+        break;
+    }
+  }
+  gst_iterator_free (it);
+
+  return found;
+}
+
+GST_START_TEST (test_ges_pipeline_render_only)
+{
+  GESTimeline *timeline;
+  GESTimelinePipeline *pipeline;
+  GESTrack *video;
+  GstElement *playsink;
+
+  ges_init ();
+
+  timeline = make_test_timeline (GES_TRACK_TYPE_VIDEO | GES_TRACK_TYPE_AUDIO,
+      1, GST_SECOND, &video, NULL);
+
+  pipeline = ges_timeline_pipeline_new_for_render ();
+  fail_unless (ges_timeline_pipeline_add_timeline (pipeline, timeline));
+  ges_timeline_pipeline_set_render_queue (pipeline, video, 0, 0,
+      GST_SECOND / 2);
+
+  /* Such a pipeline can't preview */
+  fail_if (ges_timeline_pipeline_set_mode (pipeline, TIMELINE_MODE_PREVIEW));
+
+  render_to_null (pipeline, make_profile ("application/ogg",
+          "video/x-theora", "audio/x-vorbis"));
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PAUSED);
+  fail_unless (gst_element_get_state (GST_ELEMENT (pipeline), NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+
+  /* The tracks are queued straight into encodebin */
+  playsink = gst_bin_get_by_name (GST_BIN (pipeline), "internal-sinks");
+  fail_unless (playsink == NULL);
+  fail_if (has_element_of_factory (GST_BIN (pipeline), "tee"));
+  fail_unless (has_element_of_factory (GST_BIN (pipeline), "queue"));
+
+  play_until_eos (GST_ELEMENT (pipeline));
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+/* Checks that @uri plays until its end, @duration */
+static void
+assert_plays_through (const gchar * uri, GstClockTime duration)
+{
+  GstDiscoverer *discoverer;
+  GstDiscovererInfo *info;
+  GstElement *playbin;
+  GstClockTime found;
+
+  discoverer = gst_discoverer_new (10 * GST_SECOND, NULL);
+  fail_unless (discoverer != NULL);
+  info = gst_discoverer_discover_uri (discoverer, uri, NULL);
+  fail_unless (info != NULL);
+  found = gst_discoverer_info_get_duration (info);
+  fail_unless (found + GST_SECOND / 10 >= duration &&
+      found <= duration + GST_SECOND / 10, "duration %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (found));
+  gst_discoverer_info_unref (info);
+  g_object_unref (discoverer);
+
+  playbin = gst_element_factory_make ("playbin2", NULL);
+  fail_unless (playbin != NULL);
+  g_object_set (playbin, "uri", uri, "video-sink",
+      gst_element_factory_make ("fakesink", NULL), "audio-sink",
+      gst_element_factory_make ("fakesink", NULL), NULL);
+  play_until_eos (playbin);
+  gst_element_set_state (playbin, GST_STATE_NULL);
+  gst_object_unref (playbin);
+}
+
+/* Whether some encoder outputs @format */
+static gboolean
+has_encoder (const gchar * format)
+{
+  GList *factories, *encoders;
+  GstCaps *caps = gst_caps_from_string (format);
+  gboolean ret;
+
+  factories = gst_element_factory_list_get_elements
+      (GST_ELEMENT_FACTORY_TYPE_ENCODER | GST_ELEMENT_FACTORY_TYPE_MUXER,
+      GST_RANK_NONE);
+  encoders = gst_element_factory_list_filter (factories, caps, GST_PAD_SRC,
+      FALSE);
+  ret = encoders != NULL;
+  gst_plugin_feature_list_free (encoders);
+  gst_plugin_feature_list_free (factories);
+  gst_caps_unref (caps);
+
+  return ret;
+}
+
+static void
+render_progress_cb (guint segment, guint n_segments, GstClockTime position,
+    GstClockTime duration, guint * max_segment)
+{
+  fail_unless (segment <= n_segments);
+  fail_unless (position <= duration);
+  *max_segment = MAX (*max_segment, segment);
+}
+
+GST_START_TEST (test_ges_render_parallel)
+{
+  GESTimeline *timeline;
+  GstEncodingProfile *profile;
+  gchar *filename, *uri;
+  guint max_segment = 0;
+
+  ges_init ();
+
+  timeline = make_test_timeline (GES_TRACK_TYPE_VIDEO, 4, GST_SECOND / 4,
+      NULL, NULL);
+
+  filename = g_build_filename (g_get_tmp_dir (), "ges-parallel-render",
+      NULL);
+  uri = g_filename_to_uri (filename, NULL, NULL);
+
+  /* Theora streams can't be joined, the timeline is rendered in one go */
+  profile = make_profile ("application/ogg", "video/x-theora", NULL);
+  fail_unless (ges_timeline_render_parallel (timeline, uri, profile, 2,
+          (GESRenderProgressFunc) render_progress_cb, &max_segment));
+  assert_equals_int (max_segment, 0);
+  assert_plays_through (uri, GST_SECOND);
+  gst_encoding_profile_unref (profile);
+  g_unlink (filename);
+
+  /* MPEG-2 in MPEG-TS is split in two at the middle cut, then joined */
+  if (has_encoder ("video/mpegts") &&
+      has_encoder ("video/mpeg,mpegversion=2,systemstream=false")) {
+    profile = make_profile ("video/mpegts",
+        "video/mpeg,mpegversion=(int)2,systemstream=(boolean)false", NULL);
+    fail_unless (ges_timeline_render_parallel (timeline, uri, profile, 2,
+            (GESRenderProgressFunc) render_progress_cb, &max_segment));
+    assert_equals_int (max_segment, 2);
+    assert_plays_through (uri, GST_SECOND);
+    gst_encoding_profile_unref (profile);
+    g_unlink (filename);
+  }
+
+  g_free (filename);
+  g_free (uri);
+  g_object_unref (timeline);
+}
+
+GST_END_TEST;
+
 static Suite *
 ges_suite (void)
 {
@@ -566,6 +1541,18 @@ ges_suite (void)
   tcase_add_test (tc_chain, test_ges_timeline_add_layer);
   tcase_add_test (tc_chain, test_ges_timeline_add_layer_first);
   tcase_add_test (tc_chain, test_ges_timeline_remove_track);
+  tcase_add_test (tc_chain, test_ges_timeline_transactions);
+  tcase_add_test (tc_chain, test_ges_timeline_late_discovery);
+  tcase_add_test (tc_chain, test_ges_track_lookahead);
+  tcase_add_test (tc_chain, test_ges_track_background);
+  tcase_add_test (tc_chain, test_ges_pipeline_preview_caps);
+  tcase_add_test (tc_chain, test_ges_pipeline_thumbnails);
+  tcase_add_test (tc_chain, test_ges_pipeline_scrubbing);
+  tcase_add_test (tc_chain, test_ges_frame_converter);
+  tcase_add_test (tc_chain, test_ges_thumbnail_cache);
+  tcase_add_test (tc_chain, test_ges_pipeline_track_activation);
+  tcase_add_test (tc_chain, test_ges_pipeline_render_only);
+  tcase_add_test (tc_chain, test_ges_render_parallel);
 
   return s;
 }
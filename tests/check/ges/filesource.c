@@ -17,6 +17,7 @@
  * Boston, MA 02111-1307, USA.
  */
 
+#include <glib/gstdio.h>
 #include <ges/ges.h>
 #include <gst/check/gstcheck.h>
 
@@ -183,18 +184,11 @@ GST_START_TEST (test_filesource_images)
   ges_track_remove_object (v, trobj);
   ges_timeline_object_release_track_object (tlobj, trobj);
 
-  /* the timeline object should create an audio test source when the is_image
-   * property is set true */
-
+  /* the timeline object should not create anything for the audio track when
+   * the is_image property is set true, the track fills the gap itself */
   trobj = ges_timeline_object_create_track_object (tlobj, a);
-  fail_unless (GES_IS_TRACK_AUDIO_TEST_SOURCE (trobj));
-
-  /* The track holds a reference to the object
-   * And the timelineobject holds a reference to the object */
-  ASSERT_OBJECT_REFCOUNT (trobj, "Audio Track Object", 2);
-
-  ges_track_remove_object (v, trobj);
-  ges_timeline_object_release_track_object (tlobj, trobj);
+  fail_unless (trobj == NULL);
+  fail_unless (ges_timeline_object_create_track_objects (tlobj, a));
 
 
   g_object_unref (a);
@@ -205,6 +199,170 @@ GST_START_TEST (test_filesource_images)
 GST_END_TEST;
 
 
+#define assert_decoding_caps(trackobject, expected) {                   \
+    GstCaps *_caps, *_expected = gst_caps_from_string (expected);        \
+    g_object_get (ges_track_object_get_element (trackobject), "caps",   \
+        &_caps, NULL);                                                  \
+    fail_unless (gst_caps_is_equal (_caps, _expected));                 \
+    gst_caps_unref (_caps);                                             \
+    gst_caps_unref (_expected);                                         \
+  }
+
+GST_START_TEST (test_filesource_passthrough)
+{
+  GESTrack *track;
+  GESTrackObject *trackobject, *trtrans;
+  GESTimelineObject *object, *transition;
+
+  ges_init ();
+
+  /* What a GESTimelinePipeline sets in smart rendering mode */
+  track = ges_track_new (GES_TRACK_TYPE_VIDEO,
+      gst_caps_from_string ("video/x-theora;video/x-raw-yuv"));
+
+  object = (GESTimelineObject *)
+      ges_timeline_filesource_new ((gchar *)
+      "crack:///there/is/no/way/this/exists");
+  g_object_set (object, "start", (guint64) 0, "duration", 10 * GST_SECOND,
+      "supported-formats", GES_TRACK_TYPE_VIDEO, NULL);
+  trackobject = ges_timeline_object_create_track_object (object, track);
+  fail_unless (trackobject != NULL);
+  fail_unless (ges_track_add_object (track, trackobject));
+
+  /* Nothing plays over the source, it can stay compressed */
+  assert_decoding_caps (trackobject, "video/x-theora;video/x-raw-yuv");
+
+  /* A transition over it forces decoding */
+  transition = (GESTimelineObject *)
+      ges_timeline_standard_transition_new_for_nick ((gchar *) "crossfade");
+  g_object_set (transition, "start", 5 * GST_SECOND, "duration",
+      2 * GST_SECOND, NULL);
+  trtrans = ges_timeline_object_create_track_object (transition, track);
+  fail_unless (trtrans != NULL);
+  fail_unless (ges_track_add_object (track, trtrans));
+  assert_decoding_caps (trackobject, "video/x-raw-yuv");
+
+  /* And moving it away lets it be passed through again */
+  g_object_set (transition, "start", 20 * GST_SECOND, NULL);
+  assert_decoding_caps (trackobject, "video/x-theora;video/x-raw-yuv");
+
+  /* The same goes for the source moving under the transition and back */
+  g_object_set (object, "start", 15 * GST_SECOND, NULL);
+  assert_decoding_caps (trackobject, "video/x-raw-yuv");
+  g_object_set (object, "start", (guint64) 0, NULL);
+  assert_decoding_caps (trackobject, "video/x-theora;video/x-raw-yuv");
+
+  g_object_set (transition, "start", 9 * GST_SECOND, NULL);
+  assert_decoding_caps (trackobject, "video/x-raw-yuv");
+  fail_unless (ges_track_remove_object (track, trtrans));
+  assert_decoding_caps (trackobject, "video/x-theora;video/x-raw-yuv");
+
+  fail_unless (ges_timeline_object_release_track_object (transition,
+          trtrans));
+  fail_unless (ges_track_remove_object (track, trackobject));
+  fail_unless (ges_timeline_object_release_track_object (object,
+          trackobject));
+
+  g_object_unref (transition);
+  g_object_unref (object);
+  g_object_unref (track);
+}
+
+GST_END_TEST;
+
+#define assert_decoding_uri(trackobject, expected) {                    \
+    gchar *_uri;                                                        \
+    g_object_get (ges_track_object_get_element (trackobject), "uri",    \
+        &_uri, NULL);                                                   \
+    fail_unless_equals_string (_uri, expected);                         \
+    g_free (_uri);                                                      \
+  }
+
+GST_START_TEST (test_filesource_proxies)
+{
+  GESTrack *track;
+  GESTrackObject *trackobject;
+  GESTimelineObject *object;
+  GstElement *pipeline, *sink;
+  GstMessage *message;
+  GstBus *bus;
+  gchar *filename, *uri, *directory, *proxy = NULL, *proxy_filename;
+  guint i;
+
+  ges_init ();
+
+  /* A small file to create a proxy of */
+  filename = g_build_filename (g_get_tmp_dir (), "ges-proxy-test.ogg", NULL);
+  uri = g_filename_to_uri (filename, NULL, NULL);
+  pipeline = gst_parse_launch ("videotestsrc num-buffers=10 ! theoraenc ! "
+      "oggmux ! filesink name=sink", NULL);
+  fail_unless (pipeline != NULL);
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_object_set (sink, "location", filename, NULL);
+  gst_object_unref (sink);
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  bus = gst_element_get_bus (pipeline);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (GST_MESSAGE_TYPE (message) == GST_MESSAGE_EOS);
+  gst_message_unref (message);
+  gst_object_unref (bus);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  directory = g_build_filename (g_get_tmp_dir (), "ges-proxy-test", NULL);
+  ges_proxy_cache_set_directory (directory);
+  fail_unless (ges_proxy_cache_get_proxy_uri (uri) == NULL);
+
+  track = ges_track_video_raw_new ();
+
+  object = (GESTimelineObject *) ges_timeline_filesource_new (uri);
+  g_object_set (object, "duration", GST_SECOND / 4, "supported-formats",
+      GES_TRACK_TYPE_VIDEO, NULL);
+  trackobject = ges_timeline_object_create_track_object (object, track);
+  fail_unless (trackobject != NULL);
+  fail_unless (ges_track_add_object (track, trackobject));
+  assert_decoding_uri (trackobject, uri);
+
+  /* Sources which already have their contents get proxies too, the original
+   * being used until the proxy is ready */
+  ges_track_set_use_proxies (track, TRUE);
+  assert_decoding_uri (trackobject, uri);
+  for (i = 0; i < 1000 && proxy == NULL; i++) {
+    while (g_main_context_iteration (NULL, FALSE));
+    if (!(proxy = ges_proxy_cache_get_proxy_uri (uri)))
+      g_usleep (10000);
+  }
+  fail_unless (proxy != NULL);
+  assert_decoding_uri (trackobject, proxy);
+  assert_equals_uint64 (GES_TRACK_OBJECT_DURATION (trackobject),
+      GST_SECOND / 4);
+
+  /* And not used anymore once the track stops using proxies */
+  ges_track_set_use_proxies (track, FALSE);
+  assert_decoding_uri (trackobject, uri);
+
+  fail_unless (ges_track_remove_object (track, trackobject));
+  fail_unless (ges_timeline_object_release_track_object (object,
+          trackobject));
+  g_object_unref (object);
+  g_object_unref (track);
+
+  proxy_filename = g_filename_from_uri (proxy, NULL, NULL);
+  g_unlink (proxy_filename);
+  g_rmdir (directory);
+  g_unlink (filename);
+  ges_proxy_cache_set_directory (NULL);
+
+  g_free (proxy_filename);
+  g_free (proxy);
+  g_free (directory);
+  g_free (filename);
+  g_free (uri);
+}
+
+GST_END_TEST;
+
 static Suite *
 ges_suite (void)
 {
@@ -216,6 +374,8 @@ ges_suite (void)
   tcase_add_test (tc_chain, test_filesource_basic);
   tcase_add_test (tc_chain, test_filesource_images);
   tcase_add_test (tc_chain, test_filesource_properties);
+  tcase_add_test (tc_chain, test_filesource_passthrough);
+  tcase_add_test (tc_chain, test_filesource_proxies);
 
   return s;
 }
@@ -143,6 +143,139 @@ GST_START_TEST (test_layer_properties)
 
 GST_END_TEST;
 
+GST_START_TEST (test_layer_add_objects)
+{
+  GESTimeline *timeline;
+  GESTimelineLayer *layer;
+  GESTrack *track;
+  GESTrackObject *trackobject;
+  GESTimelineObject *objects[3];
+  GList *layer_objects, *tmp;
+  guint64 starts[3] = { 30, 10, 20 };
+  guint64 prev = 0;
+  guint i;
+
+  ges_init ();
+
+  timeline = ges_timeline_new ();
+  layer = (GESTimelineLayer *) ges_timeline_layer_new ();
+  fail_unless (ges_timeline_add_layer (timeline, layer));
+
+  track = ges_track_new (GES_TRACK_TYPE_CUSTOM, GST_CAPS_ANY);
+  fail_unless (track != NULL);
+  fail_unless (ges_timeline_add_track (timeline, track));
+
+  for (i = 0; i < 3; i++) {
+    objects[i] =
+        (GESTimelineObject *) ges_custom_timeline_source_new
+        (my_fill_track_func, NULL);
+    fail_unless (objects[i] != NULL);
+    g_object_set (objects[i], "start", starts[i], "duration", (guint64) 10,
+        NULL);
+  }
+
+  /* Add them all at once, updates should be re-enabled afterwards */
+  fail_unless (ges_timeline_layer_add_objects (layer, objects, 3));
+  fail_unless (ges_track_is_updating (track));
+
+  for (i = 0; i < 3; i++) {
+    fail_if (g_object_is_floating (objects[i]));
+    trackobject = ges_timeline_object_find_track_object (objects[i], track,
+        G_TYPE_NONE);
+    fail_unless (trackobject != NULL);
+    gnl_object_check (ges_track_object_get_gnlobject (trackobject), starts[i],
+        10, 0, 10, 0, TRUE);
+    g_object_unref (trackobject);
+  }
+
+  /* The layer keeps them sorted by start */
+  layer_objects = ges_timeline_layer_get_objects (layer);
+  assert_equals_int (g_list_length (layer_objects), 3);
+  for (tmp = layer_objects; tmp; tmp = tmp->next) {
+    fail_unless (GES_TIMELINE_OBJECT_START (tmp->data) >= prev);
+    prev = GES_TIMELINE_OBJECT_START (tmp->data);
+    g_object_unref (tmp->data);
+  }
+  g_list_free (layer_objects);
+
+  fail_unless (ges_timeline_layer_remove_objects (layer, objects, 3));
+  fail_unless (ges_track_is_updating (track));
+  fail_unless (ges_timeline_layer_get_objects (layer) == NULL);
+
+  fail_unless (ges_timeline_remove_track (timeline, track));
+  fail_unless (ges_timeline_remove_layer (timeline, layer));
+  g_object_unref (timeline);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_layer_objects_in_range)
+{
+  GESTimelineLayer *layer;
+  GESTimelineObject *objects[3];
+  GList *found;
+  guint64 starts[3] = { 0, 5, 20 };
+  guint i;
+
+  ges_init ();
+
+  layer = (GESTimelineLayer *) ges_timeline_layer_new ();
+
+  for (i = 0; i < 3; i++) {
+    objects[i] =
+        (GESTimelineObject *) ges_custom_timeline_source_new
+        (my_fill_track_func, NULL);
+    g_object_set (objects[i], "start", starts[i], "duration", (guint64) 10,
+        NULL);
+    fail_unless (ges_timeline_layer_add_object (layer, objects[i]));
+  }
+
+  /* Objects playing at a given position, sorted by start */
+  found = ges_timeline_layer_get_objects_in_range (layer, 7, 7);
+  assert_equals_int (g_list_length (found), 2);
+  fail_unless (found->data == objects[0]);
+  fail_unless (found->next->data == objects[1]);
+  g_list_foreach (found, (GFunc) g_object_unref, NULL);
+  g_list_free (found);
+
+  /* The end of an object is not included */
+  found = ges_timeline_layer_get_objects_in_range (layer, 15, 19);
+  fail_unless (found == NULL);
+
+  found = ges_timeline_layer_get_objects_in_range (layer, 12, 20);
+  assert_equals_int (g_list_length (found), 2);
+  fail_unless (found->data == objects[1]);
+  fail_unless (found->next->data == objects[2]);
+  g_list_foreach (found, (GFunc) g_object_unref, NULL);
+  g_list_free (found);
+
+  /* Moving an object updates the index */
+  g_object_set (objects[0], "start", (guint64) 40, NULL);
+  found = ges_timeline_layer_get_objects_in_range (layer, 0, 4);
+  fail_unless (found == NULL);
+  found = ges_timeline_layer_get_objects_in_range (layer, 45, 45);
+  assert_equals_int (g_list_length (found), 1);
+  fail_unless (found->data == objects[0]);
+  g_list_foreach (found, (GFunc) g_object_unref, NULL);
+  g_list_free (found);
+
+  g_object_set (objects[2], "duration", (guint64) 100, NULL);
+  found = ges_timeline_layer_get_objects_in_range (layer, 100, 110);
+  assert_equals_int (g_list_length (found), 1);
+  fail_unless (found->data == objects[2]);
+  g_list_foreach (found, (GFunc) g_object_unref, NULL);
+  g_list_free (found);
+
+  /* Removed objects are no longer returned */
+  fail_unless (ges_timeline_layer_remove_object (layer, objects[2]));
+  found = ges_timeline_layer_get_objects_in_range (layer, 100, 110);
+  fail_unless (found == NULL);
+
+  g_object_unref (layer);
+}
+
+GST_END_TEST;
+
 static Suite *
 ges_suite (void)
 {
@@ -152,6 +285,8 @@ ges_suite (void)
   suite_add_tcase (s, tc_chain);
 
   tcase_add_test (tc_chain, test_layer_properties);
+  tcase_add_test (tc_chain, test_layer_add_objects);
+  tcase_add_test (tc_chain, test_layer_objects_in_range);
 
   return s;
 }
@@ -193,6 +193,66 @@ GST_START_TEST (test_object_properties_unlocked)
 }
 
 GST_END_TEST;
+
+static void
+count_notify_cb (GObject * object, GParamSpec * pspec, guint * count)
+{
+  (*count)++;
+}
+
+GST_START_TEST (test_object_set_timing)
+{
+  GESTrack *track;
+  GESTrackObject *trackobject;
+  GESTimelineObject *object;
+  guint count = 0;
+
+  ges_init ();
+
+  track = ges_track_new (GES_TRACK_TYPE_CUSTOM, GST_CAPS_ANY);
+  fail_unless (track != NULL);
+
+  object =
+      (GESTimelineObject *) ges_custom_timeline_source_new (my_fill_track_func,
+      NULL);
+  fail_unless (object != NULL);
+
+  trackobject = ges_timeline_object_create_track_object (object, track);
+  fail_unless (trackobject != NULL);
+  fail_unless (ges_track_object_set_track (trackobject, track));
+
+  g_signal_connect (trackobject, "notify::start",
+      G_CALLBACK (count_notify_cb), &count);
+  g_signal_connect (trackobject, "notify::duration",
+      G_CALLBACK (count_notify_cb), &count);
+
+  /* All the values are applied at once */
+  ges_timeline_object_set_timing (object, 42, 12, 51, 3);
+  assert_equals_uint64 (GES_TIMELINE_OBJECT_START (object), 42);
+  assert_equals_uint64 (GES_TIMELINE_OBJECT_INPOINT (object), 12);
+  assert_equals_uint64 (GES_TIMELINE_OBJECT_DURATION (object), 51);
+  assert_equals_uint64 (GES_TIMELINE_OBJECT_PRIORITY (object), 3);
+  assert_equals_uint64 (GES_TRACK_OBJECT_START (trackobject), 42);
+  assert_equals_uint64 (GES_TRACK_OBJECT_INPOINT (trackobject), 12);
+  assert_equals_uint64 (GES_TRACK_OBJECT_DURATION (trackobject), 51);
+  gnl_object_check (ges_track_object_get_gnlobject (trackobject), 42, 51, 12,
+      51, 3, TRUE);
+  assert_equals_int (count, 2);
+
+  /* Unchanged values aren't notified again */
+  ges_timeline_object_set_timing (object, 42, 12, 60, 3);
+  gnl_object_check (ges_track_object_get_gnlobject (trackobject), 42, 60, 12,
+      60, 3, TRUE);
+  assert_equals_int (count, 3);
+
+  ges_timeline_object_release_track_object (object, trackobject);
+
+  g_object_unref (object);
+  g_object_unref (track);
+}
+
+GST_END_TEST;
+
 static Suite *
 ges_suite (void)
 {
@@ -203,6 +263,7 @@ ges_suite (void)
 
   tcase_add_test (tc_chain, test_object_properties);
   tcase_add_test (tc_chain, test_object_properties_unlocked);
+  tcase_add_test (tc_chain, test_object_set_timing);
 
   return s;
 }
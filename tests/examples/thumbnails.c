@@ -41,9 +41,11 @@ static gboolean thumbnail_cb (gpointer pipeline);
 static gboolean
 thumbnail_cb (gpointer user)
 {
-  GstBuffer *b = NULL;
-  GstCaps *caps;
+  GstBuffer *b = NULL, **filmstrip;
+  GstClockTime positions[10];
+  GstCaps *caps, *rgbcaps;
   GESTimelinePipeline *p;
+  guint i;
 
   p = GES_TIMELINE_PIPELINE (user);
 
@@ -61,6 +63,20 @@ thumbnail_cb (gpointer user)
   g_assert (b);
   gst_buffer_unref (b);
 
+  /* check filmstrip use-case, one small frame per second */
+  for (i = 0; i < 10; i++)
+    positions[i] = i * GST_SECOND;
+  rgbcaps = gst_caps_from_string ("video/x-raw-rgb,width=160,height=120");
+  filmstrip = ges_timeline_pipeline_get_thumbnails (p, positions, 10, rgbcaps,
+      FALSE);
+  gst_caps_unref (rgbcaps);
+  g_assert (filmstrip);
+  for (i = 0; i < 10; i++) {
+    g_assert (filmstrip[i]);
+    gst_buffer_unref (filmstrip[i]);
+  }
+  g_free (filmstrip);
+
   g_assert (ges_timeline_pipeline_save_thumbnail (p, -1, -1, (gchar *)
           "image/jpeg", (gchar *) TEST_PATH));
   g_assert (g_file_test (TEST_PATH, G_FILE_TEST_EXISTS));
@@ -253,7 +253,8 @@ create_timeline (int nbargs, gchar ** argv)
 }
 
 static GESTimelinePipeline *
-create_pipeline (gchar * load_path, gchar * save_path, int argc, char **argv)
+create_pipeline (gchar * load_path, gchar * save_path, int argc, char **argv,
+    gboolean render_only, GESTimeline ** out_timeline)
 {
   GESTimelinePipeline *pipeline;
   GESTimeline *timeline;
@@ -296,17 +297,39 @@ create_pipeline (gchar * load_path, gchar * save_path, int argc, char **argv)
   }
 
   /* In order to view our timeline, let's grab a convenience pipeline to put
-   * our timeline in. */
+   * our timeline in. Rendering doesn't need anything to preview it. */
 
-  pipeline = ges_timeline_pipeline_new ();
+  if (render_only)
+    pipeline = ges_timeline_pipeline_new_for_render ();
+  else
+    pipeline = ges_timeline_pipeline_new ();
 
   /* Add the timeline to that pipeline */
   if (!ges_timeline_pipeline_add_timeline (pipeline, timeline))
     return NULL;
 
+  *out_timeline = timeline;
+
   return pipeline;
 }
 
+static void
+render_progress_cb (guint segment, guint n_segments, GstClockTime position,
+    GstClockTime duration, guint * percents)
+{
+  guint percent = duration ? gst_util_uint64_scale (position, 100,
+      duration) : 100;
+
+  if (percent == percents[segment])
+    return;
+  percents[segment] = percent;
+
+  if (segment == n_segments)
+    g_print ("joining: %u%%\n", percent);
+  else
+    g_print ("segment %u/%u: %u%%\n", segment + 1, n_segments, percent);
+}
+
 static void
 bus_message_cb (GstBus * bus, GstMessage * message, GMainLoop * mainloop)
 {
@@ -383,6 +406,10 @@ main (int argc, gchar ** argv)
   gchar *audio = (gchar *) "audio/x-vorbis";
   gchar *video = (gchar *) "video/x-theora";
   gchar *video_restriction = (gchar *) "ANY";
+  gchar *preview_caps = NULL;
+  static gint jobs = 1;
+  static gboolean proxies = FALSE;
+  GESTimeline *timeline;
   static gboolean render = FALSE;
   static gboolean smartrender = FALSE;
   static gboolean list_transitions = FALSE;
@@ -408,6 +435,12 @@ main (int argc, gchar ** argv)
         "Audio format", "<GstCaps>"},
     {"vrestriction", 'x', 0, G_OPTION_ARG_STRING, &video_restriction,
         "Video restriction", "<GstCaps>"},
+    {"preview-caps", 'w', 0, G_OPTION_ARG_STRING, &preview_caps,
+        "Preview video in a smaller format", "<GstCaps>"},
+    {"proxies", 'P', 0, G_OPTION_ARG_NONE, &proxies,
+        "Preview files from low resolution proxies once they are ready", NULL},
+    {"jobs", 'j', 0, G_OPTION_ARG_INT, &jobs,
+        "Number of segments rendered in parallel (default:1)", "N"},
     {"repeat", 'l', 0, G_OPTION_ARG_INT, &repeat,
         "Number of time to repeat timeline", NULL},
     {"list-transitions", 't', 0, G_OPTION_ARG_NONE, &list_transitions,
@@ -476,7 +509,8 @@ main (int argc, gchar ** argv)
   g_option_context_free (ctx);
 
   /* Create the pipeline */
-  pipeline = create_pipeline (load_path, save_path, argc - 1, argv + 1);
+  pipeline = create_pipeline (load_path, save_path, argc - 1, argv + 1,
+      render || smartrender, &timeline);
   if (!pipeline)
     exit (1);
 
@@ -486,6 +520,23 @@ main (int argc, gchar ** argv)
 
     prof = make_encoding_profile (audio, video, video_restriction, container);
 
+    if (prof && render && jobs > 1) {
+      guint *percents = g_new0 (guint, jobs + 1);
+      gboolean ret;
+
+      /* Each segment gets its own pipeline, ours is only used to hold the
+       * timeline */
+      ret = ges_timeline_render_parallel (timeline, outputuri, prof, jobs,
+          (GESRenderProgressFunc) render_progress_cb, percents);
+
+      g_free (percents);
+      gst_encoding_profile_unref (prof);
+      gst_object_unref (pipeline);
+      g_print ("%s\n", ret ? "Done" : "ERROR");
+
+      return ret ? 0 : 1;
+    }
+
     if (!prof ||
         !ges_timeline_pipeline_set_render_settings (pipeline, outputuri, prof)
         || !ges_timeline_pipeline_set_mode (pipeline,
@@ -495,6 +546,17 @@ main (int argc, gchar ** argv)
     g_free (outputuri);
     gst_encoding_profile_unref (prof);
   } else {
+    if (preview_caps) {
+      GstCaps *caps = gst_caps_from_string (preview_caps);
+
+      if (!caps) {
+        g_printerr ("Invalid preview caps: %s\n", preview_caps);
+        exit (1);
+      }
+      ges_timeline_pipeline_set_preview_caps (pipeline, caps);
+      gst_caps_unref (caps);
+    }
+    ges_timeline_pipeline_set_use_proxies (pipeline, proxies);
     ges_timeline_pipeline_set_mode (pipeline, TIMELINE_MODE_PREVIEW);
   }
 